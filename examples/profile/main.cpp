@@ -40,10 +40,11 @@ struct typeName<ObjectArray> {
 
 TextPrinter tout;
 
-bool unit_test ( const string & fn, bool useAOT ) {
+bool unit_test_with_engine ( const string & fn, bool useAOT, bool useBytecode ) {
     // make sure there is no stack
     CodeOfPolicies policies;
     policies.stack = 0;
+    policies.bytecode_engine = useBytecode;
     auto access = make_smart<FsFileAccess>();
     ModuleGroup dummyGroup;
     if ( auto program = compileDaScript(fn,access,tout,dummyGroup,false,policies) ) {
@@ -105,6 +106,15 @@ bool unit_test ( const string & fn, bool useAOT ) {
     }
 }
 
+bool unit_test ( const string & fn, bool useAOT ) {
+    return unit_test_with_engine(fn, useAOT, false);
+}
+
+// same tests, only functions which fit the register bytecode run on it instead of the tree interpreter
+bool unit_test_bytecode ( const string & fn, bool useAOT ) {
+    return unit_test_with_engine(fn, useAOT, true);
+}
+
 bool run_tests( const string & path, bool (*test_fn)(const string &, bool aot), bool useAot ) {
     vector<string> files;
 #ifdef _MSC_VER
@@ -153,6 +163,12 @@ int main( int argc, char * argv[] ) {
     NEED_MODULE(Module_Strings);
     NEED_MODULE(Module_TestProfile);
     NEED_MODULE(Module_Random);
+    NEED_MODULE(Module_Rtti);
+    NEED_MODULE(Module_Ast);
+    NEED_MODULE(Module_FIO);
+    NEED_MODULE(Module_JsonNative);
+    NEED_MODULE(Module_RegexNative);
+    NEED_MODULE(Module_JobQue);
     Module::Initialize();
 #if 0
     auto TEST_NAME = getDasRoot() +  "/examples/profile/tests/nbodies.das";
@@ -167,6 +183,8 @@ int main( int argc, char * argv[] ) {
     if (argc == 1) {
         tout << "\nINTERPRETED:\n";
         run_tests(getDasRoot() + "/examples/profile/tests", unit_test, false);
+        tout << "\nBYTECODE:\n";
+        run_tests(getDasRoot() + "/examples/profile/tests", unit_test_bytecode, false);
         tout << "\nAOT:\n";
         run_tests(getDasRoot() + "/examples/profile/tests", unit_test, true);
     }
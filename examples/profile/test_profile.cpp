@@ -1000,6 +1000,13 @@ public:
         addExtern<DAS_BIND_FUN(testNBodies)>(*this, lib, "testNBodies",SideEffects::modifyExternal,"testNBodies");
         addExtern<DAS_BIND_FUN(testNBodiesS)>(*this, lib, "testNBodiesS",SideEffects::modifyExternal,"testNBodiesS");
         addExtern<DAS_BIND_FUN(testTree)>(*this, lib, "testTree",SideEffects::modifyExternal,"testTree");
+        // job que
+        addExtern<DAS_BIND_FUN(testWithContentionQue)>(*this, lib, "testWithContentionQue",SideEffects::modifyExternal,"testWithContentionQue");
+        addExtern<DAS_BIND_FUN(testJobQueContention)>(*this, lib, "testJobQueContention",SideEffects::modifyExternal,"testJobQueContention");
+        addExtern<DAS_BIND_FUN(testCompileColdStart)>(*this, lib, "testCompileColdStart",SideEffects::modifyExternal,"testCompileColdStart");
+        addExtern<DAS_BIND_FUN(testProgramSetup)>(*this, lib, "testProgramSetup",SideEffects::modifyExternal,"testProgramSetup");
+        addExtern<DAS_BIND_FUN(testSimulateThreads)>(*this, lib, "testSimulateThreads",SideEffects::modifyExternal,"testSimulateThreads");
+        addExtern<DAS_BIND_FUN(testAllocationTrace)>(*this, lib, "testAllocationTrace",SideEffects::modifyExternal,"testAllocationTrace");
         // its AOT ready
         verifyAotReady();
     }
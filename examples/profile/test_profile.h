@@ -43,6 +43,12 @@ void testParticlesI(int count);
 int testPrimes(int n);
 void testTryCatch(das::Context * context);
 int testTree();
+void testWithContentionQue(int threadCount, bool fifo, const das::TBlock<void,void *> & blk, das::Context * context);
+int testJobQueContention(void * que, int totalJobs);
+bool testCompileColdStart(const char * fileName, int32_t threads);
+bool testProgramSetup(const char * text, int32_t count);
+bool testSimulateThreads(const char * fileName, int32_t threads, int32_t count);
+uint32_t testAllocationTrace(int totalAllocations, int liveSet, bool legacy);
 
 void testManagedInt(const das::TBlock<void, const das::vector<int32_t>> & blk, das::Context * context);
 
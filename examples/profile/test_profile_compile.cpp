@@ -0,0 +1,51 @@
+#include "daScript/misc/platform.h"
+
+#include "test_profile.h"
+
+#include "daScript/daScript.h"
+
+using namespace das;
+
+// every run starts with the empty file access, so that all the sources of the require graph are read from disk again
+bool testCompileColdStart ( const char * fileName, int32_t threads ) {
+    auto fAccess = make_smart<FsFileAccess>();
+    ModuleGroup dummyLibGroup;
+    CodeOfPolicies policies;
+    policies.compile_threads = uint32_t(threads);
+    TextWriter tout;
+    auto program = compileDaScript(getDasRoot() + "/" + (fileName ? fileName : ""), fAccess, tout, dummyLibGroup, false, policies);
+    return program && !program->failed();
+}
+
+// compiles and simulates the same small program from memory over and over. the program itself is next to nothing,
+// so what is measured is the per program setup - the builtin modules it links against, symbol use, stack and simulate
+bool testProgramSetup ( const char * text, int32_t count ) {
+    auto fAccess = make_smart<FileAccess>();
+    auto source = string(text ? text : "");
+    fAccess->setFileInfo("setup.das", make_unique<FileInfo>(source.c_str(), uint32_t(source.length()+1)));
+    for ( int32_t i=0; i!=count; ++i ) {
+        ModuleGroup dummyLibGroup;
+        TextWriter tout;
+        auto program = compileDaScript("setup.das", fAccess, tout, dummyLibGroup, false);
+        if ( !program || program->failed() ) return false;
+        Context ctx(program->getContextStackSize());
+        if ( !program->simulate(ctx, tout) ) return false;
+    }
+    return true;
+}
+
+// compiles once, with everything exported so that there is plenty to simulate. then simulates it over and over,
+// with threads>1 the functions are fused in parallel
+bool testSimulateThreads ( const char * fileName, int32_t threads, int32_t count ) {
+    auto fAccess = make_smart<FsFileAccess>();
+    ModuleGroup dummyLibGroup;
+    TextWriter tout;
+    auto program = compileDaScript(getDasRoot() + "/" + (fileName ? fileName : ""), fAccess, tout, dummyLibGroup, true);
+    if ( !program || program->failed() ) return false;
+    program->policies.compile_threads = uint32_t(threads);
+    for ( int32_t i=0; i!=count; ++i ) {
+        Context ctx(program->getContextStackSize());
+        if ( !program->simulate(ctx, tout) ) return false;
+    }
+    return true;
+}
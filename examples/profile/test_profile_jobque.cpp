@@ -0,0 +1,122 @@
+#include "daScript/misc/platform.h"
+
+#include "test_profile.h"
+
+#include "daScript/misc/job_que.h"
+
+using namespace das;
+
+// single mutex guarded fifo with priority insert, the scheduler before work stealing, as the contention baseline for testJobQueContention
+class FifoJobQue {
+public:
+    FifoJobQue ( int threadCount ) : mShutdown(false), mJobsRunning(0) {
+        for ( int j=0; j!=threadCount; ++j ) {
+            mThreads.emplace_back([=](){ job(); });
+        }
+    }
+    ~FifoJobQue () {
+        mShutdown = true;
+        for ( auto & th : mThreads ) {
+            th.join();
+        }
+    }
+    void push ( Job && job, JobPriority priority ) {
+        lock_guard<mutex> lock(mFifoMutex);
+        auto it = lower_bound(mFifo.begin(), mFifo.end(), priority, [](const JobEntry & lhs, JobPriority priority) {
+            return lhs.priority >= priority; });
+        mFifo.emplace(it, JobEntry{move(job), priority});
+        mCond.notify_one();
+    }
+    void wait() {
+        for ( ;; ) {
+            {
+                lock_guard<mutex> lock(mFifoMutex);
+                if ( mJobsRunning==0 && mFifo.empty() ) break;
+            }
+            this_thread::yield();
+        }
+    }
+protected:
+    void job() {
+        while ( !mShutdown ) {
+            Job job;
+            {
+                unique_lock<mutex> lock(mFifoMutex);
+                if ( mCond.wait_for(lock, chrono::milliseconds(0), [&]() { return mFifo.size() != 0; }) ) {
+                    job = move(mFifo.front().function);
+                    mFifo.pop_front();
+                    mJobsRunning++;
+                } else {
+                    continue;
+                }
+            }
+            job();
+            {
+                unique_lock<mutex> lock(mFifoMutex);
+                mJobsRunning--;
+            }
+        }
+    }
+protected:
+    struct JobEntry {
+        Job         function;
+        JobPriority priority;
+    };
+    mutex               mFifoMutex;
+    condition_variable  mCond;
+    deque<JobEntry>     mFifo;
+    vector<thread>      mThreads;
+    atomic<bool>        mShutdown;
+    atomic<int>         mJobsRunning;
+};
+
+// every root job fans out into leaf jobs, which is where new_job and parallel_for contend the most
+template <typename QUE>
+int jobQueFanOut ( QUE & que, int totalJobs ) {
+    const int fanOut = 16;
+    atomic<int> done(0);
+    int roots = max(totalJobs / fanOut, 1);
+    for ( int r=0; r!=roots; ++r ) {
+        que.push([&](){
+            for ( int l=0; l!=fanOut; ++l ) {
+                que.push([&](){ done++; }, 0, JobPriority::Default);
+            }
+        }, 0, JobPriority::Default);
+    }
+    que.wait();
+    return done;
+}
+
+struct FifoJobQueAdapter {
+    FifoJobQue & que;
+    void push ( Job && job, JobCategory, JobPriority priority ) { que.push(move(job), priority); }
+    void wait() { que.wait(); }
+};
+
+// que is created once, outside of the timed block. threads start and join there, the block only times the pushes, the steals and wait()
+struct ContentionQue {
+    unique_ptr<JobQue>      jobQue;
+    unique_ptr<FifoJobQue>  fifoQue;
+};
+
+void testWithContentionQue ( int threadCount, bool fifo, const TBlock<void,void *> & blk, Context * context ) {
+    ContentionQue que;
+    if ( fifo ) {
+        que.fifoQue = make_unique<FifoJobQue>(threadCount);
+    } else {
+        que.jobQue = make_unique<JobQue>(threadCount);
+    }
+    vec4f args[1];
+    args[0] = cast<void *>::from(&que);
+    context->invoke(blk, args, nullptr);
+}
+
+int testJobQueContention ( void * que, int totalJobs ) {
+    auto cque = (ContentionQue *) que;
+    if ( cque->fifoQue ) {
+        FifoJobQueAdapter adapter = { *cque->fifoQue };
+        return jobQueFanOut(adapter, totalJobs);
+    } else {
+        return jobQueFanOut(*cque->jobQue, totalJobs);
+    }
+}
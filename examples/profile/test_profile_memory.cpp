@@ -0,0 +1,131 @@
+#include "daScript/misc/platform.h"
+
+#include "test_profile.h"
+
+#include "daScript/misc/memory_model.h"
+
+using namespace das;
+
+// small allocation deck without free lists or page lookup (bit scan on allocate, deck walk on free), replays the same traces as MemoryModel
+struct LegacyDeck {
+    LegacyDeck( uint32_t ne, uint32_t es, LegacyDeck * n ) {
+        total = (ne+31) & ~31;
+        size = es;
+        totalBytes = total * size;
+        data = (char*) das_aligned_alloc16(totalBytes);
+        bits = (uint32_t*) das_aligned_alloc16(total / 32 * 4);
+        memset ( bits, 0, total / 32 * 4);
+        next = n;
+    }
+    ~LegacyDeck ( ) {
+        das_aligned_free16(data);
+        das_aligned_free16(bits);
+        if ( next ) delete next;
+    }
+    __forceinline bool isOwnPtr ( char * ptr ) const {
+        return (ptr>=data) && (ptr<data+totalBytes);
+    }
+    __forceinline char * allocate ( ) {
+        if ( allocated == total ) return nullptr;
+        uint32_t maxt = total / 32;
+        for ( uint32_t t=0; t!=maxt; ++t ) {
+            uint32_t b = bits[look];
+            uint32_t nb = ~b;
+            if ( nb ) {
+                uint32_t j = 31 - __builtin_clz(nb);
+                bits[look] = b | (1u<<j);
+                allocated ++;
+                return data + (look * 32 + j) * size;
+            }
+            look = look + 1;
+            if ( look == maxt ) look = 0;
+        }
+        return nullptr;
+    }
+    __forceinline void free ( char * ptr ) {
+        uint32_t uidx = uint32_t((ptr - data) / size);
+        uint32_t i = uidx >> 5;
+        bits[i] ^= 1u << (uidx & 31);
+        look = i;
+        allocated --;
+    }
+    char *      data = nullptr;
+    uint32_t *  bits = nullptr;
+    uint32_t    total = 0;
+    uint32_t    size = 0;
+    uint32_t    totalBytes = 0;
+    uint32_t    look = 0;
+    uint32_t    allocated = 0;
+    LegacyDeck * next = nullptr;
+};
+
+struct LegacyMemoryModel {
+    LegacyMemoryModel() {
+        for ( auto & ch : chunks ) ch = nullptr;
+    }
+    ~LegacyMemoryModel() {
+        for ( auto & ch : chunks ) if ( ch ) delete ch;
+    }
+    char * allocate ( uint32_t size ) {
+        size = (size + 15) & ~15;
+        uint32_t si = (size >> 4) - 1;
+        for ( auto ch = chunks[si]; ch; ch=ch->next ) {
+            if ( char * res = ch->allocate() ) {
+                return res;
+            }
+        }
+        uint32_t total = chunks[si] ? chunks[si]->total * 2 : MemoryModel::default_initial_size / size;
+        chunks[si] = new LegacyDeck(total, size, chunks[si]);
+        return chunks[si]->allocate();
+    }
+    void free ( char * ptr, uint32_t size ) {
+        size = (size + 15) & ~15;
+        uint32_t si = (size >> 4) - 1;
+        for ( auto ch = chunks[si]; ch; ch=ch->next ) {
+            if ( ch->isOwnPtr(ptr) ) {
+                ch->free(ptr);
+                return;
+            }
+        }
+    }
+    LegacyDeck * chunks[DAS_MAX_SHOE_CUNKS];
+};
+
+// script heaps are mostly small structures, closures and array headers, which are allocated in bursts
+// and released in roughly random order. the live set grows first, then churns at a steady size
+template <typename MODEL>
+uint32_t allocationTrace ( MODEL & model, int totalAllocations, int liveSet ) {
+    struct Allocation { char * ptr; uint32_t size; };
+    vector<Allocation> live;
+    live.reserve(liveSet);
+    uint32_t seed = 13, checksum = 0;
+    auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for ( int i=0; i!=totalAllocations; ++i ) {
+        if ( int(live.size())==liveSet ) {
+            auto victim = rnd() % live.size();
+            model.free(live[victim].ptr, live[victim].size);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        uint32_t r = rnd() % 100;
+        uint32_t size = r<60 ? 16 + (r&1)*16 : (r<90 ? 48 + (r%3)*16 : 96 + (r%10)*16);
+        char * ptr = model.allocate(size);
+        *ptr = char(i);
+        checksum += uint8_t(*ptr);
+        live.push_back({ptr,size});
+    }
+    for ( auto & a : live ) {
+        model.free(a.ptr, a.size);
+    }
+    return checksum;
+}
+
+uint32_t testAllocationTrace ( int totalAllocations, int liveSet, bool legacy ) {
+    if ( legacy ) {
+        LegacyMemoryModel model;
+        return allocationTrace(model, totalAllocations, liveSet);
+    } else {
+        MemoryModel model;
+        return allocationTrace(model, totalAllocations, liveSet);
+    }
+}
@@ -11,6 +11,8 @@
 #include "daScript/ast/ast_typedecl.h"
 #include "daScript/simulate/aot_library.h"
 
+#include <mutex>
+
 namespace das
 {
     class Function;
@@ -42,6 +44,8 @@ namespace das
 
     struct AnnotationArgumentList;
 
+    struct CodeOfPolicies;
+
     //      [annotation (value,value,...,value)]
     //  or  [annotation (key=value,key,value,...,key=value)]
     struct AnnotationArgument {
@@ -787,7 +791,8 @@ namespace das
     class Module {
     public:
         Module ( const string & n = "" );
-        void promoteToBuiltin(const FileAccessPtr & access);
+        void promoteToBuiltin(const FileAccessPtr & access, const string & fileName, const CodeOfPolicies & policies);
+        bool isPromotedUpToDate(const FileAccessPtr & access, const CodeOfPolicies & policies) const;
         virtual ~Module();
         virtual void addPrerequisits ( ModuleLibrary & ) const {}
         virtual ModuleAotType aotRequire ( TextWriter & ) const { return ModuleAotType::no_aot; }
@@ -819,6 +824,7 @@ namespace das
         static Module * requireEx ( const string & name, bool allowPromoted );
         static void Initialize();
         static void Shutdown();
+        static void removeStalePromoted ( const string & name, const FileAccessPtr & access, const CodeOfPolicies & policies );
         static TypeAnnotation * resolveAnnotation ( const TypeInfo * info );
         static Type findOption ( const string & name );
         static void foreach(const callable<bool(Module * module)> & func);
@@ -826,6 +832,8 @@ namespace das
         void verifyAotReady();
         void verifyBuiltinNames(uint32_t flags);
         void addDependency ( Module * mod, bool pub );
+        const vector<FunctionPtr> & scriptFunctions() const;    // functions, minus the ones bound from c++
+        void invalidateScriptFunctions();
     public:
         template <typename RecAnn>
         void initRecAnnotation ( const smart_ptr<RecAnn> & rec, ModuleLibrary & lib ) {
@@ -887,6 +895,12 @@ namespace das
         static Module * modules;
         unique_ptr<FileInfo>    ownFileInfo;
         FileAccessPtr           promotedAccess;
+        string                  promotedFileName;
+        uint64_t                promotedSourceHash = 0;
+        uint64_t                promotedPolicies = 0;
+        mutable mutex           scriptFunctionsLock;    // builtin modules are shared by every thread
+        mutable vector<FunctionPtr> scriptFunctionsCache;
+        mutable bool            scriptFunctionsValid = false;
     };
 
     #define REGISTER_MODULE(ClassName) \
@@ -1014,6 +1028,8 @@ namespace das
         bool        persistent_heap = false;
         uint32_t    heap_size_hint = 65536;
         uint32_t    string_heap_size_hint = 65536;
+        bool        string_heap_header = false;         // heap strings carry length and hash in front, so that length and hashing are O(1). persistent_heap only
+        bool        fork_globals_image = false;         // forked context copies globals as they were after init script, instead of running it again
     // rtti
         bool rtti = false;                              // create extended RTTI
     // language
@@ -1032,6 +1048,9 @@ namespace das
         bool no_optimizations = false;                  // disable optimizations, regardless of settings
         bool fail_on_no_aot = true;                     // AOT link failure is error
         bool fail_on_lack_of_aot_export = false;        // remove_unused_symbols = false is missing in the module, which is passed to AOT
+        uint32_t compile_threads = 0;                   // when >1, source files of the require graph are loaded and simulated functions are fused in parallel
+        bool bytecode_engine = false;                   // functions, which only use int and bool, run on the register bytecode
+        bool profile_fusion = false;                    // count node pairs and triples left after fusion, see simulate_fusion_profile.h
     // debugger
         //  when enabled
         //      1. disables [fastcall]
@@ -1070,6 +1089,8 @@ namespace das
         bool optimizationCondFolding();
         bool optimizationUnused(TextWriter & logs);
         void fusion ( Context & context, TextWriter & logs );
+        void bytecode ( Context & context, TextWriter & logs );
+        void profileFusion ( Context & context, TextWriter & logs );
         void buildAccessFlags(TextWriter & logs);
         bool verifyAndFoldContracts();
         void optimize(TextWriter & logs, ModuleGroup & libGroup);
@@ -1172,7 +1193,8 @@ namespace das
                           ModuleGroup & libGroup,
                           TextWriter * log,
                           int tab,
-                          bool allowPromoted );
+                          bool allowPromoted,
+                          const CodeOfPolicies & policies );
 
 
     // note: this has sifnificant performance implications
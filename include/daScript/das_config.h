@@ -66,6 +66,16 @@ using das_safe_set = std::set<K,C>;
   #define DAS_FUSION  0
 #endif
 
+// tables keep a control byte per slot, so that probing compares 16 slots at a time
+#ifndef DAS_TABLE_CONTROL_BYTES
+  #define DAS_TABLE_CONTROL_BYTES  1
+#endif
+
+// tables of at least this many slots grow incrementally, migrating a few slots on every access. 0 disables it
+#ifndef DAS_TABLE_INCREMENTAL_REHASH
+  #define DAS_TABLE_INCREMENTAL_REHASH  16384
+#endif
+
 #ifndef DAS_DEBUGGER
   #define DAS_DEBUGGER  1
 #endif
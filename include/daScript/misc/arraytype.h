@@ -93,6 +93,7 @@ namespace das
             struct {
                 bool    shared : 1;
                 bool    hopeless : 1;   // needs to be deleted without fuss (exceptions)
+                bool    rehashing : 1;  // table is migrating from the previous allocation
             };
             uint32_t    flags;
         };
@@ -115,9 +116,56 @@ namespace das
         uint32_t    shift;
     };
 
+    // table memory is values, then keys, then hashes. with DAS_TABLE_CONTROL_BYTES hashes are followed by
+    // a control byte per slot (empty, deleted, or 7 bits of the hash), and a mirror of the first TABLE_GROUP of them
+#if DAS_TABLE_CONTROL_BYTES
+    enum : uint8_t { TABLE_CTRL_EMPTY = 0x80, TABLE_CTRL_DELETED = 0xfe };
+    enum { TABLE_GROUP = 16 };
+    __forceinline uint8_t * table_control ( const Table & tab ) { return (uint8_t *)(tab.hashes + tab.capacity); }
+    __forceinline uint32_t table_control_size ( uint32_t capacity ) { return capacity + TABLE_GROUP; }
+#else
+    __forceinline uint32_t table_control_size ( uint32_t ) { return 0; }
+#endif
+
+    // every table allocation ends with the rehash record. while the table is rehashing it points to the
+    // previous allocation, slots of which below the cursor are already migrated. it also keeps rehash stats
+    struct TableRehash {
+        char *      oldData;
+        uint32_t    oldCapacity;
+        uint32_t    cursor;
+        uint32_t    keySize;
+        uint32_t    valueSize;
+        uint32_t    rehashes;
+        uint32_t    incremental;    // rehashes which were migrated a step at a time
+        uint64_t    rehashTime;     // usec
+    };
+
+    __forceinline uint32_t table_rehash_offset ( uint32_t capacity, uint32_t keyValueSize ) {
+        uint32_t size = capacity * (keyValueSize + uint32_t(sizeof(uint32_t))) + table_control_size(capacity);
+        return (size + 7) & ~7u;
+    }
+    __forceinline uint32_t table_memory_size ( uint32_t capacity, uint32_t keyValueSize ) {
+        return table_rehash_offset(capacity, keyValueSize) + uint32_t(sizeof(TableRehash));
+    }
+    __forceinline TableRehash * table_rehash ( const Table & tab ) {
+        uint32_t end = uint32_t((char *)tab.hashes - tab.data) + tab.capacity * uint32_t(sizeof(uint32_t)) + table_control_size(tab.capacity);
+        return (TableRehash *)(tab.data + ((end + 7) & ~7u));
+    }
+
+    enum { TABLE_REHASH_STEP = 64 };    // old slots migrated per table access
+
     void table_clear ( Context & context, Table & arr );
     void table_lock ( Context & context, Table & arr );
     void table_unlock ( Context & context, Table & arr );
+    bool table_allocate ( Context & context, Table & tab, uint32_t capacity, uint32_t keySize, uint32_t valueSize );
+    void table_free ( Context & context, Table & tab, uint32_t keyValueSize );
+    bool table_grow ( Context & context, Table & tab, uint32_t keySize, uint32_t valueSize );
+    bool table_rehash_full ( Context & context, Table & tab, uint32_t capacity, uint32_t keySize, uint32_t valueSize );
+    void table_rehash_step ( Context & context, Table & tab, uint32_t slots );
+    void table_rehash_finish ( Context & context, Table & tab );
+    Table table_rehash_source ( const Table & tab );
+    int table_rehash_move ( Context & context, Table & tab, Table & old, uint32_t oldIndex );
+    void table_reserve ( Context & context, Table & tab, uint32_t size, uint32_t keySize, uint32_t valueSize );
 
     struct Sequence;
     void builtin_table_keys ( Sequence & result, const Table & tab, int32_t stride, Context * __context__ );
@@ -42,9 +42,96 @@ namespace das {
         condition_variable	mCond;
     };
 
+    // Chase-Lev work stealing deque of pointers. Owner thread pushes and takes at the bottom,
+    // any other thread steals from the top. Only the owner grows the ring, old rings are retired
+    // and released when the deque dies, since thieves may still be reading from them.
+    template <typename TT>
+    class WorkStealingDeque {
+        struct Ring {
+            Ring ( int64_t sz ) : size(sz), mask(sz-1), items(new atomic<TT *>[size_t(sz)]) {}
+            __forceinline TT * get ( int64_t i ) const { return items[i & mask].load(memory_order_relaxed); }
+            __forceinline void put ( int64_t i, TT * x ) { items[i & mask].store(x, memory_order_relaxed); }
+            int64_t                     size;
+            int64_t                     mask;
+            unique_ptr<atomic<TT *>[]>  items;
+        };
+    public:
+        WorkStealingDeque ( int64_t initialSize = 64 ) : mTop(0), mBottom(0) {
+            mRings.emplace_back(make_unique<Ring>(initialSize));
+            mRing = mRings.back().get();
+        }
+        WorkStealingDeque ( const WorkStealingDeque & ) = delete;
+        WorkStealingDeque & operator = ( const WorkStealingDeque & ) = delete;
+        // owner only
+        void push ( TT * x ) {
+            int64_t b = mBottom.load(memory_order_relaxed);
+            int64_t t = mTop.load(memory_order_acquire);
+            Ring * r = mRing.load(memory_order_relaxed);
+            if ( b - t > r->size - 1 ) r = grow(r, t, b);
+            r->put(b, x);
+            atomic_thread_fence(memory_order_release);
+            mBottom.store(b + 1, memory_order_relaxed);
+        }
+        // owner only
+        TT * take () {
+            int64_t b = mBottom.load(memory_order_relaxed) - 1;
+            Ring * r = mRing.load(memory_order_relaxed);
+            mBottom.store(b, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t t = mTop.load(memory_order_relaxed);
+            TT * x = nullptr;
+            if ( t <= b ) {
+                x = r->get(b);
+                if ( t == b ) {
+                    if ( !mTop.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed) ) {
+                        x = nullptr;
+                    }
+                    mBottom.store(b + 1, memory_order_relaxed);
+                }
+            } else {
+                mBottom.store(b + 1, memory_order_relaxed);
+            }
+            return x;
+        }
+        // any thread
+        TT * steal () {
+            int64_t t = mTop.load(memory_order_acquire);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t b = mBottom.load(memory_order_acquire);
+            if ( t < b ) {
+                Ring * r = mRing.load(memory_order_acquire);
+                TT * x = r->get(t);
+                if ( mTop.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed) ) {
+                    return x;
+                }
+            }
+            return nullptr;
+        }
+        bool empty() const {
+            return mBottom.load(memory_order_relaxed) <= mTop.load(memory_order_relaxed);
+        }
+    protected:
+        Ring * grow ( Ring * r, int64_t t, int64_t b ) {
+            auto nr = make_unique<Ring>(r->size * 2);
+            for ( int64_t i = t; i != b; ++i ) {
+                nr->put(i, r->get(i));
+            }
+            Ring * res = nr.get();
+            mRings.emplace_back(move(nr));
+            mRing.store(res, memory_order_release);
+            return res;
+        }
+    protected:
+        atomic<int64_t>              mTop;
+        char                         mPadTop[64];       // keep thieves and the owner on separate cache lines
+        atomic<int64_t>              mBottom;
+        atomic<Ring *>               mRing;
+        vector<unique_ptr<Ring>>     mRings;
+    };
+
     class JobQue {
     public:
-        JobQue();
+        JobQue( int threadCount = -1 );
         JobQue ( const JobQue & ) = delete;
         JobQue ( JobQue && ) = delete;
         JobQue & operator = ( const JobQue & ) = delete;
@@ -54,6 +141,7 @@ namespace das {
         bool areJobsPending(JobCategory category);
         int getNumberOfQueuedJobs();
         int getTotalHwJobs();
+        bool isWorkerThread() const;
         void push(Job && job, JobCategory category, JobPriority priority);
         void parallel_for ( JobStatus & status, int from, int to, const JobChunk & chunk, JobCategory category, JobPriority priority, int chunk_count = -1, int step = 1 );
         void parallel_for ( int from, int to, const JobChunk & chunk, JobCategory category, JobPriority priority, int chunk_count = -1, int step = 1 );
@@ -64,6 +152,11 @@ namespace das {
         void wait();
         void Reset() { wait( ); }
     protected:
+        enum {
+            numLanes = int(JobPriority::Maximum) - int(JobPriority::Minimum) + 1,
+            numCategoryCounters = 64,       // categories are hashed into counters, collisions only make areJobsPending conservative
+            spinBeforeSleep = 64,
+        };
         struct JobEntry {
             JobEntry( Job&& _function, JobCategory _category, JobPriority _priority) {
                 function = move(_function);
@@ -74,29 +167,44 @@ namespace das {
             JobPriority		priority = JobPriority::Inactive;
             JobCategory		category = 0;
         };
+        // jobs, submitted from outside of the worker threads, go to the inbox of one of the workers
+        struct Inbox {
+            mutex               lock;
+            deque<JobEntry *>   lanes[numLanes];
+            atomic<int>         count;
+            Inbox() : count(0) {}
+        };
         struct ThreadEntry {
-            ThreadEntry( unique_ptr<thread> && thread) {
-                threadPointer = das::move(thread);
-            };
+            ThreadEntry() {}
             unique_ptr<thread>	threadPointer;
             JobPriority			currentPriority = JobPriority::Inactive;
-            JobCategory			currentCategory = 0;
+            WorkStealingDeque<JobEntry>	lanes[numLanes];
+            Inbox               inbox;
         };
+        static __forceinline int laneIndex ( JobPriority priority ) {
+            return int(JobPriority::Maximum) - int(priority);       // lane 0 is the highest priority
+        }
     protected:
         void join();
         void job(int threadIndex);
-        void submit(Job && job, JobCategory category, JobPriority priority);
+        void submit(JobEntry * entry);
+        void wakeUp(int count);
+        JobEntry * findJob(int threadIndex);
+        JobEntry * takeFromInbox(Inbox & inbox, int lane);
+        void execute(int threadIndex, JobEntry * entry);
     protected:
+        mutex mSleepMutex;
         condition_variable mCond;
-        int mSleepMs;
+        atomic<int>     mSleeping;
         atomic<bool>	mShutdown;
-        atomic<int>		mThreadCount;
+        int             mTotalThreads;
+        atomic<uint32_t> mNextInbox;
         static thread::id mTheMainThread;
-        mutex mFifoMutex;
     protected:
-        deque<JobEntry>	mFifo;
-        vector<ThreadEntry>		mThreads;
-        atomic<int> mJobsRunning;
+        vector<unique_ptr<ThreadEntry>>	mThreads;
+        atomic<int> mJobsQueued;            // submitted, but not yet picked up
+        atomic<int> mJobsPending;           // submitted, but not yet finished
+        atomic<int> mCategoryPending[numCategoryCounters];
     protected:
         mutex mEvalMainThreadMutex;
         vector<Job> mEvalMainThread;
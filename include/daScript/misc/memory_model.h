@@ -12,24 +12,31 @@ namespace das {
 
     struct LineInfo;
 
+#define DAS_DECK_PAGE_SHIFT     12
+#define DAS_DECK_PAGE_SIZE      (1u<<DAS_DECK_PAGE_SHIFT)
+
+    // deck data is page aligned, so every page belongs to exactly one deck, and deck can be found by page
+    // free slots are kept in the intrusive list, bits are only there for the GC and for walking live allocations
     struct Deck {
         Deck( uint32_t ne, uint32_t es, Deck * n ) {
             total = (ne+31) & ~31;
             size = es;
             totalBytes = total * size;
-            data = (char*) das_aligned_alloc16(totalBytes);
+            block = (char*) das_aligned_alloc16(totalBytes + DAS_DECK_PAGE_SIZE - 16);
+            data = (char*) ((uintptr_t(block) + DAS_DECK_PAGE_SIZE - 1) & ~uintptr_t(DAS_DECK_PAGE_SIZE - 1));
             bits = (uint32_t*) das_aligned_alloc16(total / 32 * 4);
             reset();    // this reset before next
             next = n;
         }
         ~Deck ( ) {
-            das_aligned_free16(data);
+            das_aligned_free16(block);
             das_aligned_free16(bits);
             if ( next ) delete next;
         }
         void reset() {
             memset ( bits, 0, total / 32 * 4);
-            look = 0;
+            freeList = nullptr;
+            bump = 0;
             allocated = 0;
             if ( next ) next->reset();
         }
@@ -37,24 +44,22 @@ namespace das {
             return (ptr>=data) && (ptr<data+totalBytes);
         }
         __forceinline char * allocate ( ) {
-            if ( allocated == total ) return nullptr;
-            uint32_t maxt = total / 32;
-            for ( uint32_t t=0; t!=maxt; ++t ) {
-                uint32_t b = bits[look];
-                uint32_t nb = ~b;
-                if ( nb ) {
-                    uint32_t j = 31 - __builtin_clz(nb);
-                    bits[look] = b | (1u<<j);
-                    allocated ++;
-                    uint32_t ofs = (look * 32 + j);
-                    DAS_ASSERT(ofs < total);
-                    return data + ofs * size;
-                }
-                look = look + 1;
-                if ( look == maxt ) look = 0;
+            uint32_t idx;
+            char * res;
+            if ( freeList ) {
+                res = freeList;
+                freeList = *(char **)res;
+                idx = uint32_t((res - data) / size);
+            } else if ( bump != total ) {
+                idx = bump ++;
+                res = data + idx * size;
+            } else {
+                return nullptr;
             }
-            DAS_ASSERT(0 && "allocated reports room, but no bits are available");
-            return nullptr;
+            DAS_ASSERT((bits[idx>>5] & (1u<<(idx&31)))==0 && "free list points to the allocated slot");
+            bits[idx>>5] |= 1u<<(idx&31);
+            allocated ++;
+            return res;
         }
         __forceinline void free ( char * ptr ) {
             ptrdiff_t idx = (ptr - data) / size;
@@ -65,7 +70,8 @@ namespace das {
             uint32_t b = bits[i];
             DAS_ASSERT((b & (1u<<j))!=0 && "calling free on the pointer, which is already free");
             bits[i] = b ^ (1u<<j);
-            look = i;
+            *(char **)ptr = freeList;
+            freeList = ptr;
             allocated --;
         }
         __forceinline void mark ( char * ptr ) {
@@ -80,12 +86,36 @@ namespace das {
                 allocated ++;
             }
         }
+        // after the GC marked what is alive, everything else goes back to the free list
+        void sweep() {
+            freeList = nullptr;
+            allocated = 0;
+            bump = 0;
+            for ( uint32_t i=total/32; i!=0; --i ) {
+                if ( uint32_t b = bits[i-1] ) {
+                    bump = (i-1)*32 + 32 - __builtin_clz(b);
+                    break;
+                }
+            }
+            for ( uint32_t idx=bump; idx!=0; --idx ) {
+                uint32_t uidx = idx - 1;
+                if ( bits[uidx>>5] & (1u<<(uidx&31)) ) {
+                    allocated ++;
+                } else {
+                    char * ptr = data + uidx * size;
+                    *(char **)ptr = freeList;
+                    freeList = ptr;
+                }
+            }
+        }
         char *      data = nullptr;
+        char *      block = nullptr;
+        char *      freeList = nullptr;
         uint32_t *  bits = nullptr;
         uint32_t    total = 0;
         uint32_t    size = 0;
         uint32_t    totalBytes = 0;
-        uint32_t    look = 0;
+        uint32_t    bump = 0;
         uint32_t    allocated = 0;
         Deck *      next = nullptr;
     };
@@ -109,6 +139,7 @@ namespace das {
                 if ( chunks[i] ) delete chunks[i];
                 chunks[i] = nullptr;
             }
+            pages.clear();
         }
         void reset() {
             // TODO: modify watermarks
@@ -116,6 +147,32 @@ namespace das {
                 if ( chunks[i] ) chunks[i]->reset();
             }
         }
+        Deck * addDeck ( uint32_t total, uint32_t size ) {
+            uint32_t si = (size >> 4) - 1;
+            auto ch = new Deck(total, size, chunks[si]);
+            uintptr_t firstPage = uintptr_t(ch->data) >> DAS_DECK_PAGE_SHIFT;
+            uintptr_t lastPage = (uintptr_t(ch->data) + ch->totalBytes - 1) >> DAS_DECK_PAGE_SHIFT;
+            for ( uintptr_t page=firstPage; page<=lastPage; ++page ) {
+                pages[page] = ch;
+            }
+            chunks[si] = ch;
+            return ch;
+        }
+        // most recent deck of the size class is the largest, and most likely owner - otherwise we go by page
+        __forceinline Deck * findDeck ( char * ptr, uint32_t size ) const {
+            uint32_t si = (size >> 4) - 1;
+            auto ch = chunks[si];
+            if ( ch && ch->isOwnPtr(ptr) ) return ch;
+            auto it = pages.find(uintptr_t(ptr) >> DAS_DECK_PAGE_SHIFT);
+            if ( it!=pages.end() && it->second->size==size && it->second->isOwnPtr(ptr) ) return it->second;
+            return nullptr;
+        }
+        // any size class, for the pointers which came from the outside (i.e. GC scanning the stack)
+        __forceinline Deck * findDeck ( char * ptr ) const {
+            auto it = pages.find(uintptr_t(ptr) >> DAS_DECK_PAGE_SHIFT);
+            if ( it!=pages.end() && it->second->isOwnPtr(ptr) ) return it->second;
+            return nullptr;
+        }
         char * allocate ( uint32_t size ) {
             size = (size + 15) & ~15;
             DAS_ASSERT(size && size<=DAS_MAX_SHOE_ALLOCATION);
@@ -130,24 +187,16 @@ namespace das {
         void free ( char * ptr, uint32_t size ) {
             size = (size + 15) & ~15;
             DAS_ASSERT(size && size<=DAS_MAX_SHOE_ALLOCATION);
-            uint32_t si = (size >> 4) - 1;
-            for ( auto ch = chunks[si]; ch; ch=ch->next ) {
-                if ( ch->isOwnPtr(ptr) ) {
-                    ch->free(ptr);
-                    return;
-                }
-            }
-            DAS_ASSERT(0 && "not a chunk pointer");
+            auto ch = findDeck(ptr, size);
+            DAS_ASSERT(ch && "not a chunk pointer");
+            ch->free(ptr);
         }
         bool mark ( char * ptr, uint32_t size ) {
             size = (size + 15) & ~15;
             DAS_ASSERT(size && size<=DAS_MAX_SHOE_ALLOCATION);
-            uint32_t si = (size >> 4) - 1;
-            for ( auto ch = chunks[si]; ch; ch=ch->next ) {
-                if ( ch->isOwnPtr(ptr) ) {
-                    ch->mark(ptr);
-                    return true;
-                }
+            if ( auto ch = findDeck(ptr, size) ) {
+                ch->mark(ptr);
+                return true;
             }
             return false;
         }
@@ -158,13 +207,7 @@ namespace das {
         }
         bool isOwnPtr ( char * ptr, uint32_t size ) const {
             DAS_ASSERT(size && size<=DAS_MAX_SHOE_ALLOCATION);
-            uint32_t si = (size >> 4) - 1;
-            for ( auto ch = chunks[si]; ch; ch=ch->next ) {
-                if ( ch->isOwnPtr(ptr) ) {
-                    return true;
-                }
-            }
-            return false;
+            return findDeck(ptr, size) != nullptr;
         }
         void getStats ( uint32_t & depth, uint32_t & pages, uint64_t & bytes, uint64_t & totalBytes ) const {
             depth = 0;
@@ -203,6 +246,7 @@ namespace das {
             return d;
         }
         Deck *  chunks[DAS_MAX_SHOE_CUNKS];
+        das_hash_map<uintptr_t,Deck *> pages;
     };
 
     typedef function<int(int)> CustomGrowFunction;
@@ -220,6 +264,8 @@ namespace das {
         char * allocate ( uint32_t size );
         bool free ( char * ptr, uint32_t size );
         char * reallocate ( char * ptr, uint32_t size, uint32_t nsize );
+        char * locate ( char * ptr, uint32_t & size ) const;
+        void markAllocation ( char * ptr, uint32_t size );
         __forceinline int depth() const { return shoe.depth(); }
         __forceinline bool isOwnPtr( char * ptr, uint32_t size ) const {
             return shoe.isOwnPtr(ptr,size) || (bigStuff.find(ptr)!=bigStuff.end());
@@ -234,6 +280,8 @@ namespace das {
         uint32_t                initialSize = 0;
         Shoe                    shoe;
         das_hash_map<void *,uint32_t> bigStuff;  // note: can't use char *, some stl implementations try hashing it as string
+        mutable vector<pair<char *,uint32_t>> bigIndex;  // sorted big allocations, only for the interior pointer lookup
+        mutable bool            bigIndexDirty = true;
 #if DAS_SANITIZER
         das_hash_map<void *,uint32_t> deletedBigStuff;
 #endif
@@ -312,6 +360,7 @@ namespace das {
             initialSize = size;
         }
         virtual uint32_t grow ( uint32_t si );
+        void adopt ( LinearChunkAllocator & other );    // takes over the chunks of the other allocator, pointers into them stay valid
     protected:
         void getStats ( uint32_t & depth, uint64_t & bytes, uint64_t & total ) const;
     public:
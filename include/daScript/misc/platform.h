@@ -106,6 +106,23 @@ __forceinline uint32_t __builtin_clz(uint32_t x) {
     _BitScanReverse(&r, x);
     return uint32_t(31 - r);
 }
+__forceinline uint32_t __builtin_ctz(uint32_t x) {
+    unsigned long r = 0;
+    _BitScanForward(&r, x);
+    return uint32_t(r);
+}
+__forceinline uint32_t __builtin_ctzll(uint64_t x) {
+    unsigned long r = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&r, x);
+#else
+    if ( !_BitScanForward(&r, uint32_t(x)) ) {
+        _BitScanForward(&r, uint32_t(x >> 32));
+        r += 32;
+    }
+#endif
+    return uint32_t(r);
+}
 #endif
 #endif
 
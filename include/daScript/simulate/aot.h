@@ -1342,8 +1342,7 @@ namespace das {
         static __forceinline void clear ( Context * __context__, TTable<TKey,TVal> & tab ) {
             if ( tab.data ) {
                 if ( !tab.lock ) {
-                    uint32_t oldSize = tab.capacity*(sizeof(TKey)+sizeof(TVal)+sizeof(uint32_t));
-                    __context__->heap->free(tab.data, oldSize);
+                    table_free(*__context__, tab, sizeof(TKey)+sizeof(TVal));
                 } else {
                     __context__->throw_error("can't delete locked table");
                 }
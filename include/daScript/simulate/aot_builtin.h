@@ -1,6 +1,7 @@
 #pragma once
 
 namespace das {
+    struct TableStats;
     void setCommandLineArguments ( int argc, char * argv[] );
     void getCommandLineArguments( Array & arr );
     bool is_compiling ( Context * ctx );
@@ -14,11 +15,15 @@ namespace das {
     int builtin_table_size ( const Table & arr );
     int builtin_table_capacity ( const Table & arr );
     void builtin_table_clear ( Table & arr, Context * context );
+    void builtin_table_reserve ( Table & arr, int32_t size, int32_t szk, int32_t szv, Context * context );
+    void builtin_table_stats ( const Table & arr, TableStats & stats );
     vec4f _builtin_hash ( Context & context, SimNode_CallBase * call, vec4f * args );
     uint64_t heap_bytes_allocated ( Context * context );
     int32_t heap_depth ( Context * context );
     uint64_t string_heap_bytes_allocated ( Context * context );
     int32_t string_heap_depth ( Context * context );
+    void string_heap_collect ( Context * context, LineInfoArg * info );
+    void heap_collect ( bool sheap, Context * context, LineInfoArg * info );
     void builtin_table_lock ( const Table & arr, Context * context );
     void builtin_table_unlock ( const Table & arr, Context * context );
     void builtin_table_clear_lock ( const Table & arr, Context * context );
@@ -54,10 +59,11 @@ namespace das {
     void dumpProfileInfo( Context * context );
     char * collectProfileInfo( Context * context );
 
+    // instantiated for the numeric types in module_builtin_runtime_sort.cpp
     template <typename TT>
-    __forceinline void builtin_sort ( TT * data, int32_t length ) {
-        if ( length>1 ) sort ( data, data + length );
-    }
+    void builtin_sort ( TT * data, int32_t length );
+    template <typename KT>
+    void builtin_sort_by_key ( void * data, int32_t elementSize, int32_t length, const KT * keys );
 
     void builtin_sort_string ( void * data, int32_t length );
     void builtin_sort_any_cblock ( void * anyData, int32_t elementSize, int32_t length, const Block & cmp, Context * context );
@@ -6,6 +6,13 @@ namespace das {
     void debuggerStackWalk ( Context & context, const LineInfo & lineInfo );
     void debuggerSetContextSingleStep ( Context & context, bool step );
 
+    void debuggerStartSampling ( Context & context, uint32_t every );
+    void debuggerStopSampling ( Context & context );
+    void debuggerRequestSample ( Context & context );
+    char * debuggerSamplingReport ( Context & context, Context * ctx );
+    char * debuggerSamplingCollapsedStacks ( Context & context, Context * ctx );
+    char * debuggerSamplingChromeTrace ( Context & context, Context * ctx );
+
     DataWalkerPtr makeDataWalker ( const void * pClass, const StructInfo * info, Context * context );
     void dapiWalkData ( DataWalkerPtr walker, void * data, const TypeInfo & info );
     void dapiWalkDataV ( DataWalkerPtr walker, float4 data, const TypeInfo & info );
@@ -13,9 +13,15 @@ namespace das {
     char* builtin_fgets(const FILE* _f, Context* context);
     void builtin_fwrite(const FILE * _f, char * str, Context * context);
     bool builtin_feof(const FILE* _f);
+    int64_t builtin_ftell ( const FILE * f, Context * context );
+    int64_t builtin_fseek ( const FILE * f, int64_t offset, int32_t mode, Context * context );
+    const FILE * builtin_tmpfile ();
     vec4f builtin_read ( Context &, SimNode_CallBase * call, vec4f * args );
     vec4f builtin_write ( Context &, SimNode_CallBase * call, vec4f * args );
     vec4f builtin_load ( Context & context, SimNode_CallBase *, vec4f * args );
+    vec4f builtin_save_stream ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f builtin_load_stream ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f builtin_map_stream ( Context & context, SimNode_CallBase * call, vec4f * args );
     void builtin_map_file(const FILE* _f, const TBlock<void, TTemporary<const char*>>& blk, Context* context);
     char * builtin_dirname ( const char * name, Context * context );
     char * builtin_basename ( const char * name, Context * context );
@@ -7,6 +7,9 @@
 
 namespace das {
 
+    template <typename TT>
+    struct TArray;
+
     struct Feature {
         void *              data = nullptr;
         shared_ptr<Context> from;
@@ -42,11 +45,102 @@ namespace das {
         Context *           owner = nullptr;
     };
 
+    // futex style event count. waiters only touch the mutex when they are about to sleep,
+    // and notify only touches it when there is someone sleeping
+    class EventCount {
+    public:
+        EventCount() : epoch(0), waiters(0) {}
+        __forceinline uint32_t prepareWait() {
+            waiters++;
+            return epoch.load();
+        }
+        __forceinline void cancelWait() {
+            waiters--;
+        }
+        void wait ( uint32_t key );
+        void notify();
+    protected:
+        atomic<uint32_t>    epoch;
+        atomic<int32_t>     waiters;
+        mutex               lock;
+        condition_variable  cond;
+    };
+
+    // bounded multi-producer, multi-consumer lock-free ring (Vyukov). push blocks when the ring is full,
+    // tryPush reports back-pressure instead. pop blocks while the ring is empty and producers remain.
+    // capacity, which is not a power of two, is rounded up to the next one. cell sequence counts in half steps
+    // (even - free for that lap, odd - holds data), so that the ring of one cell works too
+    class LockFreeChannel {
+    public:
+        LockFreeChannel( Context * ctx, uint32_t capacity, int count );
+        ~LockFreeChannel();
+        LockFreeChannel ( LockFreeChannel && ) = delete;
+        LockFreeChannel ( const LockFreeChannel & ) = delete;
+        LockFreeChannel & operator = ( const LockFreeChannel & ) = delete;
+        LockFreeChannel & operator = ( LockFreeChannel && ) = delete;
+        bool tryPush ( void * data, Context * context );
+        void push ( void * data, Context * context );
+        void pushBatch ( void ** data, uint32_t count, Context * context );
+        void * pop();
+        uint32_t popBatch ( void ** data, uint32_t count );
+        bool isEmpty() const;
+        bool isFull() const;
+        bool isReady() const;
+        int32_t getSize() const;
+        int32_t getCapacity() const { return int32_t(mask + 1); }
+        void notify();
+        void wait();
+    protected:
+        bool enqueue ( void * data, Context * context );
+        bool dequeue ( Feature & res );
+        void * retain ( Feature && res );
+    protected:
+        struct Cell {
+            atomic<uint64_t>    sequence;
+            Feature             data;
+        };
+        unique_ptr<Cell[]>      cells;
+        uint64_t                mask = 0;
+        char                    pad0[64];
+        atomic<uint64_t>        enqueuePos;
+        char                    pad1[64];
+        atomic<uint64_t>        dequeuePos;
+        char                    pad2[64];
+        atomic<int32_t>         remaining;
+        EventCount              notEmpty;
+        EventCount              notFull;
+        Context *               owner = nullptr;
+        // popped data lives on the heap of the context which pushed it, we keep those alive. once per producer
+        mutex                   retainLock;
+        atomic<Context *>       lastRetained;
+        das_hash_map<Context *,shared_ptr<Context>> retained;
+    };
+
+    // forked contexts are recycled per parent context. context is reset when its job is done, so picking one up
+    // for the next job costs the same regardless of the size of globals or of what the previous job allocated.
+    // globals are reset from the snapshot taken right after the fork, so the init script only runs once per fork.
+    // forks whose globals can't be snapshot (they point to the heap, or there are [init] functions) run the init script again
+    class ContextPool {
+    public:
+        enum { maxPooledContexts = 64 };
+        shared_ptr<Context> acquire ( Context * parent );
+        void release ( Context * parent, shared_ptr<Context> && ctx, bool reinitGlobals = true );
+        int32_t size ( Context * parent );
+        void clear();
+    protected:
+        mutex                                               lock;
+        das_hash_map<Context *,vector<shared_ptr<Context>>> pool;  // parent is only a key, it may be gone by now
+    };
+
     void new_job_invoke ( Lambda lambda, Func fn, int32_t lambdaSize, Context * context, LineInfoArg * lineinfo );
     void new_thread_invoke ( Lambda lambda, Func fn, int32_t lambdaSize, Context * context );
     void withJobQue ( const TBlock<void> & block, Context * context, LineInfoArg * lineInfo );
+    void parallelFor ( int32_t from, int32_t to, int32_t chunkSize, const TBlock<void,int32_t,int32_t> & blk, Context * context, LineInfoArg * at );
+    void parallelForEx ( int32_t from, int32_t to, int32_t chunkSize, const Block & payload, const TBlock<void,int32_t,int32_t> & blk, Context * context, LineInfoArg * at );
+    shared_ptr<JobQue> getJobQue();     // null outside of 'with_job_que'
     int getTotalHwJobs( Context * context, LineInfoArg * at );
     int getTotalHwThreads ();
+    int getPooledForks ( Context * context );
     void withJobStatus ( int32_t total, const TBlock<void,JobStatus *> & block, Context * context, LineInfoArg * lineInfo );
     void waitForJob ( JobStatus * status );
     void notifyJob ( JobStatus * status );
@@ -56,4 +150,12 @@ namespace das {
     void withChannelEx ( int32_t count, const TBlock<void,Channel *> & blk, Context * context );
     void waitForChannel ( Channel * status );
     void notifyChannel ( Channel * status );
+    void lockFreeChannelPush ( LockFreeChannel * ch, void * data, Context * ctx );
+    bool lockFreeChannelTryPush ( LockFreeChannel * ch, void * data, Context * ctx );
+    void lockFreeChannelPushBatch ( LockFreeChannel * ch, const TArray<void *> & data, Context * ctx );
+    void * lockFreeChannelPop ( LockFreeChannel * ch );
+    int32_t lockFreeChannelPopBatch ( LockFreeChannel * ch, TArray<void *> & data );
+    void withLockFreeChannel ( int32_t capacity, int32_t count, const TBlock<void,LockFreeChannel *> & blk, Context * context, LineInfoArg * at );
+    void waitForLockFreeChannel ( LockFreeChannel * status );
+    void notifyLockFreeChannel ( LockFreeChannel * status );
 }
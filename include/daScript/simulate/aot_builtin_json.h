@@ -0,0 +1,37 @@
+#pragma once
+
+#include "daScript/simulate/aot_builtin_string.h"
+
+namespace das {
+
+    // json document is parsed into a flat tape of 64 bit entries
+    //  top 8 bits hold the kind, which is the first character of the value ({ [ " t f n) or 'd' for numbers
+    //  containers keep the number of elements in bits 32..55, and the index of the entry after their last element in the low 32 bits
+    //  objects store key and value entries one after another
+    //  strings keep offset of the [uint32 length][bytes][0] record in the string buffer
+    //  numbers keep the double in the next entry
+    enum {
+        JSON_TAPE_KIND_SHIFT    = 56,
+        JSON_TAPE_COUNT_SHIFT   = 32,
+        JSON_TAPE_COUNT_MASK    = 0xffffff,
+        JSON_MAX_DEPTH          = 1024
+    };
+
+    char * builtin_json_parse ( const char * text, TArray<uint64_t> & tape, TArray<uint8_t> & strings, Context * context );
+    char * builtin_json_parse_bytes ( const TArray<uint8_t> & text, TArray<uint64_t> & tape, TArray<uint8_t> & strings, Context * context );
+    int32_t builtin_json_kind ( const TArray<uint64_t> & tape, int32_t index, Context * context );
+    int32_t builtin_json_next ( const TArray<uint64_t> & tape, int32_t index, Context * context );
+    int32_t builtin_json_length ( const TArray<uint64_t> & tape, int32_t index, Context * context );
+    int32_t builtin_json_at ( const TArray<uint64_t> & tape, int32_t index, int32_t element, Context * context );
+    int32_t builtin_json_find ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, const char * key, Context * context );
+    double builtin_json_number ( const TArray<uint64_t> & tape, int32_t index, Context * context );
+    bool builtin_json_bool ( const TArray<uint64_t> & tape, int32_t index, Context * context );
+    char * builtin_json_string ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context );
+    StringView builtin_json_view ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context );
+    void builtin_json_for_each ( const TArray<uint64_t> & tape, int32_t index, const Block & block, Context * context );
+    void builtin_json_for_each_field ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, const Block & block, Context * context );
+    void builtin_json_write_string ( StringBuilderWriter & writer, const char * str );
+    void builtin_json_write_number ( StringBuilderWriter & writer, double value );
+    void builtin_json_write ( StringBuilderWriter & writer, const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context );
+}
+
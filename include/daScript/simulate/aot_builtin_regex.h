@@ -0,0 +1,110 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+#include <mutex>
+
+namespace das {
+
+    template <typename TT>
+    struct TArray;
+
+    // regex program, as serialized by daslib/regex from the ReNode tree, in prefix order
+    //  Char        [0, length, bytes...]
+    //  Set         [1, 8 words of the character set]
+    //  Any         [2]
+    //  Eos         [3]
+    //  Group       [4, index, sub]
+    //  Plus        [5, greedy, sub]
+    //  Star        [6, greedy, sub]
+    //  Question    [7, greedy, sub]
+    //  Concat      [8, left, right]
+    //  Union       [9, count, subs...]
+    enum class RegexOp : int32_t {
+        Char, Set, Any, Eos, Group, Plus, Star, Question, Concat, Union
+    };
+
+    // thompson nfa instruction
+    struct RegexInstruction {
+        enum : uint8_t { Set, Split, Jump, Save, Eos, Match };
+        uint8_t     op = Match;
+        int32_t     x = 0;          // jump or first split target, save slot
+        int32_t     y = 0;          // second split target
+        uint32_t    cset[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        __forceinline bool has ( uint8_t ch ) const { return (cset[ch>>5] & (1u<<(ch & 31))) != 0; }
+    };
+
+    // lazily built dfa over the nfa. states are created on first use and cached,
+    // when the cache grows past its budget its flushed and rebuilt from the current state
+    struct RegexDfa {
+        enum { DEAD = 0, MAX_STATES = 2048 };
+        enum : uint8_t { FLAG_MATCH = 1, FLAG_MATCH_AT_END = 2 };
+        const vector<RegexInstruction> * program = nullptr;
+        bool                            unanchored = false;     // every step also starts a new thread at the entry point
+        vector<vector<int32_t>>         states;
+        das_hash_map<string,int32_t>    lookup;
+        vector<int32_t>                 next;                   // states x 256, -1 if not computed yet
+        vector<uint8_t>                 flags;
+        int32_t                         startState = -1;
+        int32_t                         startAtEndState = -1;
+        uint32_t                        flushes = 0;
+        vector<uint32_t>                marks;
+        uint32_t                        generation = 0;
+        vector<int32_t>                 stack;
+        void init ( const vector<RegexInstruction> * prog, bool unanch );
+        void flush ();
+        void fresh ();
+        void closure ( int32_t pc, bool followEos, vector<int32_t> & set );
+        int32_t state ( vector<int32_t> & set );
+        int32_t start ();
+        int32_t startAtEnd ();
+        int32_t compute ( int32_t st, uint8_t ch );
+        __forceinline int32_t step ( int32_t st, uint8_t ch ) {
+            int32_t t = next[(st<<8) | ch];
+            return t>=0 ? t : compute(st, ch);
+        }
+        __forceinline bool isMatch ( int32_t st ) const { return (flags[st] & FLAG_MATCH) != 0; }
+        __forceinline bool isMatchAtEnd ( int32_t st ) const { return (flags[st] & FLAG_MATCH_AT_END) != 0; }
+    };
+
+    class RegexEngine : public ptr_ref_count {
+    public:
+        RegexEngine ( const int32_t * prog, int32_t size, int32_t ngroups );
+        RegexEngine ( const RegexEngine & ) = delete;
+        RegexEngine & operator = ( const RegexEngine & ) = delete;
+        const string & getError() const { return error; }
+        int32_t groupCount() const { return groups; }
+        int32_t match ( const char * str, int32_t len, int32_t offset, range * caps );
+        void foreach ( const char * str, int32_t len, range * caps, const Block & block, Context * context );
+        int32_t dfaStates() const { return int32_t(forward.states.size() + backward.states.size()); }
+    protected:
+        int32_t longest ( const uint8_t * str, int32_t from, int32_t len, int32_t & scanned, bool & unique );
+        int32_t first ( const uint8_t * str, int32_t from, int32_t to, int32_t len, range * caps );
+        void markStarts ( const uint8_t * str, int32_t from, int32_t len, vector<uint64_t> & starts );
+        int32_t candidate ( const char * str, int32_t from, int32_t len ) const;
+    protected:
+        mutex                       lock;           // dfa cache is shared by every context which holds this regex
+        string                      error;
+        int32_t                     groups = 0;
+        vector<RegexInstruction>    program;        // forward, with captures
+        vector<RegexInstruction>    reversed;       // reversed regex, no captures
+        RegexDfa                    forward;
+        RegexDfa                    backward;
+        string                      prefix;         // literal every match starts with
+        string                      firstBytes;     // or one of these few characters
+        uint32_t                    firstSet[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        bool                        canPrefilter = false;
+        // pike vm, for captures and for the priority of alternatives
+        vector<int32_t>             threads[2];
+        vector<int32_t>             slots[2];
+        vector<int32_t>             scratch;
+        vector<uint32_t>            marks;
+        uint32_t                    generation = 0;
+    };
+
+    smart_ptr<RegexEngine> builtin_regex_engine ( const TArray<int32_t> & program, int32_t groups, Context * context );
+    int32_t builtin_regex_engine_match ( const smart_ptr_raw<RegexEngine> engine, const char * str, int32_t offset, TArray<range> & captures, Context * context );
+    void builtin_regex_engine_foreach ( const smart_ptr_raw<RegexEngine> engine, const char * str, TArray<range> & captures, const Block & block, Context * context );
+    int32_t builtin_regex_engine_dfa_states ( const smart_ptr_raw<RegexEngine> engine );
+}
+
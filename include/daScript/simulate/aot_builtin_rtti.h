@@ -90,6 +90,10 @@ namespace das {
 
     char * rtti_get_das_type_name(Type tt, Context * context);
 
+    char * rtti_fusion_profile_report ( uint64_t minCount, Context * context );
+    char * rtti_fusion_profile_source ( uint64_t minCount, Context * context );
+    void rtti_reset_fusion_profile ();
+
     vec4f rtti_contextFunctionInfo ( Context & context, SimNode_CallBase *, vec4f * );
     vec4f rtti_contextVariableInfo ( Context & context, SimNode_CallBase *, vec4f * );
     int32_t rtti_contextTotalFunctions(Context * context);
@@ -31,9 +31,11 @@ namespace das {
     char* builtin_string_slice2 ( const char *str, int start, Context * context );
     char* builtin_string_reverse ( const char *str, Context * context );
     char* builtin_string_tolower ( const char *str, Context * context );
-    char* builtin_string_tolower_in_place ( char* str );
+    // context is optional, so that existing single argument callers still build. without it the length
+    // comes from strlen, and the cached hash in the string header is not reset
+    char* builtin_string_tolower_in_place ( char* str, Context * context = nullptr );
     char* builtin_string_toupper ( const char *str, Context * context );
-    char* builtin_string_toupper_in_place ( char* str );
+    char* builtin_string_toupper_in_place ( char* str, Context * context = nullptr );
     char* builtin_string_chop( const char * str, int start, int length, Context * context );
     unsigned string_to_uint ( const char *str, Context * context );
     int string_to_int ( const char *str, Context * context );
@@ -93,4 +95,44 @@ namespace das {
     __forceinline bool is_white_space ( int32_t ch ) { return  ch==' ' || ch=='\n' || ch=='\r' || ch=='\t'; }
     __forceinline bool is_number ( int32_t ch ) { return (ch>='0' && ch<='9'); }
     __forceinline bool is_new_line ( int32_t ch ) { return ch=='\n' || ch=='\r'; }
+
+    // text of a string or a byte buffer, which is not copied and not null terminated.
+    // view does not own or keep alive the text it points to
+    struct StringView {
+        const char * text;
+        uint32_t     length;
+    };
+
+    template <>
+    struct cast <StringView> {
+        static __forceinline StringView to ( vec4f x )         { union { StringView t; vec4f vec; } T; T.vec = x; return T.t; }
+        static __forceinline vec4f from ( StringView x )       { union { StringView t; vec4f vec; } T; T.vec = v_zero(); T.t = x; return T.vec; }
+    };
+
+    StringView builtin_view ( const char * str, Context * context );
+    StringView builtin_view_bytes ( const TArray<uint8_t> & bytes );
+    char * builtin_view_string ( StringView view, Context * context );
+    int32_t builtin_view_length ( StringView view );
+    bool builtin_view_empty ( StringView view );
+    int32_t builtin_view_character_at ( StringView view, int32_t index, Context * context );
+    StringView builtin_view_slice1 ( StringView view, int32_t start, int32_t end );
+    StringView builtin_view_slice2 ( StringView view, int32_t start );
+    StringView builtin_view_strip ( StringView view );
+    StringView builtin_view_strip_left ( StringView view );
+    StringView builtin_view_strip_right ( StringView view );
+    int32_t builtin_view_find1 ( StringView view, const char * substr, int32_t start, Context * context );
+    int32_t builtin_view_find2 ( StringView view, const char * substr, Context * context );
+    bool builtin_view_starts_with ( StringView view, const char * cmp, Context * context );
+    bool builtin_view_ends_with ( StringView view, const char * cmp, Context * context );
+    bool builtin_view_equ ( StringView a, StringView b );
+    bool builtin_view_nequ ( StringView a, StringView b );
+    bool builtin_view_equ_str ( StringView a, const char * b );
+    bool builtin_view_nequ_str ( StringView a, const char * b );
+    bool builtin_str_equ_view ( const char * a, StringView b );
+    bool builtin_str_nequ_view ( const char * a, StringView b );
+    void builtin_view_split ( StringView view, const char * delim, const Block & sblk, Context * context );
+    int32_t builtin_view_to_int ( StringView view, Context * context );
+    float builtin_view_to_float ( StringView view, Context * context );
+    double builtin_view_to_double ( StringView view, Context * context );
+    void builtin_view_write ( StringBuilderWriter & writer, StringView view );
 }
@@ -10,4 +10,46 @@ namespace das {
     // load ( obj, bytesAt:uint32 )
     vec4f _builtin_binary_load ( Context & context, SimNode_CallBase * call, vec4f * args );
     void _builtin_binary_load ( Context & context, TypeInfo* info, const char *data, uint32_t len, char *to);//
+
+    // sink or source of the streaming serializer
+    class BinaryStream {
+    public:
+        virtual ~BinaryStream() {}
+        virtual uint64_t write ( const void * data, uint64_t size ) = 0;    // returns number of bytes written
+        virtual uint64_t read ( void * data, uint64_t size ) = 0;           // returns number of bytes read
+        // gives back what was read ahead, so that the next object starts right after this one. false if the source can't seek
+        virtual bool unread ( uint64_t size ) { return size==0; }
+    };
+
+    class FileBinaryStream : public BinaryStream {
+    public:
+        FileBinaryStream ( FILE * f ) : file(f) {}
+        virtual uint64_t write ( const void * data, uint64_t size ) override;
+        virtual uint64_t read ( void * data, uint64_t size ) override;
+        virtual bool unread ( uint64_t size ) override;
+    protected:
+        FILE * file = nullptr;
+    };
+
+    class FdBinaryStream : public BinaryStream {
+    public:
+        FdBinaryStream ( int f ) : fd(f) {}
+        virtual uint64_t write ( const void * data, uint64_t size ) override;
+        virtual uint64_t read ( void * data, uint64_t size ) override;
+        virtual bool unread ( uint64_t size ) override;
+    protected:
+        int fd = -1;
+    };
+
+    // streamed format is a header (magic, version, schema hash of the type) followed by the payload.
+    // unlike the in-memory format raw pod arrays are stored in bulk, 16 byte aligned from the start of the stream,
+    // which is what lets binary_map_stream point them straight into a mapped file
+    uint64_t binary_schema_hash ( TypeInfo * info );
+    uint64_t binary_save_stream ( Context & context, BinaryStream & out, vec4f data, TypeInfo * info );
+    // the stream is left right after the loaded object, or where it was if the header does not match
+    bool binary_load_stream ( Context & context, BinaryStream & in, char * data, TypeInfo * info );
+    // pod arrays of the loaded object reference 'bytes' for the duration of the block, and are detached after it.
+    // 'bytes' has to be 16 byte aligned. size of the loaded object goes to 'used', 0 if the header does not match.
+    // returns false if the block or the load did throw, context->exception has the error
+    bool binary_map_stream ( Context & context, char * bytes, uint64_t size, char * data, TypeInfo * info, const Block & block, uint64_t * used = nullptr );
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 namespace das
 {
 
@@ -118,6 +120,8 @@ namespace das
         string  importName;
     };
 
+    class JobQue;
+
     class FileAccess : public ptr_ref_count {
     public:
         virtual ~FileAccess() {}
@@ -127,10 +131,14 @@ namespace das
         void freeSourceData();
         FileInfoPtr letGoOfFileInfo ( const string & fileName );
         virtual ModuleInfo getModuleInfo ( const string & req, const string & from ) const;
+        // loads files, which are not yet known, ahead of time. getNewFileInfo is called from the que workers,
+        // so it has to be thread safe. setFileInfo is. override to load sequentially, or to skip prefetch altogether
+        virtual void prefetchFileInfo ( const vector<string> & fileNames, JobQue & que );
     protected:
         virtual FileInfo * getNewFileInfo ( const string & ) { return nullptr; }
     protected:
         das_hash_map<string, FileInfoPtr>    files;
+        mutex                               filesLock;
     };
     typedef smart_ptr<FileAccess> FileAccessPtr;
     template <> struct isCloneable<FileAccess> : false_type {};
@@ -8,7 +8,16 @@ namespace das {
         return hash_block32((uint8_t *)x, uint32_t(size));
     }
 
-    __forceinline uint32_t stringLength ( Context &, const char * str ) { // str!=nullptr
+    __forceinline StringHeader * stringHeader ( Context & ctx, const char * str ) { // str!=nullptr
+        auto heap = ctx.stringHeap.get();
+        return heap ? heap->header(str) : nullptr;
+    }
+
+    __forceinline uint32_t stringLength ( Context & ctx, const char * str ) { // str!=nullptr
+        if ( auto hdr = stringHeader(ctx, str) ) {
+            if ( hdr->length==StringHeader::lengthUnknown ) hdr->length = uint32_t(strlen(str));
+            return hdr->length;
+        }
         return uint32_t(strlen(str));
     }
 
@@ -21,14 +30,24 @@ namespace das {
         return hash_block32((const uint8_t *)&x, sizeof(x));
     }
 
+    // heap string caches its hash in the header, it is never 0 once computed
+    __forceinline uint32_t stringHash ( Context & ctx, const char * str ) {
+        if ( !str ) return 16777619;
+        if ( auto hdr = stringHeader(ctx, str) ) {
+            if ( !hdr->hash ) hdr->hash = hash_blockz32((uint8_t *)str);
+            return hdr->hash;
+        }
+        return hash_blockz32((uint8_t *)str);
+    }
+
     template <>
-    __forceinline uint32_t hash_function ( Context &, char * str ) {
-        return str ? hash_blockz32((uint8_t *)str) : 16777619;
+    __forceinline uint32_t hash_function ( Context & ctx, char * str ) {
+        return stringHash(ctx, str);
     }
 
     template <>
-    __forceinline uint32_t hash_function ( Context &, const char * str ) {
-        return str ? hash_blockz32((uint8_t *)str) : 16777619;
+    __forceinline uint32_t hash_function ( Context & ctx, const char * str ) {
+        return stringHash(ctx, str);
     }
 
     uint32_t hash_value ( Context & ctx, void * pX, TypeInfo * info );
@@ -131,6 +131,7 @@ namespace das {
         virtual void mark ( char * ptr, uint32_t size ) = 0;
         virtual void sweep() = 0;
         virtual bool isOwnPtr (  char * ptr, uint32_t size ) = 0;
+        virtual char * locate ( char *, uint32_t & ) { return nullptr; }  // allocation, which contains the pointer
         virtual void setInitialSize ( uint32_t size ) = 0;
         virtual int32_t getInitialSize() const = 0;
         virtual void setGrowFunction ( CustomGrowFunction && fun ) = 0;
@@ -169,21 +170,61 @@ namespace das {
 
     typedef das_hash_set<StrHashEntry,StrHashPred,StrEqPred> das_string_set;
 
+    // optional string heap layout, where each string is prefixed with its length and lazily computed hash.
+    // only heaps which can tell their own allocations in O(1) support it. check ties the header to the address
+    // and the size of the allocation. length is strlen, i.e. the same as without the header
+    struct StringHeader {
+        uint32_t    hash;       // 0 until computed
+        uint32_t    length;     // lengthUnknown until computed
+        uint32_t    size;       // allocated text, not counting the terminating zero
+        uint32_t    check;
+        enum : uint32_t { lengthUnknown = ~0u };
+        static __forceinline uint32_t makeCheck ( const char * str, uint32_t size ) {
+            return (uint32_t(uintptr_t(str) >> 2) * 0x9e3779b1u) ^ size ^ 0x5fa1ed00u;
+        }
+    };
+
     class StringHeapAllocator : public AnyHeapAllocator {
     public:
         virtual void forEachString ( const callable<void (const char *)> & fn ) = 0;
         virtual void reset() override;
+        // base is the start of an allocation of this heap (live or not), and capacity is its size. nothing is read from base
+        virtual bool isOwnString ( const char * , uint32_t & ) { return false; }
+        virtual bool canHaveHeader() const { return false; }
     public:
         char * allocateString ( const char * text, uint32_t length );
         char * allocateString ( const string & str );
         void freeString ( char * text, uint32_t length );
         void setIntern ( bool on );
         bool isIntern() const { return needIntern; }
+        void setHeader ( bool on );
+        bool isHeader() const { return needHeader; }
         char * intern ( const char * str, uint32_t length ) const;
         void recognize ( char * str );
+        // header of the string, if it came from this heap. otherwise nullptr
+        // ownership is established first, so that nothing in front of the foreign strings is ever read
+        __forceinline StringHeader * header ( const char * str ) {
+            if ( !needHeader ) return nullptr;
+            auto base = (const char *)(uintptr_t(str) - sizeof(StringHeader));
+            uint32_t capacity = 0;
+            if ( !isOwnString(base, capacity) ) return nullptr;
+            auto hdr = (StringHeader *) base;
+            if ( uint64_t(hdr->size) + sizeof(StringHeader) + 1 > capacity ) return nullptr;
+            if ( hdr->check != StringHeader::makeCheck(str, hdr->size) ) return nullptr;
+            return hdr;
+        }
+        __forceinline uint32_t headerSize() const {
+            return needHeader ? uint32_t(sizeof(StringHeader)) : 0;
+        }
+        // size of the allocation, which holds the string. only for the heap walkers, since it trusts the header blindly
+        __forceinline uint32_t allocationSize ( const char * text ) const {
+            uint32_t size = needHeader ? ((const StringHeader *)(text - sizeof(StringHeader)))->size : uint32_t(strlen(text));
+            return headerSize() + size + 1;
+        }
     protected:
         das_string_set internMap;
         bool needIntern = false;
+        bool needHeader = false;
     };
 
     class PersistentHeapAllocator : public AnyHeapAllocator {
@@ -197,10 +238,11 @@ namespace das {
         virtual uint64_t totalAlignedMemoryAllocated() const override { return model.totalAlignedMemoryAllocated(); }
         virtual void reset() override { model.reset(); }
         virtual void report() override;
-        virtual bool mark() override { return false; }
-        virtual void mark ( char *, uint32_t ) override { DAS_ASSERT(0 && "not supported"); }
+        virtual bool mark() override { model.shoe.beforeGC(); return true; }
+        virtual void mark ( char * ptr, uint32_t size ) override { model.markAllocation(ptr,size); }
         virtual void sweep() override { model.sweep(); }
         virtual bool isOwnPtr ( char * ptr, uint32_t size ) override { return model.isOwnPtr(ptr,size); }
+        virtual char * locate ( char * ptr, uint32_t & size ) override { return model.locate(ptr,size); }
         virtual void setInitialSize ( uint32_t size ) override { model.setInitialSize(size); }
         virtual int32_t getInitialSize() const override { return model.initialSize; }
         virtual void setGrowFunction ( CustomGrowFunction && fun ) override { model.customGrow = fun; };
@@ -269,6 +311,9 @@ namespace das {
         virtual void mark ( char * ptr, uint32_t size ) override;
         virtual void sweep() override;
         virtual bool isOwnPtr ( char * ptr, uint32_t size ) override { return model.isOwnPtr(ptr,size); }
+        virtual bool isOwnString ( const char * base, uint32_t & capacity ) override;
+        virtual bool canHaveHeader() const override { return true; }
+        virtual char * locate ( char * ptr, uint32_t & size ) override { return model.locate(ptr,size); }
         virtual void setInitialSize ( uint32_t size ) override { model.setInitialSize(size); }
         virtual int32_t getInitialSize() const override { return model.initialSize; }
         virtual void setGrowFunction ( CustomGrowFunction && fun ) override { model.customGrow = fun; };
@@ -322,6 +367,12 @@ namespace das {
     public:
         NodeAllocator() {}
 
+        __forceinline void adopt ( NodeAllocator & other ) {
+            LinearChunkAllocator::adopt(other);
+            totalNodesAllocated += other.totalNodesAllocated;
+            other.totalNodesAllocated = 0;
+        }
+
         /*
         * GCC really likes the version with separate if. CLANG \ MSVC strongly prefer the one bellow with __forceinline.
         * This saves ~1.6mb of code on MSVC\CLANG as of 11/23/2020.
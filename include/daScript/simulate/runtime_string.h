@@ -9,6 +9,14 @@ namespace das
 
     string unescapeString ( const string & input, bool * error, bool das_escape = true );
     string escapeString ( const string & input, bool das_escape = true );
+    // byte scanning kernels, 16 bytes at a time. all of them stop at str+len and never read past it
+    const char * find_substring ( const char * str, uint32_t len, const char * substr, uint32_t sublen );
+    const char * find_first_of ( const char * str, uint32_t len, const char * set, uint32_t setLen );
+    const char * find_escape ( const char * str, uint32_t len, bool das_escape );
+    uint32_t escape_string_length ( const char * str, uint32_t len, bool das_escape );
+    char * escape_string_to ( char * dst, const char * str, uint32_t len, bool das_escape );
+    void to_upper_bytes ( char * dst, const char * str, uint32_t len );
+    void to_lower_bytes ( char * dst, const char * str, uint32_t len );
     string to_string_ex ( double dnum );
     string to_string_ex ( float dnum );
     string reportError ( const struct LineInfo & li, const string & message, const string & extra,
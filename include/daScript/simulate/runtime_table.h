@@ -8,10 +8,24 @@ namespace das
 
     // TODO:
     //  -   return correct insert index of original value? is this at all possible?
-    //  -   throw runtime error in the context, when grow inside locked table (recover well)
 
     extern const char * rts_null;
 
+    // probe length of a slot is its distance from the home slot of its hash, plus one
+    struct TableStats {
+        uint32_t    capacity;
+        uint32_t    size;
+        uint32_t    tombstones;
+        uint32_t    max_probe;
+        uint64_t    total_probe;
+        uint32_t    rehashes;
+        uint32_t    incremental_rehashes;
+        uint64_t    rehash_usec;
+        bool        rehashing;
+    };
+
+    void table_stats ( const Table & tab, TableStats & stats );
+
     template <typename KeyType>
     struct KeyCompare {
         __forceinline bool operator () ( const KeyType & a, const KeyType & b ) {
@@ -37,59 +51,225 @@ namespace das
         }
     };
 
-    template <typename KeyType>
-    class TableHash {
-        Context *   context = nullptr;
-        uint32_t    valueTypeSize = 0;
+    // probing, which does not depend on the key type. its shared with the rehash in runtime_table.cpp
+    class TableProbe {
+    public:
         enum {
             minCapacity = 8,
             minLookups = 4
         };
-    public:
-        TableHash () = delete;
-        TableHash ( const TableHash & ) = delete;
-        TableHash ( Context * ctx, uint32_t vs ) : context(ctx), valueTypeSize(vs) {}
 
-        __forceinline uint32_t indexFromHash(uint32_t hash, uint32_t shift ) const {
+        static __forceinline uint32_t indexFromHash(uint32_t hash, uint32_t shift ) {
             return hash >> shift; // i don't know why this is faster, but it is
         }
 
-        __forceinline uint32_t computeShift(uint32_t capacity) {
+        static __forceinline uint32_t computeShift(uint32_t capacity) {
             return __builtin_clz(capacity-1);
         }
 
-        __forceinline uint32_t computeMaxLookups(uint32_t capacity) {
+        static __forceinline uint32_t computeMaxLookups(uint32_t capacity) {
             uint32_t desired = 32 - __builtin_clz(capacity-1);
             return das::max(uint32_t(minLookups), desired * 6);
         }
 
-        __forceinline int find ( const Table & tab, KeyType key, uint32_t hash ) const {
+#if DAS_TABLE_CONTROL_BYTES
+        struct TableGroup {
+            vec4i ctrl;
+            __forceinline TableGroup ( const uint8_t * at ) : ctrl(v_ldui((const int *)at)) {}
+            __forceinline uint32_t match ( uint8_t value ) const {
+                return uint32_t(v_signmaski8(v_cmp_eqi8(ctrl, v_splatsi8(char(value)))));
+            }
+        };
+
+        static __forceinline uint8_t hashTag ( uint32_t hash ) {
+            return uint8_t(hash & 0x7f);
+        }
+
+        static __forceinline uint32_t groupValid ( uint32_t left ) {
+            return left >= TABLE_GROUP ? 0xffffu : (1u << left) - 1;
+        }
+
+        static __forceinline void setControl ( Table & tab, uint32_t index, uint8_t value ) {
+            auto pCtrl = table_control(tab);
+            pCtrl[index] = value;
+            for ( uint32_t mirror = index + tab.capacity; mirror < tab.capacity + TABLE_GROUP; mirror += tab.capacity ) {
+                pCtrl[mirror] = value;
+            }
+        }
+
+        static __forceinline int insertNew ( Table & tab, uint32_t hash ) {
+            uint32_t mask = tab.capacity - 1;
+            uint32_t index = indexFromHash(hash, tab.shift);
+            uint32_t count = tab.maxLookups & mask;
+            auto pCtrl = table_control(tab);
+            for ( uint32_t probed = 0; probed < count; probed += TABLE_GROUP ) {
+                TableGroup group(pCtrl + index);
+                if ( uint32_t empty = group.match(TABLE_CTRL_EMPTY) & groupValid(count - probed) ) {
+                    return (int) ((index + __builtin_ctz(empty)) & mask);
+                }
+                index = (index + TABLE_GROUP) & mask;
+            }
+            return -1;
+        }
+#else
+        static __forceinline int insertNew ( Table & tab, uint32_t hash ) {
+            // TODO: take key under account and be less agressive?
             uint32_t mask = tab.capacity - 1;
             uint32_t index = indexFromHash(hash, tab.shift);
             uint32_t lastI = (index+tab.maxLookups) & mask;
-            auto pKeys = (const KeyType *) tab.keys;
             auto pHashes = tab.hashes;
             while ( index != lastI ) {
                 auto kh = pHashes[index];
                 if ( kh==HASH_EMPTY32 ) {
-                    return -1;
-                } else if ( kh==hash && KeyCompare<KeyType>()(pKeys[index],key) ) {
                     return (int) index;
                 }
                 index = (index + 1) & mask;
             }
             return -1;
         }
+#endif
+    };
 
-        __forceinline int insertNew ( Table & tab, uint32_t hash ) const {
-            // TODO: take key under account and be less agressive?
+    template <typename KeyType>
+    class TableHash : public TableProbe {
+        Context *   context = nullptr;
+        uint32_t    valueTypeSize = 0;
+    public:
+        TableHash () = delete;
+        TableHash ( const TableHash & ) = delete;
+        TableHash ( Context * ctx, uint32_t vs ) : context(ctx), valueTypeSize(vs) {}
+
+        // while the table is rehashing every access migrates a few slots of the previous allocation,
+        // and keys which are not in the new allocation yet are looked up in the previous one
+        __forceinline int find ( const Table & tab, KeyType key, uint32_t hash ) const {
+            if ( tab.rehashing ) {
+                return findRehashing(const_cast<Table &>(tab), key, hash);
+            }
+            return findIn(tab, key, hash);
+        }
+
+        int findRehashing ( Table & tab, KeyType key, uint32_t hash ) const {
+            table_rehash_step(*context, tab, TABLE_REHASH_STEP);
+            int index = findIn(tab, key, hash);
+            if ( index!=-1 || !tab.rehashing ) {
+                return index;
+            }
+            Table old = table_rehash_source(tab);
+            int oldIndex = findIn(old, key, hash);
+            if ( oldIndex==-1 ) {
+                return -1;
+            }
+            index = table_rehash_move(*context, tab, old, oldIndex);
+            if ( index==-1 ) {
+                // only happens with pathological hashes, the new allocation is twice as big as the old one
+                table_rehash_finish(*context, tab);
+                index = findIn(tab, key, hash);
+            }
+            return index;
+        }
+
+#if DAS_TABLE_CONTROL_BYTES
+        // probing visits the same slots as the scalar version, a group at a time. control bytes
+        // of the group are compared to the tag of the hash, and the full hash and key are only checked on a tag hit
+        __forceinline int findIn ( const Table & tab, KeyType key, uint32_t hash ) const {
+            uint32_t mask = tab.capacity - 1;
+            uint32_t index = indexFromHash(hash, tab.shift);
+            uint32_t count = tab.maxLookups & mask;
+            auto pKeys = (const KeyType *) tab.keys;
+            auto pHashes = tab.hashes;
+            auto pCtrl = table_control(tab);
+            uint8_t tag = hashTag(hash);
+            for ( uint32_t probed = 0; probed < count; probed += TABLE_GROUP ) {
+                TableGroup group(pCtrl + index);
+                uint32_t valid = groupValid(count - probed);
+                uint32_t empty = group.match(TABLE_CTRL_EMPTY) & valid;
+                uint32_t before = empty ? (empty & (0u - empty)) - 1 : valid;
+                for ( uint32_t hit = group.match(tag) & before; hit; hit &= hit - 1 ) {
+                    uint32_t i = (index + __builtin_ctz(hit)) & mask;
+                    if ( pHashes[i]==hash && KeyCompare<KeyType>()(pKeys[i],key) ) {
+                        return (int) i;
+                    }
+                }
+                if ( empty ) {
+                    return -1;
+                }
+                index = (index + TABLE_GROUP) & mask;
+            }
+            return -1;
+        }
+
+        __forceinline int reserve ( Table & tab, KeyType key, uint32_t hash ) {
+            if ( tab.rehashing ) {
+                int index = findRehashing(tab, key, hash);
+                if ( index!=-1 ) {
+                    return index;
+                }
+            }
+            uint8_t tag = hashTag(hash);
+            for ( ;; ) {
+                uint32_t mask = tab.capacity - 1;
+                uint32_t index = indexFromHash(hash, tab.shift);
+                uint32_t count = tab.maxLookups & mask;
+                uint32_t insertI = -1u;
+                auto pKeys = (KeyType *) tab.keys;
+                auto pHashes = tab.hashes;
+                auto pCtrl = table_control(tab);
+                for ( uint32_t probed = 0; probed < count; probed += TABLE_GROUP ) {
+                    TableGroup group(pCtrl + index);
+                    uint32_t valid = groupValid(count - probed);
+                    uint32_t empty = group.match(TABLE_CTRL_EMPTY) & valid;
+                    uint32_t before = empty ? (empty & (0u - empty)) - 1 : valid;
+                    for ( uint32_t hit = group.match(tag) & before; hit; hit &= hit - 1 ) {
+                        uint32_t i = (index + __builtin_ctz(hit)) & mask;
+                        if ( pHashes[i]==hash && KeyCompare<KeyType>()(pKeys[i],key) ) {
+                            return (int) i;
+                        }
+                    }
+                    if ( insertI==-1u ) {
+                        if ( uint32_t killed = group.match(TABLE_CTRL_DELETED) & before ) {
+                            insertI = (index + __builtin_ctz(killed)) & mask;
+                        }
+                    }
+                    if ( empty ) {
+                        if ( tab.isLocked() ) context->throw_error("can't insert into locked table");
+                        if ( insertI==-1u ) insertI = (index + __builtin_ctz(empty)) & mask;
+                        pHashes[insertI] = hash;
+                        pKeys[insertI] = key;
+                        setControl(tab, insertI, tag);
+                        tab.size++;
+                        return (int) insertI;
+                    }
+                    index = (index + TABLE_GROUP) & mask;
+                }
+                if ( !grow(tab) ) {
+                    return -1;
+                }
+            }
+        }
+
+        __forceinline int erase ( Table & tab, KeyType key, uint32_t hash ) {
+            int index = find(tab, key, hash);
+            if ( index!=-1 ) {
+                tab.size--;
+                tab.hashes[index] = HASH_KILLED32;
+                setControl(tab, index, TABLE_CTRL_DELETED);
+                memset(tab.data + index*valueTypeSize, 0, valueTypeSize);
+            }
+            return index;
+        }
+
+#else
+        __forceinline int findIn ( const Table & tab, KeyType key, uint32_t hash ) const {
             uint32_t mask = tab.capacity - 1;
             uint32_t index = indexFromHash(hash, tab.shift);
             uint32_t lastI = (index+tab.maxLookups) & mask;
+            auto pKeys = (const KeyType *) tab.keys;
             auto pHashes = tab.hashes;
             while ( index != lastI ) {
                 auto kh = pHashes[index];
                 if ( kh==HASH_EMPTY32 ) {
+                    return -1;
+                } else if ( kh==hash && KeyCompare<KeyType>()(pKeys[index],key) ) {
                     return (int) index;
                 }
                 index = (index + 1) & mask;
@@ -98,6 +278,12 @@ namespace das
         }
 
         __forceinline int reserve ( Table & tab, KeyType key, uint32_t hash ) {
+            if ( tab.rehashing ) {
+                int index = findRehashing(tab, key, hash);
+                if ( index!=-1 ) {
+                    return index;
+                }
+            }
             for ( ;; ) {
                 uint32_t mask = tab.capacity - 1;
                 uint32_t index = indexFromHash(hash, tab.shift);
@@ -128,78 +314,23 @@ namespace das
         }
 
         __forceinline int erase ( Table & tab, KeyType key, uint32_t hash ) {
-            uint32_t mask = tab.capacity - 1;
-            uint32_t index = indexFromHash(hash, tab.shift);
-            uint32_t lastI = (index+tab.maxLookups) & mask;
-            auto pKeys = (const KeyType *) tab.keys;
-            auto pHashes = tab.hashes;
-            while ( index != lastI ) {
-                auto kh = pHashes[index];
-                if ( kh==HASH_EMPTY32 ) {
-                    return -1;
-                } else if ( kh==hash && KeyCompare<KeyType>()(pKeys[index],key) ) {
-                    tab.size--;
-                    pHashes[index] = HASH_KILLED32;
-                    memset(tab.data + index*valueTypeSize, 0, valueTypeSize);
-                    return (int) index;
-                }
-                index = (index + 1) & mask;
+            int index = find(tab, key, hash);
+            if ( index!=-1 ) {
+                tab.size--;
+                tab.hashes[index] = HASH_KILLED32;
+                memset(tab.data + index*valueTypeSize, 0, valueTypeSize);
             }
-            return -1;
+            return index;
         }
 
+#endif
+
         bool grow ( Table & tab ) {
-            uint32_t newCapacity = das::max(uint32_t(minCapacity), tab.capacity*2);
-        repeatIt:;
-            Table newTab;
-            uint32_t memSize = newCapacity * (valueTypeSize + sizeof(KeyType) + sizeof(uint32_t));
-            newTab.data = (char *) context->heap->allocate(memSize);
-            context->heap->mark_comment(newTab.data, "table");
-            if ( !newTab.data ) {
-                context->throw_error("can't grow table, out of heap");
+            if ( tab.isLocked() ) {
+                context->throw_error("can't insert into locked table");
                 return false;
             }
-            newTab.keys = newTab.data + newCapacity * valueTypeSize;
-            newTab.hashes = (uint32_t *)(newTab.keys + newCapacity * sizeof(KeyType));
-            newTab.size = tab.size;
-            newTab.capacity = newCapacity;
-            newTab.lock = tab.lock;
-            newTab.flags = tab.flags;
-            newTab.maxLookups = computeMaxLookups(newCapacity);
-            newTab.shift = computeShift(newCapacity);
-            memset(newTab.data, 0, newCapacity*valueTypeSize);
-            auto pHashes = newTab.hashes;
-            memset(pHashes, 0, newCapacity * sizeof(uint32_t));
-            if ( tab.size ) {
-                auto pKeys = (KeyType *) newTab.keys;
-                auto pOldValues = tab.data;
-                auto pValues = newTab.data;
-                auto pOldKeys = (const KeyType *) tab.keys;
-                auto pOldHashes = tab.hashes;
-                for ( uint32_t i=0; i!=tab.capacity; ++i ) {
-                    auto hash = pOldHashes[i];
-                    if ( hash>HASH_KILLED32 ) {
-                        int index = insertNew(newTab, hash);
-                        if ( index==-1 ) {
-                             newCapacity *= 2;
-                            goto repeatIt;
-                        } else {
-                            pHashes[index] = hash;
-                            pKeys[index] = pOldKeys[i];
-                            memcpy ( pValues + index*valueTypeSize, pOldValues + i*valueTypeSize, valueTypeSize );
-                        }
-                    }
-                }
-            }
-            if (tab.capacity) {
-                uint32_t oldSize = tab.capacity * (valueTypeSize + sizeof(KeyType) + sizeof(uint32_t));
-                context->heap->free(tab.data, oldSize);
-            }
-            swap ( newTab, tab );
-            return true;
+            return table_grow(*context, tab, uint32_t(sizeof(KeyType)), valueTypeSize);
         }
     };
 }
-
-
-
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+#include <atomic>
+
+namespace das {
+
+    // samples script call stack, by walking the prologue chain, from the single step hook of the debugger instrumented code
+    // (options debugger), or from the function entry hook, which instrumentFunctions puts in front of every function otherwise.
+    // sample is taken every N steps (or function entries), and whenever requestSample is called (i.e. from the host timer thread).
+    // call stacks are kept in the prefix tree, so each sample is only a node index and a timestamp.
+    // all counts are in samples, they only turn into time when multiplied by the sampling interval
+    class SamplingProfiler : public ptr_ref_count {
+    public:
+        struct FunctionSamples {
+            string      name;
+            uint64_t    inclusive = 0;      // samples with the function anywhere on the stack
+            uint64_t    exclusive = 0;      // samples with the function on top of the stack
+        };
+    public:
+        SamplingProfiler ( uint32_t every = 0 );
+        void reset();
+        __forceinline void requestSample() { samplePending = true; }
+        __forceinline void setActive ( bool on ) { active = on; }
+        __forceinline bool isActive() const { return active; }
+        // leaf is the function, which has no frame of its own (fastcall)
+        __forceinline void onStep ( Context & context, const LineInfo & at, FuncInfo * leaf = nullptr ) {
+            if ( !active ) return;
+            if ( sampleEvery && ++stepsSinceSample >= sampleEvery ) {
+                stepsSinceSample = 0;
+            } else if ( !samplePending.load(memory_order_relaxed) || !samplePending.exchange(false) ) {
+                return;
+            }
+            sample(context, at, leaf);
+        }
+        void sample ( Context & context, const LineInfo & at, FuncInfo * leaf = nullptr );
+        // wraps code of every function with the entry hook, unless it already is. code is shared with the forked contexts,
+        // so this has to happen before any of them runs. contexts without the sampler only pay for the check
+        static void instrumentFunctions ( Context & context );
+        uint64_t totalSamples() const { return samples.size(); }
+        uint64_t totalUsec() const { return elapsedUsec; }
+        vector<FunctionSamples> getFunctionSamples() const;
+        void writeReport ( TextWriter & tout ) const;
+        void writeCollapsedStacks ( TextWriter & tout ) const;
+        void writeChromeTrace ( TextWriter & tout ) const;
+    protected:
+        struct StackNode {
+            uint32_t    parent = 0;
+            uint32_t    function = 0;
+            uint64_t    self = 0;
+        };
+        struct TimedSample {
+            uint32_t    node;
+            int64_t     usec;
+        };
+        uint32_t getFunction ( FuncInfo * info );
+        uint32_t getChild ( uint32_t parent, uint32_t function );
+        void getPath ( uint32_t node, vector<uint32_t> & path ) const;
+    protected:
+        uint32_t                            sampleEvery = 0;
+        uint32_t                            stepsSinceSample = 0;
+        atomic<bool>                        samplePending;
+        bool                                active = true;
+        int64_t                             lastTicks = 0;
+        int64_t                             elapsedUsec = 0;
+        vector<string>                      functions;
+        das_hash_map<void *,uint32_t>       functionIndex;  // FuncInfo -> function
+        vector<StackNode>                   nodes;          // node 0 is the root
+        das_hash_map<uint64_t,uint32_t>     children;       // parent<<32 | function -> node
+        vector<TimedSample>                 samples;
+        vector<FuncInfo *>                  frames;
+    };
+    typedef smart_ptr<SamplingProfiler> SamplingProfilerPtr;
+}
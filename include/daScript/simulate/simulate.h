@@ -40,6 +40,8 @@ namespace das
     #endif
 
     class Context;
+    class SamplingProfiler;
+    struct DataWalker;
     struct SimNode;
     struct Block;
     struct SimVisitor;
@@ -59,6 +61,14 @@ namespace das
         };
     };
 
+    struct HeapCollectStats {
+        uint64_t    collections = 0;
+        uint64_t    heapBytesFreed = 0;
+        uint64_t    stringBytesFreed = 0;
+        uint64_t    lastUsec = 0;
+        uint64_t    totalUsec = 0;
+    };
+
     struct SimFunction {
         char *      name;
         char *      mangledName;
@@ -72,6 +82,8 @@ namespace das
             struct {
                 bool    aot : 1;
                 bool    fastcall : 1;
+                bool    bytecode : 1;       // code is SimNode_Bytecode
+                bool    sampled : 1;        // code is wrapped with the sampling profiler entry hook
             };
         };
     };
@@ -338,6 +350,9 @@ namespace das
         void stackWalk ( const LineInfo * at, bool showArguments, bool showLocalVariables );
         string getStackWalk ( const LineInfo * at, bool showArguments, bool showLocalVariables, bool showOutOfScope = false, bool stackTopOnly = false );
         void runInitScript ();
+        bool makeGlobalsImage ( bool withInitFunctions = false );
+        bool hasGlobalsImage () const { return globalsImage!=nullptr; }
+        void initGlobals ();
 
         virtual void to_out ( const char * message );           // output to stdout or equivalent
         virtual void to_err ( const char * message );           // output to stderr or equivalent
@@ -559,6 +574,11 @@ namespace das
 
         void relocateCode();
         void collectStringHeap(LineInfo * at);
+        void collectHeap(LineInfo * at, bool stringHeap);
+        const HeapCollectStats & getHeapCollectStats() const { return gcStats; }
+    protected:
+        void walkGcRoots(DataWalker & walker, LineInfo * at);
+    public:
 
         uint64_t getSharedMemorySize() const;
         uint64_t getUniqueMemorySize() const;
@@ -571,6 +591,7 @@ namespace das
         char * intern ( const char * str );
 
         void bpcallback ( const LineInfo & at );
+        void sampleStep ( const LineInfo & at );
 
 #define DAS_SINGLE_STEP(context,at,forceStep) \
     context.singleStep(at,forceStep);
@@ -582,9 +603,13 @@ namespace das
                     bpcallback(at);
                 }
             }
+            if ( sampler ) {
+                sampleStep(at);
+            }
         }
 
         __forceinline void setSingleStep ( bool step ) { singleStepMode = step; }
+        __forceinline bool isDebugger() const { return debugger; }
 
     public:
         uint64_t *                      annotationData = nullptr;
@@ -619,10 +644,14 @@ namespace das
         int totalVariables = 0;
         int totalFunctions = 0;
         SimNode * aotInitScript = nullptr;
+        shared_ptr<vector<char>> globalsImage;
+        HeapCollectStats gcStats;
     protected:
         bool        debugger = false;
         bool        singleStepMode = false;
         const LineInfo * singleStepAt = nullptr;
+    public:
+        smart_ptr<SamplingProfiler> sampler;
     public:
         uint32_t *  tabMnLookup = nullptr;
         uint32_t    tabMnMask = 0;
@@ -680,8 +709,6 @@ namespace das
         StackAllocator *saveLastContextStack = nullptr;
     };
 
-    struct DataWalker;
-
     struct Iterator {
         virtual ~Iterator() {}
         virtual bool first ( Context & context, char * value ) = 0;
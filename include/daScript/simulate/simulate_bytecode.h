@@ -0,0 +1,71 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+namespace das
+{
+    // register bytecode. registers are 32-bit slots in the function stack frame, after the prologue and the copy of the arguments.
+    // 'K' variants take an immediate as the last operand. conditional jumps jump when the condition holds
+#define DAS_BYTECODE_OPS(X) \
+    X(Mov)  X(Ldi) \
+    X(Add)  X(Sub)  X(Mul)  X(Div)  X(Mod)  X(And)  X(Or)   X(Xor)  X(Shl)  X(Shr) \
+    X(AddK) X(SubK) X(MulK) X(DivK) X(ModK) X(AndK) X(OrK)  X(XorK) X(ShlK) X(ShrK) \
+    X(Eq)   X(Ne)   X(Lt)   X(Le)   X(Gt)   X(Ge) \
+    X(EqK)  X(NeK)  X(LtK)  X(LeK)  X(GtK)  X(GeK) \
+    X(Neg)  X(Not)  X(BNot) \
+    X(Jmp)  X(Jz)   X(Jnz) \
+    X(JEq)  X(JNe)  X(JLt)  X(JLe)  X(JGt)  X(JGe) \
+    X(JEqK) X(JNeK) X(JLtK) X(JLeK) X(JGtK) X(JGeK) \
+    X(ForNext) \
+    X(Call) X(Ret)  X(RetVoid)
+
+    enum class BcOp : int32_t {
+#define DAS_BYTECODE_ENUM(name) name,
+        DAS_BYTECODE_OPS(DAS_BYTECODE_ENUM)
+#undef DAS_BYTECODE_ENUM
+        count
+    };
+
+    const char * getBcOpName ( BcOp op );
+
+    struct BcInstr {
+        BcOp    op;
+        int32_t a, b, c;
+    };
+
+    struct BcCall {
+        int32_t     fnIndex;
+        int32_t     argStart;   // arguments are in consecutive registers
+        int32_t     argCount;
+        bool        boolResult;
+        LineInfo    at;
+    };
+
+    // function body, lowered to the register bytecode. replaces SimFunction::code
+    struct SimNode_Bytecode : SimNode {
+        enum { maxCallArguments = 16 };
+        SimNode_Bytecode ( const LineInfo & at ) : SimNode(at) {}
+        virtual SimNode * copyNode ( Context & context, NodeAllocator * code ) override;
+        virtual SimNode * visit ( SimVisitor & vis ) override;
+        virtual vec4f eval ( Context & context ) override;
+        int32_t run ( Context & context, int32_t * R );     // arguments are already in the first registers
+        vec4f callTree ( Context & context, const BcCall & cs, SimFunction * fn, const int32_t * R );
+        static __forceinline vec4f * frameArguments ( char * frame ) {
+            return (vec4f *)(frame + sizeof(Prologue));
+        }
+        __forceinline int32_t * frameRegisters ( char * frame ) const {
+            return (int32_t *)(frame + sizeof(Prologue) + argCount * sizeof(vec4f));
+        }
+        BcInstr *   instructions = nullptr;
+        BcCall *    calls = nullptr;
+        uint32_t    codeSize = 0;
+        uint32_t    callCount = 0;
+        uint32_t    registerCount = 0;
+        uint32_t    argCount = 0;
+        uint32_t    boolArgs = 0;       // bit per argument, bool arguments are normalized to 0 or 1
+        int32_t     fnIndex = -1;
+        bool        ownFrame = false;   // [fastcall] functions are called without the stack frame
+    };
+
+    void printBytecode ( TextWriter & ss, const SimNode_Bytecode * node );
+}
@@ -72,7 +72,7 @@ namespace das {
         virtual SimNode * match(const SimNodeInfoLookup &, SimNode *, SimNode *, SimNode *, Context *) = 0;
         virtual void set(SimNode_Op2Fusion * result, SimNode * node) = 0;
         virtual SimNode * fuseOp2(const SimNodeInfoLookup & info, SimNode * node, SimNode * node_l, SimNode * node_r, Context * context);
-        bool anyLeft, anyRight;
+        static thread_local bool anyLeft, anyRight;    // set by match. per thread, functions are fused in parallel
     };
 
 
@@ -80,6 +80,8 @@ namespace das {
     void resetFusionEngine();
     void createFusionEngine();
     void registerFusion ( const char * OpName, const char * CTypeName, FusionPoint * node );
+    // fusion points generated from the fusion profile, registered after the handwritten ones
+    void createFusionEngine_profiled();
 
 #if DAS_FUSION
     // fusion engine subsections
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+#include <mutex>
+#include <deque>
+
+namespace das {
+
+    // execution counts of parent / child node pairs, and of two operand nodes together with both operands (triples).
+    // collected from the code which is left after fusion (options profile_fusion), i.e. from what fusion engine did not match.
+    // counts are shared by every program simulated in the process, so that a whole corpus of scripts can be profiled in one run.
+    // counters are not atomic, profiled code which runs on several threads at once gets approximate counts
+    class FusionProfile {
+    public:
+        struct Entry {
+            string      op;                 // parent
+            string      typeName;
+            string      slot;               // pair only, i.e. l or subexpr
+            string      lname, ltype;       // child of the pair, or left operand of the triple
+            string      rname, rtype;       // right operand of the triple
+            bool        triple = false;
+            uint64_t    count = 0;
+        };
+    public:
+        uint64_t * pair ( const string & op, const string & typeName, const string & slot,
+            const string & child, const string & childType );
+        uint64_t * triple ( const string & op, const string & typeName,
+            const string & lname, const string & ltype, const string & rname, const string & rtype );
+        void reset();       // zeroes the counters. instrumented code points to them, so entries are never freed
+        void writeReport ( TextWriter & tout, uint64_t minCount = 1 ) const;
+        // c++ source with fusion points for the hot triples, which can be made of the existing op2 superinstructions.
+        // it defines createFusionEngine_profiled, and replaces src/simulate/simulate_fusion_profiled.cpp
+        void writeFusionSource ( TextWriter & tout, uint64_t minCount = 1 ) const;
+    protected:
+        uint64_t * getCounter ( const string & key, Entry && entry );
+        vector<const Entry *> sorted ( bool triples, uint64_t minCount ) const;
+    protected:
+        mutable mutex                   lock;
+        deque<Entry>                    entries;
+        das_hash_map<string,Entry *>    lookup;
+    };
+
+    FusionProfile & getFusionProfile();
+}
@@ -56,6 +56,8 @@ VECMATH_FINLINE vec4i VECTORCALL v_splat_wi(vec4i a);
 VECMATH_FINLINE vec4f VECTORCALL v_splats(float a);
 VECMATH_FINLINE vec4i VECTORCALL v_splatsi(int a);
 VECMATH_FINLINE vec4i VECTORCALL v_splatsi64(int64_t a);
+//! all 16 bytes = a
+VECMATH_FINLINE vec4i VECTORCALL v_splatsi8(char a);
 
 //! .xyzw = {x y z w}
 VECMATH_FINLINE vec4f VECTORCALL v_make_vec4f(float x, float y, float z, float w);
@@ -82,6 +84,8 @@ VECMATH_FINLINE vec4f VECTORCALL v_merge_lw(vec4f a, vec4f b);
 
 //! return signbit mask for each compnent - 1|2|4|8. ith bit is ith float signbit
 VECMATH_FINLINE int VECTORCALL v_signmask(vec4f a);
+//! return signbit mask for each of 16 bytes. ith bit is ith byte signbit
+VECMATH_FINLINE int VECTORCALL v_signmaski8(vec4i a);
 
 //! component-wise comparison: for C={xyzw}  .C = a.C==b.C ? 0xFFFFFFFF : 0
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq(vec4f a, vec4f b);
@@ -94,6 +98,10 @@ VECMATH_FINLINE vec4f VECTORCALL v_cmp_ge(vec4f a, vec4f b);
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_gt(vec4f a, vec4f b);
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti(vec4i a, vec4i b);
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_lti(vec4i a, vec4i b);
+//! byte-wise comparison, for 16 bytes: .B = a.B==b.B ? 0xFF : 0
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_eqi8(vec4i a, vec4i b);
+//! signed byte-wise comparison, for 16 bytes: .B = a.B>b.B ? 0xFF : 0
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti8(vec4i a, vec4i b);
 
 //! a & b
 VECMATH_FINLINE vec4f VECTORCALL v_and(vec4f a, vec4f b);
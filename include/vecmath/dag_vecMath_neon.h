@@ -32,6 +32,7 @@ VECMATH_FINLINE vec4i VECTORCALL v_splat_wi(vec4i a) { return vdupq_lane_s32(vge
 
 VECMATH_FINLINE vec4f VECTORCALL v_splats(float a) { return vmovq_n_f32(a); }
 VECMATH_FINLINE vec4i VECTORCALL v_splatsi(int a) {return vmovq_n_s32(a);}
+VECMATH_FINLINE vec4i VECTORCALL v_splatsi8(char a) {return vreinterpretq_s32_s8(vdupq_n_s8(a));}
 VECMATH_FINLINE vec4i VECTORCALL v_splatsi64(int64_t a) {return vreinterpretq_s32_s64(vmovq_n_s64(a));}
 VECMATH_FINLINE vec4f VECTORCALL v_make_vec4f(float x, float y, float z, float w) { return (vec4f){x, y, z, w}; }
 VECMATH_FINLINE vec4i VECTORCALL v_make_vec4i(int x, int y, int z, int w)
@@ -74,6 +75,16 @@ VECMATH_FINLINE int VECTORCALL v_signmask(vec4f V)
   #endif
 }
 
+VECMATH_FINLINE int VECTORCALL v_signmaski8(vec4i a)
+{
+  static const uint8x16_t movemask = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+  uint8x16_t t0 = vandq_u8(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_s32(a), 7)), movemask);
+  uint8x8_t t1 = vpadd_u8(vget_low_u8(t0), vget_high_u8(t0));
+  t1 = vpadd_u8(t1, t1);
+  t1 = vpadd_u8(t1, t1);
+  return vget_lane_u8(t1, 0) | (vget_lane_u8(t1, 1) << 8);
+}
+
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq(vec4f a, vec4f b) { return (vec4f)vceqq_f32(a, b); }
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq_w(vec4f a, vec4f b) { return (vec4f)vceqq_s32((vec4i)a, (vec4i)b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_eqi(vec4i a, vec4i b) { return (vec4i)vceqq_s32(a, b); }
@@ -81,6 +92,8 @@ VECMATH_FINLINE vec4f VECTORCALL v_cmp_ge(vec4f a, vec4f b) { return (vec4f)vcge
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_gt(vec4f a, vec4f b) { return (vec4f)vcgtq_f32(a, b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_lti(vec4i a, vec4i b) { return (vec4i)vcltq_s32(a, b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti(vec4i a, vec4i b) { return (vec4i)vcgtq_s32(a, b); }
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_eqi8(vec4i a, vec4i b) { return vreinterpretq_s32_u8(vceqq_s8(vreinterpretq_s8_s32(a), vreinterpretq_s8_s32(b))); }
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti8(vec4i a, vec4i b) { return vreinterpretq_s32_u8(vcgtq_s8(vreinterpretq_s8_s32(a), vreinterpretq_s8_s32(b))); }
 
 VECMATH_FINLINE vec4f VECTORCALL v_and(vec4f a, vec4f b) { return (vec4f)vandq_s32((vec4i)a, (vec4i)b); }
 VECMATH_FINLINE vec4f VECTORCALL v_andnot(vec4f a, vec4f b) { return (vec4f)vandq_s32(vmvnq_s32((vec4i)a), (vec4i)b); }
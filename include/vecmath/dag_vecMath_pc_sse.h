@@ -51,6 +51,7 @@ VECMATH_FINLINE vec4f VECTORCALL v_msbit() { return (vec4f&)V_CI_SIGN_MASK; }
 VECMATH_FINLINE vec4f VECTORCALL v_splat4(const float *a) { return _mm_load1_ps(a); }
 VECMATH_FINLINE vec4f VECTORCALL v_splats(float a) {return _mm_set1_ps(a);}//_mm_set_ps1(a) is slower...
 VECMATH_FINLINE vec4i VECTORCALL v_splatsi(int a) {return _mm_set1_epi32(a);}
+VECMATH_FINLINE vec4i VECTORCALL v_splatsi8(char a) {return _mm_set1_epi8(a);}
 
 
 #if defined(DAGOR_ASAN_ENABLED) && defined(__GNUC__) && __GNUC__ >= 7
@@ -138,6 +139,7 @@ VECMATH_FINLINE vec4f VECTORCALL v_merge_hw(vec4f a, vec4f b) { return _mm_unpac
 VECMATH_FINLINE vec4f VECTORCALL v_merge_lw(vec4f a, vec4f b) { return _mm_unpackhi_ps(a, b); }
 
 VECMATH_FINLINE int VECTORCALL v_signmask(vec4f a) { return _mm_movemask_ps(a); }
+VECMATH_FINLINE int VECTORCALL v_signmaski8(vec4i a) { return _mm_movemask_epi8(a); }
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq(vec4f a, vec4f b) { return _mm_cmpeq_ps(a, b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_eqi(vec4i a, vec4i b) { return _mm_cmpeq_epi32(a, b); }
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq_w(vec4f a, vec4f b)
@@ -148,6 +150,8 @@ VECMATH_FINLINE vec4f VECTORCALL v_cmp_eq_w(vec4f a, vec4f b)
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_ge(vec4f a, vec4f b) { return _mm_cmpge_ps(a, b); }
 VECMATH_FINLINE vec4f VECTORCALL v_cmp_gt(vec4f a, vec4f b) { return _mm_cmpgt_ps(a, b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_lti(vec4i a, vec4i b) { return _mm_cmplt_epi32(a, b); }
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_eqi8(vec4i a, vec4i b) { return _mm_cmpeq_epi8(a, b); }
+VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti8(vec4i a, vec4i b) { return _mm_cmpgt_epi8(a, b); }
 VECMATH_FINLINE vec4i VECTORCALL v_cmp_gti(vec4i a, vec4i b) { return _mm_cmpgt_epi32(a, b); }
 VECMATH_FINLINE vec4f VECTORCALL v_and(vec4f a, vec4f b) { return _mm_and_ps(a,b); }
 VECMATH_FINLINE vec4f VECTORCALL v_andnot(vec4f a, vec4f b) { return _mm_andnot_ps(a,b); }
@@ -549,8 +549,7 @@ namespace das {
                     var->init->visit(vstr);
                 }
             }
-            for (auto & pf : pm->functions) {
-                auto & func = pf.second;
+            for (auto & func : pm->scriptFunctions()) {
                 if (func->used) {
                     func->visit(vstr);
                 }
@@ -580,8 +579,7 @@ namespace das {
             logs << "FUNCTION TABLE:\n";
         }
         for (auto & pm : library.modules) {
-            for (auto & pf : pm->functions) {
-                auto & func = pf.second;
+            for (auto & func : pm->scriptFunctions()) {
                 if (func->used) {
                     func->index = totalFunctions++;
                     if ( log ) {
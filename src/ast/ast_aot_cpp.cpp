@@ -3178,8 +3178,7 @@ namespace das {
     void Program::registerAotCpp ( TextWriter & logs, Context & context, bool headers ) {
         vector<Function *> fnn; fnn.reserve(totalFunctions);
         for (auto & pm : library.modules) {
-            for (auto & it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used)
                     continue;
                 fnn.push_back(pfun.get());
@@ -3232,8 +3231,7 @@ namespace das {
         // compute semantic hash for each used function
         int fni = 0;
         for (auto & pm : library.modules) {
-            for (auto & it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used)
                     continue;
                 SimFunction * fn = context.getFunction(fni);
@@ -3244,8 +3242,7 @@ namespace das {
         // compute AOT hash for each used function
         // its the same as semantic hash, only takes dependencies into account
         for (auto & pm : library.modules) {
-            for (auto & it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used)
                     continue;
                 pfun->aotHash = getFunctionAotHash(pfun.get());
@@ -0,0 +1,545 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/ast/ast_expressions.h"
+#include "daScript/simulate/simulate_bytecode.h"
+
+namespace das {
+
+    // lowers functions, which only operate on int and bool values, to the register bytecode.
+    // arguments occupy the first registers, locals and temporaries are allocated on top of them and released at the end of the scope.
+    // anything outside of that subset (other types, globals, blocks, non-operator builtin calls) keeps the function on the tree interpreter
+    class BytecodeLowering {
+    public:
+        bool lower ( Function * fn ) {
+            if ( fn->builtIn || fn->generator || fn->lambda || !fn->body || !fn->body->rtti_isBlock() ) return false;
+            if ( fn->arguments.size() > SimNode_Bytecode::maxCallArguments ) return false;
+            if ( !fn->result->isVoid() && !isScalarValue(fn->result.get()) ) return false;
+            for ( auto & arg : fn->arguments ) {
+                if ( !isScalarValue(arg->type.get()) ) return false;
+                if ( arg->type->baseType==Type::tBool ) boolArgs |= 1u << argCount;
+                argCount ++;
+            }
+            top = maxTop = argCount;
+            statement(fn->body.get());
+            emit(BcOp::RetVoid);
+            return !failed;
+        }
+        SimNode_Bytecode * makeNode ( Context & context, Function * fn ) const {
+            auto node = context.code->makeNode<SimNode_Bytecode>(fn->at);
+            node->codeSize = uint32_t(code.size());
+            node->instructions = (BcInstr *) context.code->allocate(node->codeSize * sizeof(BcInstr));
+            memcpy ( node->instructions, code.data(), node->codeSize * sizeof(BcInstr) );
+            node->callCount = uint32_t(calls.size());
+            if ( node->callCount ) {
+                node->calls = (BcCall *) context.code->allocate(node->callCount * sizeof(BcCall));
+                memcpy ( node->calls, calls.data(), node->callCount * sizeof(BcCall) );
+            }
+            node->registerCount = uint32_t(maxTop);
+            node->argCount = argCount;
+            node->boolArgs = boolArgs;
+            node->fnIndex = fn->index;
+            node->ownFrame = fn->fastCall;
+            return node;
+        }
+        uint32_t frameSize() const {
+            return (uint32_t(sizeof(Prologue)) + argCount * uint32_t(sizeof(vec4f)) + uint32_t(maxTop) * uint32_t(sizeof(int32_t)) + 15) & ~15u;
+        }
+    protected:
+        struct Loop {
+            vector<int32_t> breaks;
+            vector<int32_t> continues;
+        };
+        vector<BcInstr>                 code;
+        vector<BcCall>                  calls;
+        das_hash_map<Variable *,int32_t> vars;
+        vector<Loop>                    loops;
+        uint32_t                        argCount = 0;
+        uint32_t                        boolArgs = 0;
+        int32_t                         top = 0;
+        int32_t                         maxTop = 0;
+        bool                            failed = false;
+    protected:
+        static bool isScalar ( TypeDecl * type ) {
+            return type && type->dim.empty() && (type->baseType==Type::tInt || type->baseType==Type::tBool);
+        }
+        static bool isScalarValue ( TypeDecl * type ) {
+            return isScalar(type) && !type->ref;
+        }
+        static bool isBuiltinOperator ( ExprOp * op ) {
+            return op->func && op->func->builtIn && op->func->module && op->func->module->name=="$";
+        }
+        static bool isConstant ( Expression * expr, int32_t & value ) {
+            if ( !expr->rtti_isConstant() ) return false;
+            auto ec = (ExprConst *) expr;
+            if ( ec->baseType==Type::tInt ) {
+                value = ec->cvalue<int32_t>();
+                return true;
+            } else if ( ec->baseType==Type::tBool ) {
+                value = ec->cvalue<bool>() ? 1 : 0;
+                return true;
+            }
+            return false;
+        }
+        static BcOp binaryOp ( const string & op, Type baseType ) {
+            if ( baseType==Type::tBool ) {
+                if ( op=="==" ) return BcOp::Eq;
+                if ( op=="!=" || op=="^^" ) return BcOp::Ne;
+                return BcOp::count;
+            }
+            if ( op=="+" ) return BcOp::Add;
+            if ( op=="-" ) return BcOp::Sub;
+            if ( op=="*" ) return BcOp::Mul;
+            if ( op=="/" ) return BcOp::Div;
+            if ( op=="%" ) return BcOp::Mod;
+            if ( op=="&" ) return BcOp::And;
+            if ( op=="|" ) return BcOp::Or;
+            if ( op=="^" ) return BcOp::Xor;
+            if ( op=="<<" ) return BcOp::Shl;
+            if ( op==">>" ) return BcOp::Shr;
+            if ( op=="==" ) return BcOp::Eq;
+            if ( op=="!=" ) return BcOp::Ne;
+            if ( op=="<" ) return BcOp::Lt;
+            if ( op=="<=" ) return BcOp::Le;
+            if ( op==">" ) return BcOp::Gt;
+            if ( op==">=" ) return BcOp::Ge;
+            return BcOp::count;
+        }
+        static bool isCompare ( BcOp op ) {
+            return op>=BcOp::Eq && op<=BcOp::Ge;
+        }
+        static BcOp immediateOp ( BcOp op ) {
+            if ( isCompare(op) ) return BcOp(int32_t(op) - int32_t(BcOp::Eq) + int32_t(BcOp::EqK));
+            return BcOp(int32_t(op) - int32_t(BcOp::Add) + int32_t(BcOp::AddK));
+        }
+        static BcOp jumpOp ( BcOp cmp, bool when, bool immediate ) {
+            if ( !when ) {
+                switch ( cmp ) {
+                    case BcOp::Eq:  cmp = BcOp::Ne; break;
+                    case BcOp::Ne:  cmp = BcOp::Eq; break;
+                    case BcOp::Lt:  cmp = BcOp::Ge; break;
+                    case BcOp::Le:  cmp = BcOp::Gt; break;
+                    case BcOp::Gt:  cmp = BcOp::Le; break;
+                    default:        cmp = BcOp::Lt; break;
+                }
+            }
+            return BcOp(int32_t(cmp) - int32_t(BcOp::Eq) + int32_t(immediate ? BcOp::JEqK : BcOp::JEq));
+        }
+        int32_t fail() {
+            failed = true;
+            return -1;
+        }
+        int32_t here() const {
+            return int32_t(code.size());
+        }
+        int32_t emit ( BcOp op, int32_t a = 0, int32_t b = 0, int32_t c = 0 ) {
+            code.push_back({op, a, b, c});
+            return int32_t(code.size()) - 1;
+        }
+        int32_t allocRegister() {
+            int32_t reg = top++;
+            maxTop = das::max(maxTop, top);
+            return reg;
+        }
+        int32_t place ( int32_t reg, int32_t dst ) {
+            if ( reg<0 || dst<0 || reg==dst ) return reg;
+            emit(BcOp::Mov, dst, reg);
+            return dst;
+        }
+        void patch ( int32_t at, int32_t target ) {
+            auto & ins = code[at];
+            switch ( ins.op ) {
+                case BcOp::Jmp: ins.a = target; break;
+                case BcOp::Jz:
+                case BcOp::Jnz: ins.b = target; break;
+                default:        ins.c = target; break;
+            }
+        }
+        void patch ( const vector<int32_t> & fixups, int32_t target ) {
+            for ( auto at : fixups ) {
+                patch(at, target);
+            }
+        }
+        int32_t variable ( Expression * expr ) {
+            if ( !expr->rtti_isVar() ) return fail();
+            auto var = (ExprVar *) expr;
+            if ( var->block || !isScalar(var->variable->type.get()) ) return fail();
+            if ( var->argument ) return var->argumentIndex;
+            if ( var->local ) {
+                auto it = vars.find(var->variable.get());
+                if ( it != vars.end() ) return it->second;
+            }
+            return fail();
+        }
+        // jumps, when the condition is equal to 'when'
+        void jumpIf ( Expression * cond, bool when, vector<int32_t> & fixups ) {
+            if ( failed ) return;
+            if ( cond->rtti_isOp1() && isBuiltinOperator((ExprOp *)cond) && ((ExprOp1 *)cond)->op=="!" ) {
+                jumpIf(((ExprOp1 *)cond)->subexpr.get(), !when, fixups);
+                return;
+            }
+            if ( cond->rtti_isOp2() && !strcmp(cond->__rtti,"ExprOp2") && isBuiltinOperator((ExprOp *)cond) ) {
+                auto op2 = (ExprOp2 *) cond;
+                if ( op2->op=="&&" || op2->op=="||" ) {
+                    bool isAnd = op2->op=="&&";
+                    if ( isAnd != when ) {
+                        jumpIf(op2->left.get(), when, fixups);
+                        jumpIf(op2->right.get(), when, fixups);
+                    } else {
+                        vector<int32_t> skip;
+                        jumpIf(op2->left.get(), !when, skip);
+                        jumpIf(op2->right.get(), when, fixups);
+                        patch(skip, here());
+                    }
+                    return;
+                }
+                if ( isScalar(op2->left->type.get()) ) {
+                    BcOp cmp = binaryOp(op2->op, op2->left->type->baseType);
+                    if ( isCompare(cmp) ) {
+                        int32_t mark = top;
+                        int32_t lreg = value(op2->left.get());
+                        int32_t k;
+                        if ( isConstant(op2->right.get(), k) ) {
+                            fixups.push_back(emit(jumpOp(cmp, when, true), lreg, k, -1));
+                        } else {
+                            int32_t rreg = value(op2->right.get());
+                            fixups.push_back(emit(jumpOp(cmp, when, false), lreg, rreg, -1));
+                        }
+                        top = mark;
+                        return;
+                    }
+                }
+            }
+            int32_t mark = top;
+            int32_t reg = value(cond);
+            fixups.push_back(emit(when ? BcOp::Jnz : BcOp::Jz, reg, -1));
+            top = mark;
+        }
+        int32_t binary ( BcOp op, Expression * left, Expression * right, int32_t dst ) {
+            int32_t res = dst>=0 ? dst : allocRegister();
+            int32_t mark = top;
+            int32_t lreg = value(left);
+            int32_t k;
+            if ( isConstant(right, k) && !((op==BcOp::Div || op==BcOp::Mod) && k==0) ) {
+                emit(immediateOp(op), res, lreg, k);
+            } else {
+                int32_t rreg = value(right);
+                emit(op, res, lreg, rreg);
+            }
+            top = mark;
+            return res;
+        }
+        // result is computed in the fresh register, destination can be read by either branch
+        int32_t logical ( ExprOp2 * op2, int32_t dst ) {
+            int32_t res = allocRegister();
+            value(op2->left.get(), res);
+            int32_t skip = emit(op2->op=="&&" ? BcOp::Jz : BcOp::Jnz, res, -1);
+            value(op2->right.get(), res);
+            patch(skip, here());
+            return place(res, dst);
+        }
+        int32_t call ( ExprCall * call, int32_t dst, bool discard ) {
+            auto fn = call->func;
+            if ( !fn || fn->builtIn || fn->index<0 ) return fail();
+            if ( call->arguments.size()!=fn->arguments.size() ) return fail();
+            if ( call->arguments.size() > SimNode_Bytecode::maxCallArguments ) return fail();
+            bool isVoid = fn->result->isVoid();
+            if ( !isVoid && !isScalarValue(fn->result.get()) ) return fail();
+            if ( isVoid && !discard ) return fail();
+            for ( auto & arg : fn->arguments ) {
+                if ( !isScalarValue(arg->type.get()) ) return fail();
+            }
+            int32_t res = isVoid || discard ? -1 : (dst>=0 ? dst : allocRegister());
+            int32_t mark = top;
+            int32_t argStart = top;
+            int32_t nArgs = int32_t(call->arguments.size());
+            for ( int32_t i=0; i!=nArgs; ++i ) {
+                allocRegister();
+            }
+            for ( int32_t i=0; i!=nArgs; ++i ) {
+                value(call->arguments[i].get(), argStart + i);
+            }
+            BcCall cs;
+            cs.fnIndex = fn->index;
+            cs.argStart = argStart;
+            cs.argCount = nArgs;
+            cs.boolResult = !isVoid && fn->result->baseType==Type::tBool;
+            cs.at = call->at;
+            emit(BcOp::Call, res, int32_t(calls.size()));
+            calls.push_back(cs);
+            top = mark;
+            return res;
+        }
+        int32_t value ( Expression * expr, int32_t dst = -1 ) {
+            if ( failed ) return -1;
+            int32_t k;
+            if ( isConstant(expr, k) ) {
+                int32_t res = dst>=0 ? dst : allocRegister();
+                emit(BcOp::Ldi, res, k);
+                return res;
+            } else if ( expr->rtti_isR2V() ) {
+                return place(variable(((ExprRef2Value *)expr)->subexpr.get()), dst);
+            } else if ( expr->rtti_isVar() ) {
+                return place(variable(expr), dst);
+            } else if ( expr->rtti_isCall() ) {
+                return call((ExprCall *)expr, dst, false);
+            } else if ( expr->rtti_isOp1() ) {
+                auto op1 = (ExprOp1 *) expr;
+                if ( !isBuiltinOperator(op1) || !isScalar(op1->subexpr->type.get()) ) return fail();
+                if ( op1->op=="++" || op1->op=="--" ) {
+                    int32_t var = variable(op1->subexpr.get());
+                    emit(op1->op=="++" ? BcOp::AddK : BcOp::SubK, var, var, 1);
+                    return place(var, dst);
+                } else if ( op1->op=="+++" || op1->op=="---" ) {
+                    int32_t res = dst>=0 ? dst : allocRegister();
+                    int32_t var = variable(op1->subexpr.get());
+                    emit(BcOp::Mov, res, var);
+                    emit(op1->op=="+++" ? BcOp::AddK : BcOp::SubK, var, var, 1);
+                    return res;
+                }
+                BcOp op;
+                if ( op1->op=="!" ) op = BcOp::Not;
+                else if ( op1->op=="~" ) op = BcOp::BNot;
+                else if ( op1->op=="-" ) op = BcOp::Neg;
+                else if ( op1->op=="+" ) return value(op1->subexpr.get(), dst);
+                else return fail();
+                int32_t res = dst>=0 ? dst : allocRegister();
+                int32_t mark = top;
+                emit(op, res, value(op1->subexpr.get()));
+                top = mark;
+                return res;
+            } else if ( expr->rtti_isOp2() && !strcmp(expr->__rtti,"ExprOp2") ) {
+                auto op2 = (ExprOp2 *) expr;
+                if ( !isBuiltinOperator(op2) || !isScalar(op2->left->type.get()) || !isScalar(op2->right->type.get()) ) return fail();
+                if ( op2->op=="&&" || op2->op=="||" ) {
+                    return logical(op2, dst);
+                }
+                BcOp op = binaryOp(op2->op, op2->left->type->baseType);
+                if ( op==BcOp::count ) return fail();
+                return binary(op, op2->left.get(), op2->right.get(), dst);
+            } else if ( expr->rtti_isOp3() ) {
+                auto op3 = (ExprOp3 *) expr;
+                if ( op3->op!="?" || !isScalar(op3->type.get()) ) return fail();
+                int32_t res = allocRegister();
+                vector<int32_t> otherwise;
+                jumpIf(op3->subexpr.get(), false, otherwise);
+                value(op3->left.get(), res);
+                int32_t skip = emit(BcOp::Jmp, -1);
+                patch(otherwise, here());
+                value(op3->right.get(), res);
+                patch(skip, here());
+                return place(res, dst);
+            }
+            return fail();
+        }
+        void assign ( ExprOp2 * op2 ) {
+            if ( !isScalar(op2->left->type.get()) || !isScalar(op2->right->type.get()) ) {
+                fail();
+                return;
+            }
+            int32_t var = variable(op2->left.get());
+            if ( !strcmp(op2->__rtti,"ExprCopy") || !strcmp(op2->__rtti,"ExprMove") || !strcmp(op2->__rtti,"ExprClone") ) {
+                // compiled in place, unless branches can observe the partially assigned value
+                auto right = op2->right.get();
+                bool branchy = right->rtti_isOp3() || (right->rtti_isOp2() && (((ExprOp2 *)right)->op=="&&" || ((ExprOp2 *)right)->op=="||"));
+                if ( branchy ) {
+                    place(value(right), var);
+                } else {
+                    value(right, var);
+                }
+                return;
+            }
+            if ( !isBuiltinOperator(op2) ) {
+                fail();
+                return;
+            }
+            const string & op = op2->op;
+            if ( op=="&&=" || op=="||=" ) {
+                int32_t skip = emit(op=="&&=" ? BcOp::Jz : BcOp::Jnz, var, -1);
+                int32_t mark = top;
+                place(value(op2->right.get()), var);
+                top = mark;
+                patch(skip, here());
+                return;
+            }
+            if ( op.size()<2 || op.back()!='=' ) {
+                fail();
+                return;
+            }
+            BcOp bop = binaryOp(op.substr(0, op.size()-1), op2->left->type->baseType);
+            if ( bop==BcOp::count || isCompare(bop) ) {
+                if ( op!="^^=" ) {
+                    fail();
+                    return;
+                }
+            }
+            binary(bop, op2->left.get(), op2->right.get(), var);
+        }
+        void statement ( Expression * expr ) {
+            if ( failed ) return;
+            int32_t mark = top;
+            if ( expr->rtti_isBlock() ) {
+                auto blk = (ExprBlock *) expr;
+                if ( blk->isClosure || !blk->finalList.empty() || blk->maxLabelIndex!=-1 ) {
+                    fail();
+                    return;
+                }
+                for ( auto & sub : blk->list ) {
+                    statement(sub.get());
+                }
+            } else if ( expr->rtti_isLet() ) {
+                auto let = (ExprLet *) expr;
+                for ( auto & var : let->variables ) {
+                    if ( !isScalarValue(var->type.get()) ) {
+                        fail();
+                        return;
+                    }
+                    int32_t reg = allocRegister();
+                    if ( var->init ) {
+                        value(var->init.get(), reg);
+                    } else {
+                        emit(BcOp::Ldi, reg, 0);
+                    }
+                    vars[var.get()] = reg;
+                }
+                return;     // variables live until the end of the enclosing block
+            } else if ( expr->rtti_isIfThenElse() ) {
+                auto ite = (ExprIfThenElse *) expr;
+                vector<int32_t> otherwise;
+                jumpIf(ite->cond.get(), false, otherwise);
+                statement(ite->if_true.get());
+                if ( ite->if_false ) {
+                    int32_t skip = emit(BcOp::Jmp, -1);
+                    patch(otherwise, here());
+                    statement(ite->if_false.get());
+                    patch(skip, here());
+                } else {
+                    patch(otherwise, here());
+                }
+            } else if ( expr->rtti_isWhile() ) {
+                auto wh = (ExprWhile *) expr;
+                int32_t head = here();
+                vector<int32_t> exits;
+                jumpIf(wh->cond.get(), false, exits);
+                loops.emplace_back();
+                statement(wh->body.get());
+                emit(BcOp::Jmp, head);
+                patch(loops.back().continues, head);
+                patch(loops.back().breaks, here());
+                patch(exits, here());
+                loops.pop_back();
+            } else if ( expr->rtti_isFor() ) {
+                forLoop((ExprFor *) expr);
+            } else if ( expr->rtti_isBreak() || expr->rtti_isContinue() ) {
+                if ( loops.empty() ) {
+                    fail();
+                    return;
+                }
+                int32_t jmp = emit(BcOp::Jmp, -1);
+                (expr->rtti_isBreak() ? loops.back().breaks : loops.back().continues).push_back(jmp);
+            } else if ( expr->rtti_isReturn() ) {
+                auto ret = (ExprReturn *) expr;
+                if ( ret->returnInBlock || ret->returnReference || ret->fromYield ) {
+                    fail();
+                    return;
+                }
+                if ( ret->subexpr ) {
+                    emit(BcOp::Ret, value(ret->subexpr.get()));
+                } else {
+                    emit(BcOp::RetVoid);
+                }
+            } else if ( expr->rtti_isCall() ) {
+                call((ExprCall *) expr, -1, true);
+            } else if ( expr->rtti_isOp2() && strcmp(expr->__rtti,"ExprOp2") ) {
+                assign((ExprOp2 *) expr);
+            } else if ( expr->rtti_isOp2() && ((ExprOp2 *)expr)->op.back()=='=' && expr->type && expr->type->isVoid() ) {
+                assign((ExprOp2 *) expr);
+            } else {
+                value(expr);
+            }
+            top = mark;
+        }
+        void forLoop ( ExprFor * efor ) {
+            if ( efor->sources.size()!=1 || efor->iteratorVariables.size()!=1 ) {
+                fail();
+                return;
+            }
+            auto & ivar = efor->iteratorVariables[0];
+            if ( !ivar->type->isSimpleType(Type::tInt) ) {
+                fail();
+                return;
+            }
+            // counter and range end are in the consecutive registers
+            int32_t counter = allocRegister();
+            int32_t rangeEnd = allocRegister();
+            auto src = efor->sources[0].get();
+            if ( src->rtti_isConstant() && ((ExprConst *)src)->baseType==Type::tRange ) {
+                auto rng = ((ExprConst *)src)->cvalue<range>();
+                emit(BcOp::Ldi, counter, rng.from);
+                emit(BcOp::Ldi, rangeEnd, rng.to);
+            } else if ( src->rtti_isCall() ) {
+                auto rcall = (ExprCall *) src;
+                auto fn = rcall->func;
+                if ( !fn || !fn->builtIn || fn->name!="range" || !fn->module || fn->module->name!="$" ) {
+                    fail();
+                    return;
+                }
+                for ( auto & arg : rcall->arguments ) {
+                    if ( !arg->type->isSimpleType(Type::tInt) ) {
+                        fail();
+                        return;
+                    }
+                }
+                if ( rcall->arguments.size()==1 ) {
+                    emit(BcOp::Ldi, counter, 0);
+                    value(rcall->arguments[0].get(), rangeEnd);
+                } else if ( rcall->arguments.size()==2 ) {
+                    value(rcall->arguments[0].get(), counter);
+                    value(rcall->arguments[1].get(), rangeEnd);
+                } else {
+                    fail();
+                    return;
+                }
+            } else {
+                fail();
+                return;
+            }
+            int32_t ireg = allocRegister();
+            vars[ivar.get()] = ireg;
+            int32_t empty = emit(BcOp::JEq, counter, rangeEnd, -1);
+            emit(BcOp::Mov, ireg, counter);
+            int32_t body = here();
+            loops.emplace_back();
+            statement(efor->body.get());
+            int32_t next = emit(BcOp::ForNext, counter, body, ireg);
+            patch(loops.back().continues, next);
+            patch(loops.back().breaks, here());
+            patch(empty, here());
+            loops.pop_back();
+        }
+    };
+
+    void Program::bytecode ( Context & context, TextWriter & logs ) {
+        if ( !options.getBoolOption("bytecode_engine", policies.bytecode_engine) ) return;
+        // single step and breakpoints are the part of the tree interpreter
+        if ( getDebugger() ) return;
+        bool logIt = options.getBoolOption("log_bytecode", false);
+        for ( auto & pm : library.modules ) {
+            for ( auto & fn : pm->scriptFunctions() ) {
+                auto pfun = fn.get();
+                if ( pfun->index<0 || !pfun->used || pfun->builtIn ) continue;
+                BytecodeLowering lowering;
+                if ( !lowering.lower(pfun) ) continue;
+                auto & gfun = context.functions[pfun->index];
+                auto node = lowering.makeNode(context, pfun);
+                gfun.code = node;
+                gfun.stackSize = das::max(gfun.stackSize, lowering.frameSize());
+                gfun.bytecode = true;
+                if ( logIt ) {
+                    logs << "// bytecode " << pfun->describe() << "\n";
+                    printBytecode(logs, node);
+                }
+            }
+        }
+    }
+}
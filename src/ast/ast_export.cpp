@@ -65,8 +65,7 @@ namespace das {
         }
         void markUsedFunctions( ModuleLibrary & lib, bool forceAll ){
             lib.foreach([&](Module * pm) {
-                for (const auto & it : pm->functions) {
-                    auto fn = it.second;
+                for (const auto & fn : pm->scriptFunctions()) {
                     if (forceAll || fn->exports || fn->init) {
                         propagateFunctionUse(fn);
                     }
@@ -78,6 +77,7 @@ namespace das {
             das_safe_map<string,FunctionPtr> functions;
             vector<VariablePtr> globalsInOrder;
             swap(functions,mod.functions);
+            mod.invalidateScriptFunctions();
             swap(globalsInOrder, mod.globalsInOrder);
             mod.functionsByName.clear();
             mod.globals.clear();
@@ -219,8 +219,7 @@ namespace das {
             for (auto & var : pm->globalsInOrder) {
                 var->used = false;
             }
-            for (auto & pf : pm->functions) {
-                auto & func = pf.second;
+            for (auto & func : pm->scriptFunctions()) {
                 func->used = false;
             }
         }
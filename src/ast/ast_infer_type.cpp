@@ -28,6 +28,34 @@ namespace das {
 
 // type inference
 
+    // which functions need to be inferred on the next pass. function is inferred again when it changed or failed,
+    // or when it looked up a name, which got a new or changed function or generic since.
+    // a change outside of functions (structures, globals, macros) makes the next pass visit everything
+    struct InferWorklist {
+        bool                                            everything = true;
+        bool                                            changedOutside = false;
+        das_hash_set<Function *>                        dirty;
+        das_hash_set<Function *>                        changed;
+        das_hash_set<Function *>                        failed;
+        das_hash_set<Function *>                        known;          // functions and generics of this module
+        das_hash_map<string,das_hash_set<Function *>>   lookups;        // function name -> functions which looked it up
+        das_hash_map<Function *,int32_t>                work;           // how many times each function was inferred
+    };
+
+    // overload resolution results from the modules other than the one being inferred, by name, call signature and
+    // calling module. those modules don't change during inference, unless a macro does work - then the cache is dropped.
+    // functions and generics of this module are always matched on the spot, since thats where new ones are added
+    struct InferMatchCache {
+        struct Entry {
+            vector<FunctionPtr>     functions;
+            size_t                  thisModuleAt = 0;   // where this module goes in the library order
+        };
+        das_hash_map<string,Entry>  entries;
+        string                      key;                // scratch, so that lookups don't allocate
+        uint64_t                    hits = 0;
+        uint64_t                    misses = 0;
+    };
+
     class InferTypes : public FoldingVisitor {
     public:
         InferTypes( const ProgramPtr & prog ) : FoldingVisitor(prog ) {
@@ -36,6 +64,8 @@ namespace das {
         }
         bool finished() const { return !needRestart; }
         bool verbose = true;
+        InferWorklist *         worklist = nullptr;
+        InferMatchCache *       matchCache = nullptr;
     protected:
         FunctionPtr             func;
         vector<VariablePtr>     local;
@@ -55,6 +85,7 @@ namespace das {
         bool                    disableAot;
         Expression *            lastEnuValue = nullptr;
         int32_t                 unsafeDepth = 0;
+        size_t                  errorsBefore = 0;
     public:
         vector<FunctionPtr>     extraFunctions;
     protected:
@@ -89,10 +120,23 @@ namespace das {
         }
         void reportAstChanged() {
             needRestart = true;
+            noteChange();
         }
         virtual void reportFolding() override {
             FoldingVisitor::reportFolding();
             needRestart = true;
+            noteChange();
+        }
+        void noteChange() {
+            if ( !worklist ) return;
+            if ( func ) {
+                worklist->changed.insert(func.get());
+            } else {
+                worklist->changedOutside = true;
+            }
+        }
+        void noteLookup ( const string & funcName ) const {
+            if ( worklist && func ) worklist->lookups[funcName].insert(func.get());
         }
         string describeType ( const TypeDeclPtr & decl ) const {
             return verbose ? decl->describe() : "";
@@ -543,6 +587,7 @@ namespace das {
         vector<FunctionPtr> findFuncAddr ( const string & name ) const {
             string moduleName, funcName;
             splitTypeName(name, moduleName, funcName);
+            noteLookup(funcName);
             vector<FunctionPtr> result;
             auto inWhichModule = getSearchModule(moduleName);
             program->library.foreach([&](Module * mod) -> bool {
@@ -864,100 +909,187 @@ namespace das {
             return ss.str();
         }
 
-        vector<FunctionPtr> findMatchingFunctions ( const string & name, const vector<MakeFieldDeclPtr> & arguments, bool inferBlock = false ) const {
-            string moduleName, funcName;
-            splitTypeName(name, moduleName, funcName);
+        // exact, by identity of structures, enumerations and handled types. mangled names are not -
+        // those only have short structure names. returns false for types which can't be keyed yet
+        static bool appendSignature ( string & key, const TypeDecl * t ) {
+            if ( !t ) {
+                key += '?';
+                return true;
+            }
+            if ( !t->dimExpr.empty() ) {
+                return false;
+            }
+            auto appendRaw = [&]( const void * data, size_t size ) {
+                key.append((const char *)data, size);
+            };
+            uint8_t bt = uint8_t(t->baseType);
+            appendRaw(&bt, sizeof(bt));
+            appendRaw(&t->flags, sizeof(t->flags));
+            if ( t->structType ) appendRaw(&t->structType, sizeof(t->structType));
+            if ( t->enumType ) appendRaw(&t->enumType, sizeof(t->enumType));
+            if ( t->annotation ) appendRaw(&t->annotation, sizeof(t->annotation));
+            for ( auto d : t->dim ) {
+                appendRaw(&d, sizeof(d));
+            }
+            key += t->alias;
+            key += '\0';
+            for ( auto & an : t->argNames ) {
+                key += an;
+                key += '\0';
+            }
+            key += '(';
+            if ( t->firstType && !appendSignature(key, t->firstType.get()) ) return false;
+            key += ',';
+            if ( t->secondType && !appendSignature(key, t->secondType.get()) ) return false;
+            for ( auto & at : t->argTypes ) {
+                key += ',';
+                if ( !appendSignature(key, at.get()) ) return false;
+            }
+            key += ')';
+            return true;
+        }
+
+        template <typename KK, typename TT>
+        vector<FunctionPtr> findMatchingCandidates ( bool generics, const string & funcName, const string & moduleName,
+                                                KK && makeKey, TT && isMatch ) const {
             vector<FunctionPtr> result;
-            auto inWhichModule = getSearchModule(moduleName);
-            program->library.foreach([&](Module * mod) -> bool {
-                auto itFnList = mod->functionsByName.find(funcName);
-                if ( itFnList != mod->functionsByName.end() ) {
-                    auto & goodFunctions = itFnList->second;
-                    for ( auto & pFn : goodFunctions ) {
-                        if ( isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get())) ) {
-                            if ( canCallPrivate(pFn,inWhichModule,program->thisModule.get()) ) {
-                                if ( isFunctionCompatible(pFn, arguments, false, inferBlock) ) {
-                                    result.push_back(pFn);
-                                }
-                            }
+            auto thisMod = program->thisModule.get();
+            auto candidates = [&]( Module * mod ) -> const vector<FunctionPtr> * {
+                auto & byName = generics ? mod->genericsByName : mod->functionsByName;
+                auto itFnList = byName.find(funcName);
+                return itFnList != byName.end() ? &itFnList->second : nullptr;
+            };
+            auto collect = [&]( const vector<FunctionPtr> * fnList, vector<FunctionPtr> & res ) {
+                if ( fnList ) {
+                    for ( auto & pFn : *fnList ) {
+                        if ( isMatch(pFn) ) {
+                            res.push_back(pFn);
                         }
                     }
                 }
+            };
+            if ( matchCache && moduleName!=thisMod->name ) {
+                auto & key = matchCache->key;
+                key.clear();
+                key += generics ? 'g' : 'f';
+                key += moduleName;
+                key += "::";
+                key += funcName;
+                key += '\0';
+                if ( makeKey(key) ) {
+                    auto it = matchCache->entries.find(key);
+                    if ( it == matchCache->entries.end() ) {
+                        matchCache->misses ++;
+                        InferMatchCache::Entry entry;
+                        entry.thisModuleAt = size_t(-1);
+                        program->library.foreach([&](Module * mod) -> bool {
+                            if ( mod==thisMod ) {
+                                entry.thisModuleAt = entry.functions.size();
+                            } else {
+                                collect(candidates(mod), entry.functions);
+                            }
+                            return true;
+                        },moduleName);
+                        if ( entry.thisModuleAt==size_t(-1) ) entry.thisModuleAt = entry.functions.size();
+                        it = matchCache->entries.emplace(key, das::move(entry)).first;
+                    } else {
+                        matchCache->hits ++;
+                    }
+                    auto & entry = it->second;
+                    result.insert(result.end(), entry.functions.begin(), entry.functions.begin() + entry.thisModuleAt);
+                    if ( moduleName=="*" ) {
+                        collect(candidates(thisMod), result);
+                    }
+                    result.insert(result.end(), entry.functions.begin() + entry.thisModuleAt, entry.functions.end());
+                    return result;
+                }
+            }
+            program->library.foreach([&](Module * mod) -> bool {
+                collect(candidates(mod), result);
                 return true;
             },moduleName);
             return result;
         }
 
+        vector<FunctionPtr> findMatchingFunctions ( const string & name, const vector<MakeFieldDeclPtr> & arguments, bool inferBlock = false ) const {
+            string moduleName, funcName;
+            splitTypeName(name, moduleName, funcName);
+            noteLookup(funcName);
+            auto inWhichModule = getSearchModule(moduleName);
+            return findMatchingCandidates(false, funcName, moduleName, [&]( string & key ) {
+                key += inferBlock ? "[NB]" : "[N]";
+                key.append((const char *)&inWhichModule, sizeof(inWhichModule));
+                for ( auto & arg : arguments ) {
+                    key += arg->name;
+                    key += '\0';
+                    if ( !appendSignature(key, arg->value->type.get()) ) return false;
+                }
+                return true;
+            }, [&]( const FunctionPtr & pFn ) {
+                return isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get()))
+                    && canCallPrivate(pFn,inWhichModule,program->thisModule.get())
+                    && isFunctionCompatible(pFn, arguments, false, inferBlock);
+            });
+        }
+
         vector<FunctionPtr> findMatchingFunctions ( const string & name, const vector<TypeDeclPtr> & types, bool inferBlock = false, bool visCheck = true ) const {
             string moduleName, funcName;
             splitTypeName(name, moduleName, funcName);
-            vector<FunctionPtr> result;
+            noteLookup(funcName);
             auto inWhichModule = getSearchModule(moduleName);
-            program->library.foreach([&](Module * mod) -> bool {
-                auto itFnList = mod->functionsByName.find(funcName);
-                if ( itFnList != mod->functionsByName.end() ) {
-                    auto & goodFunctions = itFnList->second;
-                    for ( auto & pFn : goodFunctions ) {
-                        if ( !visCheck || isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get()) ) ) {
-                            if ( canCallPrivate(pFn,inWhichModule,program->thisModule.get()) ) {
-                                if ( isFunctionCompatible(pFn, types, false, inferBlock) ) {
-                                    result.push_back(pFn);
-                                }
-                            }
-                        }
-                    }
+            return findMatchingCandidates(false, funcName, moduleName, [&]( string & key ) {
+                key += inferBlock ? "[B" : "[";
+                key += visCheck ? "V]" : "]";
+                key.append((const char *)&inWhichModule, sizeof(inWhichModule));
+                for ( auto & t : types ) {
+                    if ( !appendSignature(key, t.get()) ) return false;
                 }
                 return true;
-            },moduleName);
-            return result;
+            }, [&]( const FunctionPtr & pFn ) {
+                return (!visCheck || isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get())))
+                    && canCallPrivate(pFn,inWhichModule,program->thisModule.get())
+                    && isFunctionCompatible(pFn, types, false, inferBlock);
+            });
         }
 
         vector<FunctionPtr> findMatchingGenerics ( const string & name, const vector<MakeFieldDeclPtr> & arguments ) const {
             string moduleName, funcName;
             splitTypeName(name, moduleName, funcName);
-            vector<FunctionPtr> result;
+            noteLookup(funcName);
             auto inWhichModule = getSearchModule(moduleName);
-            program->library.foreach([&](Module * mod) -> bool {
-                auto itFnList = mod->genericsByName.find(funcName);
-                if ( itFnList != mod->genericsByName.end() ) {
-                    auto & goodFunctions = itFnList->second;
-                    for ( auto & pFn : goodFunctions ) {
-                        if ( isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get())) ) {
-                            if ( canCallPrivate(pFn,inWhichModule,program->thisModule.get()) ) {
-                                if ( isFunctionCompatible(pFn, arguments, true, true) ) {   // infer block here?
-                                    result.push_back(pFn);
-                                }
-                            }
-                        }
-                    }
+            return findMatchingCandidates(true, funcName, moduleName, [&]( string & key ) {
+                key += "[N]";
+                key.append((const char *)&inWhichModule, sizeof(inWhichModule));
+                for ( auto & arg : arguments ) {
+                    key += arg->name;
+                    key += '\0';
+                    if ( !appendSignature(key, arg->value->type.get()) ) return false;
                 }
                 return true;
-            },moduleName);
-            return result;
+            }, [&]( const FunctionPtr & pFn ) {
+                return isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get()))
+                    && canCallPrivate(pFn,inWhichModule,program->thisModule.get())
+                    && isFunctionCompatible(pFn, arguments, true, true);   // infer block here?
+            });
         }
 
         vector<FunctionPtr> findMatchingGenerics ( const string & name, const vector<TypeDeclPtr> & types ) const {
             string moduleName, funcName;
             splitTypeName(name, moduleName, funcName);
-            vector<FunctionPtr> result;
+            noteLookup(funcName);
             auto inWhichModule = getSearchModule(moduleName);
-            program->library.foreach([&](Module * mod) -> bool {
-                auto itFnList = mod->genericsByName.find(funcName);
-                if ( itFnList != mod->genericsByName.end() ) {
-                    auto & goodFunctions = itFnList->second;
-                    for ( auto & pFn : goodFunctions ) {
-                        if ( isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get())) ) {
-                            if ( canCallPrivate(pFn,inWhichModule,program->thisModule.get()) ) {
-                                if ( isFunctionCompatible(pFn, types, true, true) ) {   // infer block here?
-                                    result.push_back(pFn);
-                                }
-                            }
-                        }
-                    }
+            return findMatchingCandidates(true, funcName, moduleName, [&]( string & key ) {
+                key += "[]";
+                key.append((const char *)&inWhichModule, sizeof(inWhichModule));
+                for ( auto & t : types ) {
+                    if ( !appendSignature(key, t.get()) ) return false;
                 }
                 return true;
-            },moduleName);
-            return result;
+            }, [&]( const FunctionPtr & pFn ) {
+                return isVisibleFunc(inWhichModule,getFunctionVisModule(pFn.get()))
+                    && canCallPrivate(pFn,inWhichModule,program->thisModule.get())
+                    && isFunctionCompatible(pFn, types, true, true);   // infer block here?
+            });
         }
 
         void reportFunctionNotFound( const string & name, const string & extra,
@@ -1517,9 +1649,21 @@ namespace das {
             if ( expr->alwaysSafe ) return true;
             return false;
         }
+        virtual bool canVisitFunction ( Function * fun ) override {
+            if ( !worklist ) return true;
+            auto it = worklist->work.find(fun);
+            if ( it==worklist->work.end() ) {                                   // never inferred yet
+                worklist->work[fun] = 1;
+                return true;
+            }
+            if ( !worklist->everything && worklist->dirty.find(fun)==worklist->dirty.end() ) return false;
+            it->second ++;
+            return true;
+        }
         virtual void preVisit ( Function * f ) override {
             Visitor::preVisit(f);
             unsafeDepth = 0;
+            errorsBefore = program->errors.size();
             func = f;
             func->hasReturn = false;
             func->noAot |= disableAot;
@@ -1624,6 +1768,9 @@ namespace das {
             DAS_ASSERT(blocks.size()==0);
             DAS_ASSERT(local.size()==0);
             DAS_ASSERT(with.size()==0);
+            if ( worklist && program->errors.size()!=errorsBefore ) {
+                worklist->failed.insert(func.get());
+            }
             labels.clear();
             func.reset();
             return Visitor::visit(that);
@@ -5390,6 +5537,7 @@ namespace das {
                     auto lname = stype->name;
                     auto newFinalizer = generateStructureFinalizer(stype);
                     finFunc->body = newFinalizer->body;
+                    if ( worklist ) worklist->changed.insert(finFunc.get());
                 }
                 // ---
                 reportAstChanged();
@@ -6698,11 +6846,22 @@ namespace das {
         if ( log ) {
             logs << "INITIAL CODE:\n" << *this;
         }
+        InferWorklist worklist;
+        for ( auto & fn : thisModule->functions ) worklist.known.insert(fn.second.get());
+        for ( auto & fn : thisModule->generics ) worklist.known.insert(fn.second.get());
+        InferMatchCache matchCache;
         for ( pass = 0; pass < maxPasses; ++pass ) {
             failToCompile = false;
             errors.clear();
             InferTypes context(this);
             context.verbose = verbose || log;
+            context.worklist = &worklist;
+            context.matchCache = &matchCache;
+            worklist.changed.clear();
+            worklist.failed.clear();
+            worklist.changedOutside = false;
+            size_t workBefore = 0;
+            if ( log ) for ( auto & w : worklist.work ) workBefore += w.second;
             visit(context);
             for ( auto efn : context.extraFunctions ) {
                 addFunction(efn);
@@ -6719,20 +6878,74 @@ namespace das {
             Module::foreach(modMacro);
             library.foreach(modMacro, "*");
             if ( log ) {
-                logs << "PASS " << pass << ":\n" << *this;
+                size_t workAfter = 0;
+                for ( auto & w : worklist.work ) workAfter += w.second;
+                logs << "PASS " << pass << ": " << (workAfter - workBefore) << " functions inferred\n" << *this;
                 sort(errors.begin(), errors.end());
                 for (auto & err : errors) {
                     logs << reportError(err.at, err.what, err.extra, err.fixme, err.cerr);
                 }
             }
-            if ( anyMacrosDidWork ) continue;
+            if ( anyMacrosDidWork ) {
+                worklist.everything = true;
+                matchCache.entries.clear();
+                continue;
+            }
             if ( context.finished() ) break;
+            // what to visit on the next pass
+            das_hash_set<string> changedNames;
+            worklist.dirty.clear();
+            for ( auto fn : worklist.changed ) {
+                worklist.dirty.insert(fn);
+                changedNames.insert(fn->name);
+            }
+            for ( auto fn : worklist.failed ) {
+                worklist.dirty.insert(fn);
+            }
+            for ( auto & fn : thisModule->functions ) {
+                if ( worklist.known.insert(fn.second.get()).second ) {
+                    worklist.dirty.insert(fn.second.get());
+                    changedNames.insert(fn.second->name);
+                }
+            }
+            for ( auto & fn : thisModule->generics ) {
+                if ( worklist.known.insert(fn.second.get()).second ) {
+                    changedNames.insert(fn.second->name);
+                }
+            }
+            for ( auto & name : changedNames ) {
+                auto it = worklist.lookups.find(name);
+                if ( it != worklist.lookups.end() ) {
+                    worklist.dirty.insert(it->second.begin(), it->second.end());
+                }
+            }
+            worklist.everything = worklist.changedOutside;
         }
         if (pass == maxPasses) {
             error("type inference exceeded maximum allowed number of passes ("+to_string(maxPasses)+")\n"
                     "this is likely due to a loop in the type system", "", "",
                 LineInfo(), CompilationError::too_many_infer_passes);
         }
+        if ( log ) {
+            vector<pair<int32_t,string>> work;
+            int32_t total = 0;
+            for ( auto & fn : thisModule->functions ) {
+                auto it = worklist.work.find(fn.second.get());
+                if ( it != worklist.work.end() ) {
+                    work.emplace_back(it->second, fn.second->getMangledName());
+                    total += it->second;
+                }
+            }
+            sort(work.begin(), work.end(), [](const pair<int32_t,string> & a, const pair<int32_t,string> & b) {
+                return a.first!=b.first ? a.first>b.first : a.second<b.second;
+            });
+            logs << "INFER WORK: " << total << " function inferences in " << (pass<maxPasses ? pass+1 : pass) << " passes\n";
+            for ( auto & w : work ) {
+                logs << "\t" << w.first << "\t" << w.second << "\n";
+            }
+            auto lookups = matchCache.hits + matchCache.misses;
+            logs << "MATCH CACHE: " << matchCache.hits << " hits of " << lookups << " lookups ("
+                << (lookups ? matchCache.hits * 100 / lookups : 0) << "%), " << matchCache.entries.size() << " entries\n";
+        }
     }
 }
-
@@ -349,6 +349,8 @@ namespace das {
         "persistent_string_heap",       Type::tBool,
         "heap_size_hint",               Type::tInt,
         "string_heap_size_hint",        Type::tInt,
+        "string_heap_header",           Type::tBool,
+        "fork_globals_image",           Type::tBool,
     // aot
         "no_aot",                       Type::tBool,
         "aot_prologue",                 Type::tBool,
@@ -368,6 +370,7 @@ namespace das {
         "log_mn_hash",                  Type::tBool,
         "log_gmn_hash",                 Type::tBool,
         "log_ad_hash",                  Type::tBool,
+        "log_bytecode",                 Type::tBool,
         "print_ref",                    Type::tBool,
         "print_var_access",             Type::tBool,
         "print_c_style",                Type::tBool,
@@ -376,6 +379,9 @@ namespace das {
     // optimization
         "optimize",                     Type::tBool,
         "fusion",                       Type::tBool,
+        "bytecode_engine",              Type::tBool,
+        "profile_fusion",               Type::tBool,
+        "compile_threads",              Type::tInt,
         "remove_unused_symbols",        Type::tBool,
     // language
         "always_export_initializer",    Type::tBool,
@@ -156,13 +156,80 @@ namespace das {
         }
     }
 
-    void Module::promoteToBuiltin(const FileAccessPtr & access) {
+    static uint64_t getSourceHash ( const FileAccessPtr & access, const string & fileName ) {
+        if ( auto fi = access->getFileInfo(fileName) ) {
+            return hash_block64((const uint8_t *)fi->source, fi->sourceLength);
+        }
+        return 0;
+    }
+
+    // policies, which change what the module compiles to. memory sizes, compile_threads and such only change how it is loaded or run
+    static uint64_t getPoliciesKey ( const CodeOfPolicies & p ) {
+        const bool flags[] = { p.rtti, p.no_unsafe, p.no_global_variables, p.no_global_heap, p.only_fast_aot,
+            p.aot_order_side_effects, p.no_unused_function_arguments, p.no_unused_block_arguments,
+            p.smart_pointer_by_value_unsafe, p.allow_block_variable_shadowing, p.allow_shared_lambda,
+            p.no_optimizations, p.fail_on_no_aot, p.fail_on_lack_of_aot_export, p.debugger };
+        uint64_t key = 0;
+        for ( size_t i=0; i!=sizeof(flags)/sizeof(flags[0]); ++i ) {
+            key |= uint64_t(flags[i]) << i;
+        }
+        return key;
+    }
+
+    void Module::promoteToBuiltin(const FileAccessPtr & access, const string & fileName, const CodeOfPolicies & policies) {
         DAS_ASSERTF(!builtIn, "failed to promote. already builtin");
+        removeStalePromoted(name, access, policies);
         next = modules;
         modules = this;
         builtIn = true;
         promoted = true;
         promotedAccess = access;
+        promotedFileName = fileName;
+        promotedSourceHash = getSourceHash(access, fileName);
+        promotedPolicies = getPoliciesKey(policies);
+    }
+
+    // shared module can be reused as long as its source, and sources of shared modules it depends on, did not change,
+    // and it was compiled with the same policies. if not, the module is compiled and promoted again
+    bool Module::isPromotedUpToDate(const FileAccessPtr & access, const CodeOfPolicies & policies) const {
+        if ( !promoted ) return true;
+        if ( require(name) != this ) return false;
+        if ( promotedPolicies != getPoliciesKey(policies) ) return false;
+        if ( getSourceHash(access, promotedFileName) != promotedSourceHash ) return false;
+        for ( const auto & dep : requireModule ) {
+            if ( dep.first != this && !dep.first->isPromotedUpToDate(access, policies) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // stale shared modules with that name, and shared modules which require them, are unlinked and deleted.
+    // programs, which were compiled against them, have to be released before the module is compiled again
+    void Module::removeStalePromoted ( const string & name, const FileAccessPtr & access, const CodeOfPolicies & policies ) {
+        das_set<Module *> stale;
+        for ( auto m = modules; m != nullptr; m = m->next ) {
+            if ( m->promoted && m->name == name && !m->isPromotedUpToDate(access, policies) ) {
+                stale.insert(m);
+            }
+        }
+        for ( bool any = !stale.empty(); any; ) {
+            any = false;
+            for ( auto m = modules; m != nullptr; m = m->next ) {
+                if ( m->promoted && stale.find(m) == stale.end() ) {
+                    for ( const auto & dep : m->requireModule ) {
+                        if ( stale.find(dep.first) != stale.end() ) {
+                            stale.insert(m);
+                            any = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        for ( auto m : stale ) {
+            delete m;
+        }
     }
 
     Module::~Module() {
@@ -310,6 +377,7 @@ namespace das {
         if ( functions.insert(make_pair(mangledName, fn)).second ) {
             functionsByName[fn->name].push_back(fn);
             fn->module = this;
+            invalidateScriptFunctions();
             return true;
         } else {
             if ( !canFail ) {
@@ -320,6 +388,27 @@ namespace das {
         }
     }
 
+    // bound c++ functions are never marked as used, so they get no index and are never simulated.
+    // builtin modules are mostly made of them, per program passes walk this list instead
+    const vector<FunctionPtr> & Module::scriptFunctions() const {
+        lock_guard<mutex> guard(scriptFunctionsLock);
+        if ( !scriptFunctionsValid ) {
+            scriptFunctionsCache.clear();
+            for ( const auto & it : functions ) {
+                if ( !it.second->builtIn ) {
+                    scriptFunctionsCache.push_back(it.second);
+                }
+            }
+            scriptFunctionsValid = true;
+        }
+        return scriptFunctionsCache;
+    }
+
+    void Module::invalidateScriptFunctions() {
+        lock_guard<mutex> guard(scriptFunctionsLock);
+        scriptFunctionsValid = false;
+    }
+
     bool Module::addGeneric ( const FunctionPtr & fn, bool canFail ) {
         auto mangledName = fn->getMangledName();
         if ( generics.insert(make_pair(mangledName, fn)).second ) {
@@ -1,6 +1,7 @@
 #include "daScript/misc/platform.h"
 
 #include "daScript/ast/ast.h"
+#include "daScript/misc/job_que.h"
 
 void das_yybegin(const char * str);
 int das_yyparse();
@@ -135,6 +136,28 @@ namespace das {
         return fname;
     }
 
+    // shared module, which source has changed since it was promoted, needs to be compiled again
+    Module * requireUpToDate ( const string & name, const FileAccessPtr & access, bool allowPromoted, const CodeOfPolicies & policies ) {
+        auto module = Module::requireEx(name, allowPromoted);
+        if ( module && !module->isPromotedUpToDate(access, policies) ) {
+            return nullptr;
+        }
+        return module;
+    }
+
+    // native or shared module, which satisfies the require. otherwise info tells where the source of the module is,
+    // and mod is renamed to the module name. info is only looked up when there is no module with the required name
+    Module * resolveRequire ( string & mod, const string & fileName, const FileAccessPtr & access, bool allowPromoted,
+                              const CodeOfPolicies & policies, ModuleInfo & info ) {
+        auto module = requireUpToDate(mod, access, allowPromoted, policies); // try native with that name
+        if ( module ) return module;
+        info = access->getModuleInfo(mod, fileName);
+        if ( !info.moduleName.empty() ) {
+            mod = info.moduleName;
+        }
+        return requireUpToDate(mod, access, allowPromoted, policies); // try native with that name AGAIN (promoted?)
+    }
+
     bool getPrerequisits ( const string & fileName,
                           const FileAccessPtr & access,
                           vector<ModuleInfo> & req,
@@ -144,7 +167,8 @@ namespace das {
                           ModuleGroup & libGroup,
                           TextWriter * log,
                           int tab,
-                          bool allowPromoted ) {
+                          bool allowPromoted,
+                          const CodeOfPolicies & policies ) {
         if ( auto fi = access->getFileInfo(fileName) ) {
             if ( log ) {
                 *log << string(tab,'\t') << "in " << fileName << "\n";
@@ -154,61 +178,55 @@ namespace das {
                 if ( log ) {
                     *log << string(tab,'\t') << "require " << mod << "\n";
                 }
-                auto module = Module::requireEx(mod, allowPromoted); // try native with that name
+                ModuleInfo info;
+                auto module = resolveRequire(mod, fileName, access, allowPromoted, policies, info);
+                if ( log && !info.moduleName.empty() ) {
+                    *log << string(tab,'\t') << " resolved as " << mod << "\n";
+                }
                 if ( !module ) {
-                    auto info = access->getModuleInfo(mod, fileName);
-                    if ( !info.moduleName.empty() ) {
-                        mod = info.moduleName;
-                        if ( log ) {
-                            *log << string(tab,'\t') << " resolved as " << mod << "\n";
-                        }
-                    }
-                    module = Module::requireEx(mod, allowPromoted); // try native with that name AGAIN (promoted?)
-                    if ( !module ) {
-                        auto it_r = find_if(req.begin(), req.end(), [&] ( const ModuleInfo & reqM ) {
-                            return reqM.moduleName == mod;
-                        });
-                        if ( it_r==req.end() ) {
-                            if ( dependencies.find(mod) != dependencies.end() ) {
-                                // circular dependency
-                                if ( log ) {
-                                    *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - CIRCULAR DEPENDENCY\n";
-                                }
-                                circular.push_back(mod);
-                                return false;
-                            }
-                            dependencies.insert(mod);
-                            // module file name
-                            if ( info.moduleName.empty() ) {
-                                // request can't be translated to module name
-                                if ( log ) {
-                                    *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - MODULE INFO NOT FOUND\n";
-                                }
-                                missing.push_back(mod);
-                                return false;
-                            }
-                            if ( !getPrerequisits(info.fileName, access, req, missing, circular, dependencies, libGroup, log, tab + 1, allowPromoted) ) {
-                                return false;
-                            }
+                    auto it_r = find_if(req.begin(), req.end(), [&] ( const ModuleInfo & reqM ) {
+                        return reqM.moduleName == mod;
+                    });
+                    if ( it_r==req.end() ) {
+                        if ( dependencies.find(mod) != dependencies.end() ) {
+                            // circular dependency
                             if ( log ) {
-                                *log << string(tab,'\t') << "from " << fileName << " require " << mod
-                                    << " - ok, new module " << info.moduleName << " at " << info.fileName << "\n";
+                                *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - CIRCULAR DEPENDENCY\n";
                             }
-                            req.push_back(info);
-                        } else {
+                            circular.push_back(mod);
+                            return false;
+                        }
+                        dependencies.insert(mod);
+                        // module file name
+                        if ( info.moduleName.empty() ) {
+                            // request can't be translated to module name
                             if ( log ) {
-                                *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - already required\n";
+                                *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - MODULE INFO NOT FOUND\n";
                             }
+                            missing.push_back(mod);
+                            return false;
+                        }
+                        if ( !getPrerequisits(info.fileName, access, req, missing, circular, dependencies, libGroup, log, tab + 1, allowPromoted, policies) ) {
+                            return false;
                         }
-                    } else {
                         if ( log ) {
-                            *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - shared, ok\n";
+                            *log << string(tab,'\t') << "from " << fileName << " require " << mod
+                                << " - ok, new module " << info.moduleName << " at " << info.fileName << "\n";
                         }
-                        libGroup.addModule(module);
-                        for ( const auto & dep : module->requireModule ) {
-                            libGroup.addModule(dep.first);
+                        req.push_back(info);
+                    } else {
+                        if ( log ) {
+                            *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - already required\n";
                         }
                     }
+                } else if ( !info.moduleName.empty() ) {
+                    if ( log ) {
+                        *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - shared, ok\n";
+                    }
+                    libGroup.addModule(module);
+                    for ( const auto & dep : module->requireModule ) {
+                        libGroup.addModule(dep.first);
+                    }
                 } else {
                     if ( log ) {
                         *log << string(tab,'\t') << "from " << fileName << " require " << mod << " - ok\n";
@@ -226,6 +244,42 @@ namespace das {
         }
     }
 
+    // one que for the compile time io of the whole process. it is only replaced when more threads are asked for
+    mutex               g_compileQueLock;
+    shared_ptr<JobQue>  g_compileQue;
+
+    shared_ptr<JobQue> getCompileJobQue ( int threads ) {
+        lock_guard<mutex> guard(g_compileQueLock);
+        if ( !g_compileQue || g_compileQue->getTotalHwJobs()<threads ) {
+            g_compileQue = make_shared<JobQue>(threads);
+        }
+        return g_compileQue;
+    }
+
+    // walks require graph one level at a time, and loads each level in parallel
+    // parsing and inference are still sequential, so the only thing which goes wide is file io
+    void prefetchRequireGraph ( const string & fileName, const FileAccessPtr & access, JobQue & que, bool allowPromoted, const CodeOfPolicies & policies ) {
+        das_set<string> visited;
+        vector<string> level = { fileName };
+        visited.insert(fileName);
+        while ( !level.empty() ) {
+            access->prefetchFileInfo(level, que);
+            vector<string> nextLevel;
+            for ( const auto & fn : level ) {
+                auto fi = access->getFileInfo(fn);
+                if ( !fi ) continue;
+                for ( auto & mod : getAllRequire(fi, access) ) {
+                    ModuleInfo info;
+                    if ( resolveRequire(mod, fn, access, allowPromoted, policies, info) || info.moduleName.empty() ) continue;
+                    if ( visited.insert(info.fileName).second ) {
+                        nextLevel.push_back(info.fileName);
+                    }
+                }
+            }
+            swap(level, nextLevel);
+        }
+    }
+
     // PARSER
 
     ProgramPtr g_Program;
@@ -332,7 +386,11 @@ namespace das {
         vector<ModuleInfo> req;
         vector<string> missing, circular;
         das_set<string> dependencies;
-        if ( getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, nullptr, 1, !policies.ignore_shared_modules) ) {
+        if ( policies.compile_threads>1 ) {
+            auto que = getCompileJobQue(int(policies.compile_threads));
+            prefetchRequireGraph(fileName, access, *que, !policies.ignore_shared_modules, policies);
+        }
+        if ( getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, nullptr, 1, !policies.ignore_shared_modules, policies) ) {
             for ( auto & mod : req ) {
                 if ( !libGroup.findModule(mod.moduleName) ) {
                     auto program = parseDaScript(mod.fileName, access, logs, libGroup, true, true, policies);
@@ -371,7 +429,7 @@ namespace das {
                         if (  regFromShar ) {
                             return program;
                         }
-                        program->thisModule->promoteToBuiltin(access);
+                        program->thisModule->promoteToBuiltin(access, mod.fileName, policies);
                     }
                     libGroup.addModule(program->thisModule.release());
                     program->library.foreach([&](Module * pm) -> bool {
@@ -387,7 +445,7 @@ namespace das {
             auto res = parseDaScript(fileName, access, logs, libGroup, exportAll, false, policies);
             /*
             if ( res->promoteToBuiltin ) {
-                res->thisModule->promoteToBuiltin(access);
+                res->thisModule->promoteToBuiltin(access, fileName, policies);
             }
             */
             if ( res->options.getBoolOption("log_require",false) ) {
@@ -396,7 +454,7 @@ namespace das {
                 missing.clear();
                 circular.clear();
                 dependencies.clear();
-                getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, &tw, 1, false);
+                getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, &tw, 1, false, policies);
                 logs << "module dependency graph:\n" << tw.str();
             }
             if ( !res->failed() ) {
@@ -410,7 +468,7 @@ namespace das {
             missing.clear();
             circular.clear();
             dependencies.clear();
-            getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, &tw, 1, false);
+            getPrerequisits(fileName, access, req, missing, circular, dependencies, libGroup, &tw, 1, false, policies);
             auto program = make_smart<Program>();
             program->policies = policies;
             program->thisModuleGroup = &libGroup;
@@ -2729,6 +2729,7 @@ namespace das
         }
         context.heap->setInitialSize ( options.getIntOption("heap_size_hint", policies.heap_size_hint) );
         context.stringHeap->setInitialSize ( options.getIntOption("string_heap_size_hint", policies.string_heap_size_hint) );
+        context.stringHeap->setHeader ( options.getBoolOption("string_heap_header", policies.string_heap_header) );
         context.constStringHeap = make_smart<ConstStringAllocator>();
         if ( globalStringHeapSize ) {
             context.constStringHeap->setInitialSize(globalStringHeapSize);
@@ -2770,8 +2771,7 @@ namespace das
         context.totalFunctions = totalFunctions;
         if ( totalFunctions ) {
             for (auto & pm : library.modules) {
-                for (auto & it : pm->functions) {
-                    auto pfun = it.second;
+                for (auto & pfun : pm->scriptFunctions()) {
                     if (pfun->index < 0 || !pfun->used)
                         continue;
                     auto & gfun = context.functions[pfun->index];
@@ -2831,13 +2831,14 @@ namespace das
             return false;
         }
         fusion(context, logs);
+        bytecode(context, logs);
+        profileFusion(context, logs);
         context.relocateCode();
         context.restart();
         // now call annotation simulate
         das_hash_map<int,Function *> indexToFunction;
         for (auto & pm : library.modules) {
-            for (auto & it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used)
                     continue;
                 auto & gfun = context.functions[pfun->index];
@@ -2890,6 +2891,8 @@ namespace das
         })) {
             string exc = context.getException();
             error("exception during init script", exc, "", LineInfo(), CompilationError::cant_initialize);
+        } else if ( options.getBoolOption("fork_globals_image", policies.fork_globals_image) ) {
+            context.makeGlobalsImage(true);     // asked for, so [init] functions run once
         }
         context.restart();
         if (options.getBoolOption("log_mem",false)) {
@@ -2945,8 +2948,7 @@ namespace das
         // add init functions to dependencies
         const uint64_t fnv_prime = 1099511628211ul;
         for (auto& pm : library.modules) {
-            for (auto& it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used || !pfun->init)
                     continue;
                 res = (res ^ pfun->aotHash) * fnv_prime;
@@ -2962,8 +2964,7 @@ namespace das
         vector<Function *> fnn; fnn.reserve(totalFunctions);
         das_hash_map<int,Function *> indexToFunction;
         for (auto & pm : library.modules) {
-            for (auto & it : pm->functions) {
-                auto pfun = it.second;
+            for (auto & pfun : pm->scriptFunctions()) {
                 if (pfun->index < 0 || !pfun->used)
                     continue;
                 fnn.push_back(pfun.get());
@@ -2986,6 +2987,7 @@ namespace das
                 if ( it != aotLib.end() ) {
                     fn.code = (it->second)(context);
                     fn.aot = true;
+                    fn.bytecode = false;
                     if ( logIt ) logs << fn.mangledName << " AOT=0x" << HEX << semHash << DEC << "\n";
                     auto fcb = (SimNode_CallBase *) fn.code;
                     fn.aotFunction = fcb->aotFunction;
@@ -2340,6 +2340,7 @@ namespace das {
     void any_table_foreach ( void * _tab, int keyStride, int valueStride, const TBlock<void,void *,void *> & blk, Context * context ) {
         auto tab = (Table *) _tab;
         if ( !tab->data ) return;
+        if ( tab->rehashing ) table_rehash_finish(*context, *tab);
         char * values = tab->data;
         char * keys = tab->keys;
         for ( uint32_t index=0; index!=tab->capacity; index++, keys+=keyStride, values+=valueStride ) {
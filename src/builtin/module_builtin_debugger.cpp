@@ -5,6 +5,7 @@
 #include "daScript/ast/ast_policy_types.h"
 #include "daScript/ast/ast_handle.h"
 #include "daScript/simulate/aot_builtin_debugger.h"
+#include "daScript/simulate/sampling_profiler.h"
 #include "module_builtin_rtti.h"
 #include "daScript/misc/performance_time.h"
 
@@ -570,6 +571,42 @@ namespace debugapi {
         context.stackWalk(&lineInfo, true, true);
     }
 
+    void debuggerStartSampling ( Context & context, uint32_t every ) {
+        if ( !context.isDebugger() ) {
+            SamplingProfiler::instrumentFunctions(context);     // no single step hook, samples are taken on function entry
+        }
+        context.sampler = make_smart<SamplingProfiler>(every);
+    }
+
+    void debuggerStopSampling ( Context & context ) {
+        if ( context.sampler ) context.sampler->setActive(false);
+    }
+
+    void debuggerRequestSample ( Context & context ) {
+        if ( context.sampler ) context.sampler->requestSample();
+    }
+
+    char * debuggerSamplingReport ( Context & context, Context * ctx ) {
+        if ( !context.sampler ) return nullptr;
+        TextWriter tw;
+        context.sampler->writeReport(tw);
+        return ctx->stringHeap->allocateString(tw.str());
+    }
+
+    char * debuggerSamplingCollapsedStacks ( Context & context, Context * ctx ) {
+        if ( !context.sampler ) return nullptr;
+        TextWriter tw;
+        context.sampler->writeCollapsedStacks(tw);
+        return ctx->stringHeap->allocateString(tw.str());
+    }
+
+    char * debuggerSamplingChromeTrace ( Context & context, Context * ctx ) {
+        if ( !context.sampler ) return nullptr;
+        TextWriter tw;
+        context.sampler->writeChromeTrace(tw);
+        return ctx->stringHeap->allocateString(tw.str());
+    }
+
     DataWalkerPtr makeDataWalker ( const void * pClass, const StructInfo * info, Context * context ) {
         return make_smart<DataWalkerAdapter>((char *)pClass,info,context);
     }
@@ -711,6 +748,19 @@ namespace debugapi {
                 SideEffects::modifyExternal, "debuggerSetContextSingleStep");
             addExtern<DAS_BIND_FUN(debuggerStackWalk)>(*this, lib, "stackwalk",
                 SideEffects::modifyExternal, "debuggerStackWalk");
+            // sampling profiler
+            addExtern<DAS_BIND_FUN(debuggerStartSampling)>(*this, lib, "start_sampling",
+                SideEffects::modifyExternal, "debuggerStartSampling");
+            addExtern<DAS_BIND_FUN(debuggerStopSampling)>(*this, lib, "stop_sampling",
+                SideEffects::modifyExternal, "debuggerStopSampling");
+            addExtern<DAS_BIND_FUN(debuggerRequestSample)>(*this, lib, "request_sample",
+                SideEffects::modifyExternal, "debuggerRequestSample");
+            addExtern<DAS_BIND_FUN(debuggerSamplingReport)>(*this, lib, "sampling_report",
+                SideEffects::modifyExternal, "debuggerSamplingReport");
+            addExtern<DAS_BIND_FUN(debuggerSamplingCollapsedStacks)>(*this, lib, "sampling_collapsed_stacks",
+                SideEffects::modifyExternal, "debuggerSamplingCollapsedStacks");
+            addExtern<DAS_BIND_FUN(debuggerSamplingChromeTrace)>(*this, lib, "sampling_chrome_trace",
+                SideEffects::modifyExternal, "debuggerSamplingChromeTrace");
             // data walker
             addExtern<DAS_BIND_FUN(makeDataWalker)>(*this, lib,  "make_data_walker",
                 SideEffects::modifyExternal, "makeDataWalker");
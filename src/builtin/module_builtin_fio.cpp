@@ -9,6 +9,7 @@
 #include "daScript/ast/ast_policy_types.h"
 #include "daScript/ast/ast_handle.h"
 #include "daScript/simulate/aot_builtin_time.h"
+#include "daScript/simulate/bin_serializer.h"
 
 #include "daScript/misc/performance_time.h"
 
@@ -196,7 +197,7 @@ namespace das {
         vec4f args[1];
         args[0] = cast<void*>::from(data);
         context->invoke(blk, args, nullptr);
-        munmap(data, 0);
+        munmap(data, st.st_size);
     }
 
     char * builtin_fread ( const FILE * f, Context * context ) {
@@ -289,6 +290,87 @@ namespace das {
         return v_zero();
     }
 
+    // save_stream(file,obj)
+    vec4f builtin_save_stream ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        auto fp = cast<FILE *>::to(args[0]);
+        if ( !fp ) context.throw_error("can't save NULL");
+        FileBinaryStream out(fp);
+        uint64_t bytes = binary_save_stream(context, out, args[1], call->types[1]);
+        return cast<int64_t>::from(int64_t(bytes));
+    }
+
+    // load_stream(file,obj)
+    vec4f builtin_load_stream ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        auto fp = cast<FILE *>::to(args[0]);
+        if ( !fp ) context.throw_error("can't load NULL");
+        auto info = call->types[1];
+        if ( !(info->flags & (TypeInfo::flag_refType | TypeInfo::flag_ref)) ) context.throw_error("can only load into a reference");
+        FileBinaryStream in(fp);
+        return cast<bool>::from(binary_load_stream(context, in, cast<char *>::to(args[1]), info));
+    }
+
+    // map_stream(file,obj,block<(loaded)>)
+    vec4f builtin_map_stream ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        auto fp = cast<FILE *>::to(args[0]);
+        if ( !fp ) context.throw_error("can't map NULL file");
+        auto info = call->types[1];
+        if ( !(info->flags & (TypeInfo::flag_refType | TypeInfo::flag_ref)) ) context.throw_error("can only load into a reference");
+        Block * block = cast<Block *>::to(args[2]);
+        struct stat st;
+        int fd = fileno(fp);
+        fstat(fd, &st);
+        // from the current position, like load_stream. mapping starts at the granularity boundary in front of it
+        const int64_t granularity = 64*1024;
+        int64_t pos = builtin_ftell(fp, &context);
+        int64_t start = pos - pos % granularity;
+        uint64_t size = pos < int64_t(st.st_size) ? uint64_t(st.st_size - pos) : 0;
+        uint64_t length = uint64_t(st.st_size - start);
+        // private mapping, so that loaded arrays can be modified without touching the file
+        void * data = size ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, off_t(start)) : MAP_FAILED;
+        if ( data==MAP_FAILED ) {
+            vec4f bargs[1];
+            bargs[0] = cast<bool>::from(false);
+            context.invoke(*block, bargs, nullptr);
+            return v_zero();
+        }
+        // bulk arrays are aligned from the start of the object, so it is moved to the aligned address
+        char * bytes = (char *) data + (pos - start);
+        if ( uintptr_t(bytes) & 15 ) {
+            char * aligned = (char *)(uintptr_t(bytes) & ~uintptr_t(15));
+            memmove(aligned, bytes, size);
+            bytes = aligned;
+        }
+        uint64_t used = 0;
+        bool completed = binary_map_stream(context, bytes, size, cast<char *>::to(args[1]), info, *block, &used);
+        munmap(data, length);
+        if ( !completed ) context.rethrow();
+        builtin_fseek(fp, pos + int64_t(used), SEEK_SET, &context);
+        return v_zero();
+    }
+
+    int64_t builtin_ftell ( const FILE * f, Context * context ) {
+        if ( !f ) context->throw_error("can't ftell NULL");
+#if defined(_MSC_VER)
+        return _ftelli64((FILE *)f);
+#else
+        return int64_t(ftello((FILE *)f));
+#endif
+    }
+
+    int64_t builtin_fseek ( const FILE * f, int64_t offset, int32_t mode, Context * context ) {
+        if ( !f ) context->throw_error("can't fseek NULL");
+#if defined(_MSC_VER)
+        return _fseeki64((FILE *)f, offset, mode);
+#else
+        return int64_t(fseeko((FILE *)f, off_t(offset), mode));
+#endif
+    }
+
+    const FILE * builtin_tmpfile () {
+        FILE * f = tmpfile();
+        if ( f ) setvbuf(f, NULL, _IOFBF, 65536);
+        return f;
+    }
 
     char * builtin_dirname ( const char * name, Context * context ) {
         if ( name ) {
@@ -415,10 +497,19 @@ namespace das {
             addExtern<DAS_BIND_FUN(builtin_fgets)>(*this, lib, "fgets", SideEffects::modifyExternal, "builtin_fgets");
             addExtern<DAS_BIND_FUN(builtin_fwrite)>(*this, lib, "fwrite", SideEffects::modifyExternal, "builtin_fwrite");
             addExtern<DAS_BIND_FUN(builtin_feof)>(*this, lib, "feof", SideEffects::modifyExternal, "builtin_feof");
+            addExtern<DAS_BIND_FUN(builtin_ftell)>(*this, lib, "ftell", SideEffects::modifyExternal, "builtin_ftell");
+            addExtern<DAS_BIND_FUN(builtin_fseek)>(*this, lib, "fseek", SideEffects::modifyExternal, "builtin_fseek");
+            addExtern<DAS_BIND_FUN(builtin_tmpfile)>(*this, lib, "ftemp", SideEffects::modifyExternal, "builtin_tmpfile");
+            addConstant(*this, "seek_set", int32_t(SEEK_SET));
+            addConstant(*this, "seek_cur", int32_t(SEEK_CUR));
+            addConstant(*this, "seek_end", int32_t(SEEK_END));
             // builtin file functions
             addInterop<builtin_read,int,const FILE*,vec4f,int32_t>(*this, lib, "_builtin_read",SideEffects::modifyExternal, "builtin_read");
             addInterop<builtin_write,int,const FILE*,vec4f,int32_t>(*this, lib, "_builtin_write",SideEffects::modifyExternal, "builtin_write");
             addInterop<builtin_load,void,const FILE*,int32_t,const Block &>(*this, lib, "_builtin_load",das::SideEffects::modifyExternal, "builtin_load");
+            addInterop<builtin_save_stream,int64_t,const FILE*,vec4f>(*this, lib, "_builtin_save_stream",SideEffects::modifyExternal, "builtin_save_stream");
+            addInterop<builtin_load_stream,bool,const FILE*,vec4f>(*this, lib, "_builtin_load_stream",SideEffects::modifyArgumentAndExternal, "builtin_load_stream");
+            addInterop<builtin_map_stream,void,const FILE*,vec4f,const Block &>(*this, lib, "_builtin_map_stream",SideEffects::modifyArgumentAndExternal, "builtin_map_stream");
             addExtern<DAS_BIND_FUN(builtin_dirname)>(*this, lib, "dir_name", SideEffects::none, "builtin_dirname");
             addExtern<DAS_BIND_FUN(builtin_basename)>(*this, lib, "base_name", SideEffects::none, "builtin_basename");
             addExtern<DAS_BIND_FUN(builtin_fstat)>(*this, lib, "fstat", SideEffects::modifyExternal, "builtin_fstat");
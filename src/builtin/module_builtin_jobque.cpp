@@ -7,6 +7,7 @@
 
 MAKE_TYPE_FACTORY(JobStatus, JobStatus)
 MAKE_TYPE_FACTORY(Channel, Channel)
+MAKE_TYPE_FACTORY(LockFreeChannel, LockFreeChannel)
 
 namespace das {
 
@@ -23,18 +24,11 @@ namespace das {
     }
 
     void * Channel::pop () {
-        while ( true ) {
-            unique_lock<mutex> uguard(lock);
-            if ( !cond.wait_for(uguard, chrono::milliseconds(0), [&]() {
-                bool continue_waiting = (remaining>0) && pipe.empty();
-                return !continue_waiting;
-            }) ) {
-                this_thread::yield();
-            } else {
-                break;
-            }
-        }
-        lock_guard<mutex> guard(lock);
+        unique_lock<mutex> uguard(lock);
+        cond.wait(uguard, [&]() {
+            bool continue_waiting = (remaining>0) && pipe.empty();
+            return !continue_waiting;
+        });
         if ( pipe.empty() ) {
             tail.clear();
         } else {
@@ -70,6 +64,235 @@ namespace das {
         return remaining==0;
     }
 
+    void EventCount::wait ( uint32_t key ) {
+        unique_lock<mutex> uguard(lock);
+        while ( epoch.load()==key ) {
+            cond.wait(uguard);
+        }
+        waiters--;
+    }
+
+    void EventCount::notify() {
+        epoch++;
+        if ( waiters.load() ) {
+            lock_guard<mutex> guard(lock);
+            cond.notify_all();
+        }
+    }
+
+    LockFreeChannel::LockFreeChannel ( Context * ctx, uint32_t capacity, int count )
+            : enqueuePos(0), dequeuePos(0), remaining(count), owner(ctx), lastRetained(nullptr) {
+        uint32_t size = 1;
+        while ( size < capacity ) size <<= 1;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for ( uint32_t i=0; i!=size; ++i ) {
+            cells[i].sequence.store(uint64_t(i)*2, memory_order_relaxed);
+        }
+    }
+
+    LockFreeChannel::~LockFreeChannel() {
+        Feature tail;
+        while ( dequeue(tail) ) {}
+        cells.reset();
+        retained.clear();
+    }
+
+    bool LockFreeChannel::enqueue ( void * data, Context * context ) {
+        uint64_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell * cell;
+        for ( ;; ) {
+            cell = &cells[pos & mask];
+            uint64_t seq = cell->sequence.load(memory_order_acquire);
+            int64_t dif = int64_t(seq) - int64_t(pos*2);
+            if ( dif==0 ) {
+                if ( enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed) ) break;
+            } else if ( dif<0 ) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        if ( context!=owner ) {
+            cell->data = Feature(data, context);
+        } else {
+            cell->data.data = data;
+        }
+        cell->sequence.store(pos*2 + 1, memory_order_release);
+        return true;
+    }
+
+    bool LockFreeChannel::dequeue ( Feature & res ) {
+        uint64_t pos = dequeuePos.load(memory_order_relaxed);
+        Cell * cell;
+        for ( ;; ) {
+            cell = &cells[pos & mask];
+            uint64_t seq = cell->sequence.load(memory_order_acquire);
+            int64_t dif = int64_t(seq) - int64_t(pos*2 + 1);
+            if ( dif==0 ) {
+                if ( dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed) ) break;
+            } else if ( dif<0 ) {
+                return false;
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+        res = move(cell->data);
+        cell->data.clear();
+        cell->sequence.store((pos + mask + 1)*2, memory_order_release);
+        return true;
+    }
+
+    void * LockFreeChannel::retain ( Feature && res ) {
+        if ( res.from && lastRetained.load()!=res.from.get() ) {
+            lock_guard<mutex> guard(retainLock);
+            lastRetained = res.from.get();
+            auto & ctx = retained[res.from.get()];
+            if ( !ctx ) ctx = move(res.from);
+        }
+        return res.data;
+    }
+
+    bool LockFreeChannel::tryPush ( void * data, Context * context ) {
+        if ( !enqueue(data, context) ) return false;
+        notEmpty.notify();
+        return true;
+    }
+
+    void LockFreeChannel::push ( void * data, Context * context ) {
+        while ( !enqueue(data, context) ) {
+            auto key = notFull.prepareWait();
+            if ( enqueue(data, context) ) {
+                notFull.cancelWait();
+                break;
+            }
+            notFull.wait(key);
+        }
+        notEmpty.notify();
+    }
+
+    void LockFreeChannel::pushBatch ( void ** data, uint32_t count, Context * context ) {
+        uint32_t pushed = 0;
+        while ( pushed!=count ) {
+            while ( pushed!=count && enqueue(data[pushed], context) ) {
+                pushed ++;
+            }
+            notEmpty.notify();
+            if ( pushed==count ) break;
+            auto key = notFull.prepareWait();
+            if ( !isFull() ) {
+                notFull.cancelWait();
+                continue;
+            }
+            notFull.wait(key);
+        }
+    }
+
+    void * LockFreeChannel::pop () {
+        Feature res;
+        for ( ;; ) {
+            if ( dequeue(res) ) break;
+            if ( remaining.load()==0 ) {
+                if ( dequeue(res) ) break;
+                return nullptr;
+            }
+            auto key = notEmpty.prepareWait();
+            if ( dequeue(res) ) {
+                notEmpty.cancelWait();
+                break;
+            }
+            if ( remaining.load()==0 ) {
+                notEmpty.cancelWait();
+                continue;
+            }
+            notEmpty.wait(key);
+        }
+        notFull.notify();
+        return retain(move(res));
+    }
+
+    uint32_t LockFreeChannel::popBatch ( void ** data, uint32_t count ) {
+        if ( count==0 ) return 0;
+        if ( !(data[0] = pop()) ) return 0;
+        uint32_t popped = 1;
+        Feature res;
+        while ( popped!=count && dequeue(res) ) {
+            data[popped++] = retain(move(res));
+        }
+        if ( popped>1 ) notFull.notify();
+        return popped;
+    }
+
+    bool LockFreeChannel::isEmpty() const {
+        return getSize()==0;
+    }
+
+    bool LockFreeChannel::isFull() const {
+        return getSize()>=getCapacity();
+    }
+
+    int32_t LockFreeChannel::getSize() const {
+        int64_t size = int64_t(enqueuePos.load()) - int64_t(dequeuePos.load());
+        return int32_t(das::max(size,int64_t(0)));
+    }
+
+    void LockFreeChannel::notify() {
+        DAS_ASSERTF(remaining.load() != 0, "Nothing to notify!");
+        remaining--;
+        notEmpty.notify();
+    }
+
+    void LockFreeChannel::wait() {
+        while ( remaining.load() ) {
+            auto key = notEmpty.prepareWait();
+            if ( remaining.load()==0 ) {
+                notEmpty.cancelWait();
+                break;
+            }
+            notEmpty.wait(key);
+        }
+    }
+
+    bool LockFreeChannel::isReady() const {
+        return remaining.load()==0;
+    }
+
+    void lockFreeChannelPush ( LockFreeChannel * ch, void * data, Context * ctx ) {
+        ch->push(data, ctx);
+    }
+
+    bool lockFreeChannelTryPush ( LockFreeChannel * ch, void * data, Context * ctx ) {
+        return ch->tryPush(data, ctx);
+    }
+
+    void lockFreeChannelPushBatch ( LockFreeChannel * ch, const TArray<void *> & data, Context * ctx ) {
+        ch->pushBatch((void **)data.data, data.size, ctx);
+    }
+
+    void * lockFreeChannelPop ( LockFreeChannel * ch ) {
+        return ch->pop();
+    }
+
+    int32_t lockFreeChannelPopBatch ( LockFreeChannel * ch, TArray<void *> & data ) {
+        return int32_t(ch->popBatch((void **)data.data, data.size));
+    }
+
+    void withLockFreeChannel ( int32_t capacity, int32_t count, const TBlock<void,LockFreeChannel *> & blk, Context * context, LineInfoArg * at ) {
+        if ( capacity<=0 ) context->throw_error_at(*at, "lock-free channel capacity must be positive");
+        LockFreeChannel ch(context, uint32_t(capacity), count);
+        das_invoke<void>::invoke<LockFreeChannel *>(context, blk, &ch);
+    }
+
+    void waitForLockFreeChannel ( LockFreeChannel * status ) {
+        if ( !status ) return;
+        status->wait();
+    }
+
+    void notifyLockFreeChannel ( LockFreeChannel * status ) {
+        if ( !status ) return;
+        status->notify();
+    }
+
     void channelPush ( Channel * ch, void * data, Context * ctx ) {
         ch->push(data, ctx);
     }
@@ -106,41 +329,112 @@ namespace das {
     };
 
 
+    struct LockFreeChannelAnnotation : ManagedStructureAnnotation<LockFreeChannel,false> {
+        LockFreeChannelAnnotation(ModuleLibrary & ml) : ManagedStructureAnnotation ("LockFreeChannel", ml) {
+            addProperty<DAS_BIND_MANAGED_PROP(isEmpty)>("isEmpty");
+            addProperty<DAS_BIND_MANAGED_PROP(isFull)>("isFull");
+            addProperty<DAS_BIND_MANAGED_PROP(isReady)>("isReady");
+            addProperty<DAS_BIND_MANAGED_PROP(getSize)>("size","getSize");
+            addProperty<DAS_BIND_MANAGED_PROP(getCapacity)>("capacity","getCapacity");
+        }
+    };
+
     struct JobStatusAnnotation : ManagedStructureAnnotation<JobStatus,false> {
         JobStatusAnnotation(ModuleLibrary & ml) : ManagedStructureAnnotation ("JobStatus", ml) {
             addProperty<DAS_BIND_MANAGED_PROP(isReady)>("isReady");
         }
     };
 
+    shared_ptr<Context> ContextPool::acquire ( Context * parent ) {
+        vector<shared_ptr<Context>> stale;
+        {
+            lock_guard<mutex> guard(lock);
+            auto it = pool.find(parent);
+            if ( it!=pool.end() && !it->second.empty() ) {
+                auto & ctx = it->second.back();
+                // same address, different context - the one those were forked from is gone
+                if ( ctx->code==parent->code && ctx->shared==parent->shared && ctx->thisProgram==parent->thisProgram ) {
+                    auto res = move(ctx);
+                    it->second.pop_back();
+                    return res;
+                }
+                swap(stale, it->second);
+                pool.erase(it);
+            }
+        }
+        auto ctx = make_shared<Context>(*parent);
+        if ( !ctx->hasGlobalsImage() ) {
+            ctx->makeGlobalsImage();
+        }
+        return ctx;
+    }
+
+    void ContextPool::release ( Context * parent, shared_ptr<Context> && ctx, bool reinitGlobals ) {
+        if ( ctx.use_count()!=1 ) return;   // someone still holds on to its heap, i.e. data pushed into the channel
+        ctx->restartHeaps();
+        ctx->restart();
+        if ( reinitGlobals ) {
+            // without the image globals come from the init script, which allocates on the heaps we've just reset
+            if ( !ctx->runWithCatch([&]() { ctx->initGlobals(); }) ) return;
+            ctx->restart();
+        }
+        lock_guard<mutex> guard(lock);
+        auto & free = pool[parent];
+        if ( free.size() < maxPooledContexts ) {
+            free.push_back(move(ctx));
+        }
+    }
+
+    int32_t ContextPool::size ( Context * parent ) {
+        lock_guard<mutex> guard(lock);
+        auto it = pool.find(parent);
+        return it!=pool.end() ? int32_t(it->second.size()) : 0;
+    }
+
+    void ContextPool::clear() {
+        das_hash_map<Context *,vector<shared_ptr<Context>>> dead;
+        {
+            lock_guard<mutex> guard(lock);
+            swap(dead, pool);
+        }
+    }
+
+    ContextPool        g_contextPool;
+    ContextPool        g_workerPool;        // parallel_for workers, globals come from the caller on every call
+
     mutex              g_jobQueMutex;
     shared_ptr<JobQue> g_jobQue;
 
     void new_job_invoke ( Lambda lambda, Func fn, int32_t lambdaSize, Context * context, LineInfoArg * lineinfo ) {
         if ( !g_jobQue ) context->throw_error_at(*lineinfo, "need to be in 'with_job_que' block");
-        auto forkContext = make_shared<Context>(*context);
+        auto forkContext = g_contextPool.acquire(context);
         auto ptr = forkContext->heap->allocate(lambdaSize);
         forkContext->heap->mark_comment(ptr, "new [[ ]] in new_job");
         memset ( ptr, 0, lambdaSize );
         das_invoke_function<void>::invoke(forkContext.get(), fn, ptr, lambda.capture);
         das_delete<Lambda>::clear(context, lambda);
-        g_jobQue->push([=]() mutable {
+        // the job holds the only reference. otherwise the job can be done before we return, and the fork is not recycled
+        g_jobQue->push([=, forkContext = move(forkContext)]() mutable {
             Lambda flambda(ptr);
             das_invoke_lambda<void>::invoke(forkContext.get(), flambda);
             das_delete<Lambda>::clear(forkContext.get(), flambda);
+            g_contextPool.release(context, move(forkContext));
         }, 0, JobPriority::Default);
     }
 
     void new_thread_invoke ( Lambda lambda, Func fn, int32_t lambdaSize, Context * context ) {
-        auto forkContext = make_shared<Context>(*context);
+        auto forkContext = g_contextPool.acquire(context);
         auto ptr = forkContext->heap->allocate(lambdaSize);
         forkContext->heap->mark_comment(ptr, "new [[ ]] in new_thread");
         memset ( ptr, 0, lambdaSize );
         das_invoke_function<void>::invoke(forkContext.get(), fn, ptr, lambda.capture);
         das_delete<Lambda>::clear(context, lambda);
+        // threads are long lived, and so are their heaps. the context is not returned to the pool, where it would stay until shutdown
         thread([=]() mutable {
             Lambda flambda(ptr);
             das_invoke_lambda<void>::invoke(forkContext.get(), flambda);
             das_delete<Lambda>::clear(forkContext.get(), flambda);
+            forkContext.reset();
         }).detach();
     }
 
@@ -155,8 +449,119 @@ namespace das {
         }
         {
             lock_guard<mutex> guard(g_jobQueMutex);
-            if ( g_jobQue.use_count()==1 ) g_jobQue.reset();
+            if ( g_jobQue.use_count()==1 ) {
+                g_jobQue.reset();
+                g_contextPool.clear();
+                g_workerPool.clear();
+            }
+        }
+    }
+
+    // worker picks up the callers stack and globals, so that the block and everything it has captured
+    // is where the block expects it to be. writes to captured locals and to globals stay on the worker,
+    // and its heaps are restarted when it goes back to the pool
+    static shared_ptr<Context> acquireWorker ( Context * context ) {
+        auto worker = g_workerPool.acquire(context);
+        if ( worker->stack.size()!=context->stack.size() ) {
+            worker = make_shared<Context>(*context);
+        }
+        char * EP, * SP;
+        uint32_t used = uint32_t(context->stack.top() - context->stack.ap());
+        worker->stack.reset();
+        worker->stack.push(used, EP, SP);
+        memcpy(worker->stack.ap(), context->stack.ap(), used);
+        if ( context->getGlobalSize() ) {
+            memcpy(worker->globals, context->globals, context->getGlobalSize());
         }
+        return worker;
+    }
+
+    void parallelForEx ( int32_t from, int32_t to, int32_t chunkSize, const Block & payload,
+            const TBlock<void,int32_t,int32_t> & blk, Context * context, LineInfoArg * at ) {
+        if ( chunkSize<=0 ) context->throw_error_at(*at, "parallel_for chunk size must be positive");
+        if ( from>=to ) return;
+        int32_t numChunks = int32_t((int64_t(to) - int64_t(from) + chunkSize - 1) / chunkSize);
+        auto chunkRange = [=] ( int32_t ch, int32_t & i0, int32_t & i1 ) {
+            i0 = int32_t(int64_t(from) + int64_t(ch) * chunkSize);
+            i1 = int32_t(min(int64_t(i0) + chunkSize, int64_t(to)));
+        };
+        // blocks, compiled ahead of time, capture the calling context. those stay on the calling thread,
+        // as does everything which is already running on a worker
+        auto jq = getJobQue();
+        int32_t numWorkers = 0;
+        if ( jq && !jq->isWorkerThread() && !blk.aotFunction && !payload.aotFunction && context->stack.size() ) {
+            numWorkers = min(jq->getTotalHwJobs(), numChunks - 1);
+        }
+        if ( numWorkers<=0 ) {
+            for ( int32_t ch=0; ch!=numChunks; ++ch ) {
+                int32_t i0, i1;
+                chunkRange(ch, i0, i1);
+                das_invoke<void>::invoke<int32_t,int32_t>(context, blk, i0, i1);
+            }
+            return;
+        }
+        atomic<int32_t> nextChunk(0);
+        atomic<bool> failed(false);
+        mutex errorLock;
+        string error;
+        auto runChunks = [&] ( Context * ctx ) {
+            bool ok = ctx->runWithCatch([&]() {
+                while ( !failed ) {
+                    int32_t ch = nextChunk++;
+                    if ( ch>=numChunks ) break;
+                    int32_t i0, i1;
+                    chunkRange(ch, i0, i1);
+                    das_invoke<void>::invoke<int32_t,int32_t>(ctx, blk, i0, i1);
+                }
+            });
+            if ( !ok ) {
+                failed = true;
+                lock_guard<mutex> guard(errorLock);
+                if ( error.empty() ) error = ctx->getException() ? ctx->getException() : "exception in parallel_for";
+            }
+        };
+        // the block can't allocate on the heap, or write to globals. on the worker both would be gone once it is done,
+        // so it is an error wherever the chunk did run. that way the same block fails the same way on any machine
+        auto heapBytes = [] ( Context * ctx ) {
+            return ctx->heap->bytesAllocated() + ctx->stringHeap->bytesAllocated();
+        };
+        vector<shared_ptr<Context>> workers;
+        vector<uint64_t> workerBytes;
+        workers.reserve(numWorkers);
+        workerBytes.reserve(numWorkers + 1);
+        workerBytes.push_back(0);
+        for ( int32_t i=0; i!=numWorkers; ++i ) {
+            workers.push_back(acquireWorker(context));
+            workerBytes.push_back(heapBytes(workers.back().get()));
+        }
+        workerBytes[0] = heapBytes(context);
+        vector<char> globals(context->globals, context->globals + context->getGlobalSize());
+        JobStatus status(numWorkers);
+        for ( auto & worker : workers ) {
+            Context * ctx = worker.get();
+            jq->push([&,ctx]() {
+                runChunks(ctx);
+                status.Notify();
+            }, 0, JobPriority::Default);
+        }
+        runChunks(context);
+        status.Wait();
+        bool allocated = heapBytes(context) > workerBytes[0];
+        bool wroteGlobals = !globals.empty() && memcmp(context->globals, globals.data(), globals.size())!=0;
+        for ( int32_t i=0; i!=numWorkers; ++i ) {
+            auto & worker = workers[i];
+            allocated |= heapBytes(worker.get()) > workerBytes[i + 1];
+            wroteGlobals |= !globals.empty() && memcmp(worker->globals, globals.data(), globals.size())!=0;
+            worker->stack.reset();
+            g_workerPool.release(context, move(worker), false);
+        }
+        if ( !error.empty() ) context->throw_error_ex("%s", error.c_str());
+        if ( allocated ) context->throw_error_at(*at, "parallel_for block allocated on the heap, it does not outlive the worker. use new_job and channels instead");
+        if ( wroteGlobals ) context->throw_error_at(*at, "parallel_for block wrote to a global, writes on the worker are lost");
+    }
+
+    void parallelFor ( int32_t from, int32_t to, int32_t chunkSize, const TBlock<void,int32_t,int32_t> & blk, Context * context, LineInfoArg * at ) {
+        parallelForEx(from, to, chunkSize, blk, blk, context, at);
     }
 
     void withJobStatus ( int32_t total, const TBlock<void,JobStatus *> & block, Context * context, LineInfoArg * lineInfo ) {
@@ -176,6 +581,11 @@ namespace das {
         status->Notify();
     }
 
+    shared_ptr<JobQue> getJobQue() {
+        lock_guard<mutex> guard(g_jobQueMutex);
+        return g_jobQue;
+    }
+
     int getTotalHwJobs( Context * context, LineInfoArg * at ) {
         if ( !g_jobQue ) context->throw_error_at(*at, "need to be in 'with_job_que' block");
         return g_jobQue->getTotalHwJobs();
@@ -185,6 +595,10 @@ namespace das {
         return thread::hardware_concurrency();
     }
 
+    int getPooledForks ( Context * context ) {
+        return g_contextPool.size(context);
+    }
+
     class Module_JobQue : public Module {
     public:
         Module_JobQue() : Module("jobque") {
@@ -206,6 +620,24 @@ namespace das {
                 SideEffects::modifyExternal, "waitForChannel");
             addExtern<DAS_BIND_FUN(notifyChannel)>(*this, lib,  "notify",
                 SideEffects::modifyExternal, "notifyChannel");
+            // lock-free channel
+            addAnnotation(make_smart<LockFreeChannelAnnotation>(lib));
+            addExtern<DAS_BIND_FUN(lockFreeChannelPush)>(*this, lib,  "_builtin_channel_push",
+                SideEffects::modifyArgumentAndExternal, "lockFreeChannelPush");
+            addExtern<DAS_BIND_FUN(lockFreeChannelTryPush)>(*this, lib,  "_builtin_channel_try_push",
+                SideEffects::modifyArgumentAndExternal, "lockFreeChannelTryPush");
+            addExtern<DAS_BIND_FUN(lockFreeChannelPushBatch)>(*this, lib,  "_builtin_channel_push_batch",
+                SideEffects::modifyArgumentAndExternal, "lockFreeChannelPushBatch");
+            addExtern<DAS_BIND_FUN(lockFreeChannelPop)>(*this, lib,  "_builtin_channel_pop",
+                SideEffects::modifyArgumentAndExternal, "lockFreeChannelPop");
+            addExtern<DAS_BIND_FUN(lockFreeChannelPopBatch)>(*this, lib,  "_builtin_channel_pop_batch",
+                SideEffects::modifyArgumentAndExternal, "lockFreeChannelPopBatch");
+            addExtern<DAS_BIND_FUN(withLockFreeChannel)>(*this, lib,  "with_lock_free_channel",
+                SideEffects::invoke, "withLockFreeChannel");
+            addExtern<DAS_BIND_FUN(waitForLockFreeChannel)>(*this, lib,  "join",
+                SideEffects::modifyExternal, "waitForLockFreeChannel");
+            addExtern<DAS_BIND_FUN(notifyLockFreeChannel)>(*this, lib,  "notify",
+                SideEffects::modifyExternal, "notifyLockFreeChannel");
             // job
             addAnnotation(make_smart<JobStatusAnnotation>(lib));
             addExtern<DAS_BIND_FUN(withJobStatus)>(*this, lib,  "with_job_status",
@@ -219,10 +651,16 @@ namespace das {
                 SideEffects::modifyExternal, "new_job_invoke");
             addExtern<DAS_BIND_FUN(withJobQue)>(*this, lib,  "with_job_que",
                 SideEffects::modifyExternal, "withJobQue");
+            addExtern<DAS_BIND_FUN(parallelFor)>(*this, lib,  "parallel_for",
+                SideEffects::invoke, "parallelFor");
+            addExtern<DAS_BIND_FUN(parallelForEx)>(*this, lib,  "_builtin_parallel_for",
+                SideEffects::invoke, "parallelForEx");
             addExtern<DAS_BIND_FUN(getTotalHwJobs)>(*this, lib,  "get_total_hw_jobs",
                 SideEffects::accessExternal, "getTotalHwJobs");
             addExtern<DAS_BIND_FUN(getTotalHwThreads)>(*this, lib,  "get_total_hw_threads",
                 SideEffects::accessExternal, "getTotalHwThreads");
+            addExtern<DAS_BIND_FUN(getPooledForks)>(*this, lib,  "get_pooled_forks",
+                SideEffects::accessExternal, "getPooledForks");
             addExtern<DAS_BIND_FUN(new_thread_invoke)>(*this, lib,  "new_thread_invoke",
                 SideEffects::modifyExternal, "new_thread_invoke");
         }
@@ -233,6 +671,8 @@ namespace das {
         virtual ~Module_JobQue() {
             lock_guard<mutex> guard(g_jobQueMutex);
             g_jobQue.reset();
+            g_contextPool.clear();
+            g_workerPool.clear();
         }
     protected:
         // bool needShutdown = false;
@@ -0,0 +1,753 @@
+#include "daScript/misc/platform.h"
+
+#include "module_builtin.h"
+
+#include "daScript/ast/ast_interop.h"
+#include "daScript/ast/ast_handle.h"
+#include "daScript/simulate/aot_builtin_json.h"
+#include "daScript/simulate/runtime_string.h"
+#include "daScript/misc/arraytype.h"
+#include "daScript/misc/performance_time.h"
+
+MAKE_TYPE_FACTORY(StringBuilderWriter, StringBuilderWriter)
+MAKE_TYPE_FACTORY(string_view, das::StringView)
+
+namespace das {
+
+    // stage 1 - structural index
+    //  text is classified 64 bytes at a time, each class of characters becomes a 64 bit mask
+    //  escaped characters and string contents are removed from the masks with bit arithmetic, without branches
+    //  what remains are positions of { } [ ] : , and the first characters of strings, numbers and literals
+
+    struct JsonBlockMasks {
+        uint64_t quote = 0;
+        uint64_t backslash = 0;
+        uint64_t whitespace = 0;
+        uint64_t op = 0;
+    };
+
+    static __forceinline uint64_t json_mask ( vec4i m, uint32_t shift ) {
+        return uint64_t(uint32_t(v_signmaski8(m)) & 0xffff) << shift;
+    }
+
+    static __forceinline void json_classify ( const char * s, JsonBlockMasks & m ) {
+        vec4i quote = v_splatsi8('\"'), slash = v_splatsi8('\\');
+        vec4i space = v_splatsi8(' '), tab = v_splatsi8('\t'), lf = v_splatsi8('\n'), cr = v_splatsi8('\r');
+        vec4i lbr = v_splatsi8('{'), rbr = v_splatsi8('}'), lsq = v_splatsi8('['), rsq = v_splatsi8(']');
+        vec4i colon = v_splatsi8(':'), comma = v_splatsi8(',');
+        for ( uint32_t i=0; i!=64; i+=16 ) {
+            vec4i b = v_ldui((const int *)(s + i));
+            m.quote |= json_mask(v_cmp_eqi8(b, quote), i);
+            m.backslash |= json_mask(v_cmp_eqi8(b, slash), i);
+            m.whitespace |= json_mask(v_ori(v_ori(v_cmp_eqi8(b, space), v_cmp_eqi8(b, tab)),
+                v_ori(v_cmp_eqi8(b, lf), v_cmp_eqi8(b, cr))), i);
+            vec4i op = v_ori(v_ori(v_cmp_eqi8(b, lbr), v_cmp_eqi8(b, rbr)), v_ori(v_cmp_eqi8(b, lsq), v_cmp_eqi8(b, rsq)));
+            m.op |= json_mask(v_ori(op, v_ori(v_cmp_eqi8(b, colon), v_cmp_eqi8(b, comma))), i);
+        }
+    }
+
+    static __forceinline uint64_t json_prefix_xor ( uint64_t x ) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    struct JsonIndexer {
+        uint64_t nextEscaped = 0;   // 1 if the first character of the next block is escaped
+        uint64_t prevInString = 0;  // all ones if the previous block ended inside of the string
+        uint64_t prevScalar = 0;    // 1 if the previous block ended with the scalar character
+        __forceinline uint64_t escaped ( uint64_t backslash ) {
+            if ( !backslash ) {
+                uint64_t res = nextEscaped;
+                nextEscaped = 0;
+                return res;
+            }
+            // odd length runs of backslashes escape the character which follows them
+            const uint64_t oddBits = 0xAAAAAAAAAAAAAAAAull;
+            uint64_t potential = backslash & ~nextEscaped;
+            uint64_t code = (((potential << 1) | oddBits) - potential) ^ oddBits;
+            uint64_t res = code ^ (backslash | nextEscaped);
+            nextEscaped = (code & backslash) >> 63;
+            return res;
+        }
+        __forceinline void block ( const char * s, uint32_t base, vector<uint32_t> & index ) {
+            JsonBlockMasks m;
+            json_classify(s, m);
+            uint64_t quote = m.quote & ~escaped(m.backslash);
+            uint64_t inString = json_prefix_xor(quote) ^ prevInString;
+            prevInString = uint64_t(int64_t(inString) >> 63);
+            uint64_t scalar = ~(m.op | m.whitespace);
+            uint64_t nonQuoteScalar = scalar & ~quote;
+            uint64_t followsScalar = (nonQuoteScalar << 1) | prevScalar;
+            prevScalar = nonQuoteScalar >> 63;
+            // opening quote is a scalar start, string contents and closing quote are masked out
+            uint64_t structurals = (m.op | (scalar & ~followsScalar)) & ~(inString ^ quote);
+            while ( structurals ) {
+                index.push_back(base + __builtin_ctzll(structurals));
+                structurals &= structurals - 1;
+            }
+        }
+    };
+
+    static bool json_build_index ( const char * text, uint32_t len, vector<uint32_t> & index ) {
+        JsonIndexer indexer;
+        index.reserve(len / 8 + 16);
+        uint32_t pos = 0;
+        for ( ; pos + 64 <= len; pos += 64 ) {
+            indexer.block(text + pos, pos, index);
+        }
+        if ( pos < len ) {
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, text + pos, len - pos);
+            indexer.block(tail, pos, index);
+        }
+        return indexer.prevInString == 0;
+    }
+
+    // stage 2 - walk the structural index and fill the tape
+
+    static __forceinline uint64_t json_tape_entry ( char kind, uint64_t payload ) {
+        return (uint64_t(uint8_t(kind)) << JSON_TAPE_KIND_SHIFT) | payload;
+    }
+
+    static __forceinline bool json_is_delimiter ( char ch ) {
+        switch ( ch ) {
+            case ' ': case '\t': case '\n': case '\r':
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static __forceinline bool json_is_digit ( char ch ) {
+        return ch>='0' && ch<='9';
+    }
+
+    static __forceinline const char * json_find_quote_or_slash ( const char * s, const char * end ) {
+        vec4i quote = v_splatsi8('\"'), slash = v_splatsi8('\\');
+        for ( ; s + 16 <= end; s += 16 ) {
+            vec4i b = v_ldui((const int *)s);
+            if ( uint32_t mask = uint32_t(v_signmaski8(v_ori(v_cmp_eqi8(b, quote), v_cmp_eqi8(b, slash)))) ) {
+                return s + __builtin_ctz(mask);
+            }
+        }
+        for ( ; s!=end; ++s ) {
+            if ( *s=='\"' || *s=='\\' ) return s;
+        }
+        return nullptr;
+    }
+
+    struct JsonTapeBuilder {
+        const char *        text = nullptr;
+        uint32_t            len = 0;
+        vector<uint32_t>    index;
+        uint32_t            cur = 0;
+        uint32_t            depth = 0;
+        uint64_t *          tape = nullptr;     // at most two entries per structural character
+        uint32_t            tapeSize = 0;
+        uint8_t *           strings = nullptr;  // unescaped strings never grow, plus 5 bytes of record per string
+        uint32_t            stringsSize = 0;
+        string              error;
+        bool fail ( const char * message, uint32_t at ) {
+            uint32_t line = 1, column = 1;
+            for ( uint32_t i=0; i!=at && i!=len; ++i ) {
+                if ( text[i]=='\n' ) {
+                    line ++;
+                    column = 1;
+                } else {
+                    column ++;
+                }
+            }
+            error = string(message) + " at line " + to_string(line) + ", column " + to_string(column);
+            return false;
+        }
+        __forceinline char peek() const {
+            return cur < index.size() ? text[index[cur]] : 0;
+        }
+        bool build_index ( const char * t, uint32_t l ) {
+            text = t;
+            len = l;
+            if ( !json_build_index(text, len, index) ) return fail("unterminated string", len);
+            if ( index.empty() ) return fail("empty json", len);
+            return true;
+        }
+        uint32_t max_tape_size() const {
+            return uint32_t(index.size()) * 2;
+        }
+        uint32_t max_strings_size() const {
+            return len + uint32_t(index.size()) * 5;
+        }
+        bool parse ( uint64_t * tapeData, uint8_t * stringsData ) {
+            tape = tapeData;
+            strings = stringsData;
+            if ( !value() ) return false;
+            if ( cur != index.size() ) return fail("unexpected trailing characters", index[cur]);
+            return true;
+        }
+        __forceinline void emit ( uint64_t entry ) {
+            tape[tapeSize++] = entry;
+        }
+        __forceinline void put ( uint8_t ch ) {
+            strings[stringsSize++] = ch;
+        }
+        bool value () {
+            if ( cur==index.size() ) return fail("unexpected end of json", len);
+            uint32_t at = index[cur++];
+            char ch = text[at];
+            switch ( ch ) {
+                case '{':   return object(at);
+                case '[':   return array(at);
+                case '\"':  return str(at);
+                case 't':   return literal(at, "true", 4);
+                case 'f':   return literal(at, "false", 5);
+                case 'n':   return literal(at, "null", 4);
+                default:
+                    if ( ch=='-' || ch=='+' || json_is_digit(ch) ) return number(at);
+                    return fail("unexpected character", at);
+            }
+        }
+        bool open ( uint32_t at ) {
+            if ( ++depth > JSON_MAX_DEPTH ) return fail("json is nested too deep", at);
+            emit(0);
+            return true;
+        }
+        void close ( char kind, uint32_t self, uint32_t count ) {
+            uint64_t cnt = das::min(count, uint32_t(JSON_TAPE_COUNT_MASK));
+            tape[self] = json_tape_entry(kind, (cnt << JSON_TAPE_COUNT_SHIFT) | uint64_t(tapeSize));
+            depth --;
+        }
+        bool separator ( char closing, const char * message ) {
+            if ( cur==index.size() ) return fail("unexpected end of json", len);
+            uint32_t at = index[cur++];
+            if ( text[at]==',' ) return true;
+            if ( text[at]==closing ) return false;
+            fail(message, at);
+            return false;
+        }
+        bool object ( uint32_t at ) {
+            uint32_t self = tapeSize;
+            if ( !open(at) ) return false;
+            uint32_t count = 0;
+            if ( peek()=='}' ) {
+                cur ++;
+            } else {
+                for ( ;; ) {
+                    if ( cur==index.size() ) return fail("unexpected end of json", len);
+                    uint32_t kat = index[cur++];
+                    if ( text[kat]!='\"' ) return fail("expecting string key", kat);
+                    if ( !str(kat) ) return false;
+                    if ( peek()!=':' ) return fail("expecting ':'", cur<index.size() ? index[cur] : len);
+                    cur ++;
+                    if ( !value() ) return false;
+                    count ++;
+                    if ( !separator('}', "expecting ',' or '}'") ) {
+                        if ( !error.empty() ) return false;
+                        break;
+                    }
+                }
+            }
+            close('{', self, count);
+            return true;
+        }
+        bool array ( uint32_t at ) {
+            uint32_t self = tapeSize;
+            if ( !open(at) ) return false;
+            uint32_t count = 0;
+            if ( peek()==']' ) {
+                cur ++;
+            } else {
+                for ( ;; ) {
+                    if ( !value() ) return false;
+                    count ++;
+                    if ( !separator(']', "expecting ',' or ']'") ) {
+                        if ( !error.empty() ) return false;
+                        break;
+                    }
+                }
+            }
+            close('[', self, count);
+            return true;
+        }
+        void utf8 ( uint32_t code ) {
+            if ( code < 0x80 ) {
+                put(uint8_t(code));
+            } else if ( code < 0x800 ) {
+                put(uint8_t(0xC0 | (code >> 6)));
+                put(uint8_t(0x80 | (code & 0x3F)));
+            } else if ( code < 0x10000 ) {
+                put(uint8_t(0xE0 | (code >> 12)));
+                put(uint8_t(0x80 | ((code >> 6) & 0x3F)));
+                put(uint8_t(0x80 | (code & 0x3F)));
+            } else {
+                put(uint8_t(0xF0 | (code >> 18)));
+                put(uint8_t(0x80 | ((code >> 12) & 0x3F)));
+                put(uint8_t(0x80 | ((code >> 6) & 0x3F)));
+                put(uint8_t(0x80 | (code & 0x3F)));
+            }
+        }
+        bool hex4 ( const char * s, const char * end, uint32_t & code ) {
+            if ( end - s < 4 ) return false;
+            code = 0;
+            for ( int i=0; i!=4; ++i ) {
+                char ch = s[i];
+                uint32_t h;
+                if ( ch>='0' && ch<='9' ) h = ch - '0';
+                else if ( ch>='a' && ch<='f' ) h = ch - 'a' + 10;
+                else if ( ch>='A' && ch<='F' ) h = ch - 'A' + 10;
+                else return false;
+                code = (code << 4) | h;
+            }
+            return true;
+        }
+        bool str ( uint32_t at ) {
+            uint32_t offset = stringsSize;
+            stringsSize += sizeof(uint32_t);
+            const char * s = text + at + 1;
+            const char * end = text + len;
+            for ( ;; ) {
+                const char * q = json_find_quote_or_slash(s, end);
+                if ( !q ) return fail("unterminated string", at);
+                memcpy(strings + stringsSize, s, q - s);
+                stringsSize += uint32_t(q - s);
+                if ( *q=='\"' ) break;
+                if ( q + 1 == end ) return fail("unterminated string", at);
+                char esc = q[1];
+                s = q + 2;
+                switch ( esc ) {
+                    case 'b':   put('\b'); break;
+                    case 'f':   put('\f'); break;
+                    case 'n':   put('\n'); break;
+                    case 'r':   put('\r'); break;
+                    case 't':   put('\t'); break;
+                    case 'u': {
+                            uint32_t code;
+                            if ( !hex4(s, end, code) ) return fail("invalid unicode escape", uint32_t(q - text));
+                            s += 4;
+                            if ( code>=0xD800 && code<0xDC00 && end - s >= 6 && s[0]=='\\' && s[1]=='u' ) {
+                                uint32_t low;
+                                if ( hex4(s + 2, end, low) && low>=0xDC00 && low<0xE000 ) {
+                                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                                    s += 6;
+                                }
+                            }
+                            utf8(code);
+                        }
+                        break;
+                    default:    put(uint8_t(esc)); break;   // \" \\ \/, and anything else stands for itself
+                }
+            }
+            uint32_t length = uint32_t(stringsSize - offset - sizeof(uint32_t));
+            memcpy(strings + offset, &length, sizeof(uint32_t));
+            put(0);
+            emit(json_tape_entry('\"', offset));
+            return true;
+        }
+        bool literal ( uint32_t at, const char * name, uint32_t nameLen ) {
+            if ( at + nameLen > len || memcmp(text + at, name, nameLen)!=0 ) return fail("invalid literal", at);
+            if ( at + nameLen < len && !json_is_delimiter(text[at + nameLen]) ) return fail("invalid literal", at);
+            emit(json_tape_entry(name[0], 0));
+            return true;
+        }
+        bool number ( uint32_t at ) {
+            const char * s = text + at;
+            const char * end = text + len;
+            const char * p = s;
+            bool negative = false;
+            if ( *p=='-' || *p=='+' ) negative = *p++=='-';
+            const char * digits = p;
+            uint64_t mantissa = 0;
+            for ( ; p!=end && json_is_digit(*p); ++p ) {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+            }
+            uint32_t numDigits = uint32_t(p - digits);
+            if ( !numDigits ) return fail("invalid number", at);
+            int32_t exponent = 0;
+            if ( p!=end && *p=='.' ) {
+                const char * fraction = ++p;
+                for ( ; p!=end && json_is_digit(*p); ++p ) {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                }
+                numDigits += uint32_t(p - fraction);
+                exponent = -int32_t(p - fraction);
+            }
+            bool hugeExponent = false;
+            if ( p!=end && (*p=='e' || *p=='E') ) {
+                ++p;
+                bool negativeExponent = false;
+                if ( p!=end && (*p=='+' || *p=='-') ) negativeExponent = *p++=='-';
+                if ( p==end || !json_is_digit(*p) ) return fail("invalid number", at);
+                int32_t e = 0;
+                for ( ; p!=end && json_is_digit(*p); ++p ) {
+                    if ( e < 100000 ) e = e * 10 + (*p - '0');
+                }
+                hugeExponent = e >= 100000;
+                exponent += negativeExponent ? -e : e;
+            }
+            if ( p!=end && !json_is_delimiter(*p) ) return fail("invalid number", at);
+            static const double powersOf10[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            double value;
+            if ( numDigits<=15 && exponent>=-22 && exponent<=22 && !hugeExponent ) {
+                // both mantissa and the power of 10 are exact, so the single multiplication or division rounds correctly
+                value = exponent<0 ? double(mantissa) / powersOf10[-exponent] : double(mantissa) * powersOf10[exponent];
+                if ( negative ) value = -value;
+            } else {
+                char buffer[64];
+                size_t numLen = size_t(p - s);
+                if ( numLen < sizeof(buffer) ) {
+                    memcpy(buffer, s, numLen);
+                    buffer[numLen] = 0;
+                    value = strtod(buffer, nullptr);
+                } else {
+                    value = strtod(string(s, numLen).c_str(), nullptr);
+                }
+            }
+            emit(json_tape_entry('d', 0));
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(double));
+            emit(bits);
+            return true;
+        }
+    };
+
+    // tape and strings are written straight into the arrays, which are trimmed to the actual size afterwards
+    static char * json_parse ( const char * text, uint32_t len, TArray<uint64_t> & tape, TArray<uint8_t> & strings, Context * context ) {
+        JsonTapeBuilder builder;
+        bool ok = builder.build_index(text, len);
+        if ( ok ) {
+            array_resize(*context, tape, builder.max_tape_size(), sizeof(uint64_t), false);
+            array_resize(*context, strings, builder.max_strings_size(), sizeof(uint8_t), false);
+            ok = builder.parse((uint64_t *) tape.data, (uint8_t *) strings.data);
+        }
+        array_resize(*context, tape, ok ? builder.tapeSize : 0, sizeof(uint64_t), false);
+        array_resize(*context, strings, ok ? builder.stringsSize : 0, sizeof(uint8_t), false);
+        return ok ? nullptr : context->stringHeap->allocateString(builder.error);
+    }
+
+    char * builtin_json_parse ( const char * text, TArray<uint64_t> & tape, TArray<uint8_t> & strings, Context * context ) {
+        if ( !text ) text = "";
+        return json_parse(text, stringLengthSafe(*context, text), tape, strings, context);
+    }
+
+    char * builtin_json_parse_bytes ( const TArray<uint8_t> & text, TArray<uint64_t> & tape, TArray<uint8_t> & strings, Context * context ) {
+        return json_parse(text.data ? text.data : "", text.size, tape, strings, context);
+    }
+
+    // lazy access to the tape
+
+    static __forceinline uint64_t json_entry ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        if ( uint32_t(index) >= tape.size ) context->throw_error_ex("json tape index out of range, %i of %u", index, tape.size);
+        return tape[index];
+    }
+
+    static __forceinline char json_kind ( uint64_t entry ) {
+        return char(entry >> JSON_TAPE_KIND_SHIFT);
+    }
+
+    static __forceinline int32_t json_skip ( const TArray<uint64_t> & tape, uint64_t entry, int32_t index, Context * context ) {
+        switch ( json_kind(entry) ) {
+            case '{':
+            case '[': {
+                    uint32_t end = uint32_t(entry);
+                    if ( end <= uint32_t(index) || end > tape.size ) context->throw_error_ex("json tape is corrupted at %i", index);
+                    return int32_t(end);
+                }
+            case 'd':
+                return index + 2;
+            default:
+                return index + 1;
+        }
+    }
+
+    static __forceinline uint64_t json_container ( const TArray<uint64_t> & tape, int32_t index, char kind, Context * context ) {
+        uint64_t entry = json_entry(tape, index, context);
+        if ( json_kind(entry)!=kind ) {
+            context->throw_error_ex(kind=='{' ? "json value at %i is not an object" : "json value at %i is not an array", index);
+        }
+        return entry;
+    }
+
+    static __forceinline const uint8_t * json_string_record ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context ) {
+        uint64_t entry = json_entry(tape, index, context);
+        if ( json_kind(entry)!='\"' ) context->throw_error_ex("json value at %i is not a string", index);
+        uint32_t offset = uint32_t(entry);
+        uint32_t length;
+        if ( uint64_t(offset) + sizeof(uint32_t) > strings.size ) context->throw_error_ex("json tape is corrupted at %i", index);
+        memcpy(&length, strings.data + offset, sizeof(uint32_t));
+        if ( uint64_t(offset) + sizeof(uint32_t) + length + 1 > strings.size ) context->throw_error_ex("json tape is corrupted at %i", index);
+        return (const uint8_t *) strings.data + offset;
+    }
+
+    static __forceinline uint32_t json_record_length ( const uint8_t * record ) {
+        uint32_t length;
+        memcpy(&length, record, sizeof(uint32_t));
+        return length;
+    }
+
+    int32_t builtin_json_kind ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        return json_kind(json_entry(tape, index, context));
+    }
+
+    int32_t builtin_json_next ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        return json_skip(tape, json_entry(tape, index, context), index, context);
+    }
+
+    int32_t builtin_json_length ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        uint64_t entry = json_entry(tape, index, context);
+        char kind = json_kind(entry);
+        if ( kind!='{' && kind!='[' ) context->throw_error_ex("json value at %i is not an array or an object", index);
+        uint32_t count = uint32_t(entry >> JSON_TAPE_COUNT_SHIFT) & JSON_TAPE_COUNT_MASK;
+        if ( count==JSON_TAPE_COUNT_MASK ) {
+            int32_t end = json_skip(tape, entry, index, context);
+            count = 0;
+            for ( int32_t i=index+1; i<end; ++count ) {
+                if ( kind=='{' ) i ++;
+                i = json_skip(tape, json_entry(tape, i, context), i, context);
+            }
+        }
+        return int32_t(count);
+    }
+
+    int32_t builtin_json_at ( const TArray<uint64_t> & tape, int32_t index, int32_t element, Context * context ) {
+        uint64_t entry = json_container(tape, index, '[', context);
+        int32_t end = json_skip(tape, entry, index, context);
+        if ( element < 0 ) return -1;
+        int32_t i = index + 1;
+        for ( ; i<end && element; --element ) {
+            i = json_skip(tape, json_entry(tape, i, context), i, context);
+        }
+        return i<end ? i : -1;
+    }
+
+    int32_t builtin_json_find ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, const char * key, Context * context ) {
+        uint64_t entry = json_container(tape, index, '{', context);
+        int32_t end = json_skip(tape, entry, index, context);
+        if ( !key ) key = "";
+        uint32_t keyLen = stringLengthSafe(*context, key);
+        for ( int32_t i=index+1; i<end; ) {
+            auto record = json_string_record(tape, strings, i, context);
+            if ( json_record_length(record)==keyLen && memcmp(record + sizeof(uint32_t), key, keyLen)==0 ) {
+                return i + 1;
+            }
+            i = json_skip(tape, json_entry(tape, i + 1, context), i + 1, context);
+        }
+        return -1;
+    }
+
+    double builtin_json_number ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        uint64_t entry = json_entry(tape, index, context);
+        if ( json_kind(entry)!='d' ) context->throw_error_ex("json value at %i is not a number", index);
+        uint64_t bits = json_entry(tape, index + 1, context);
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        return value;
+    }
+
+    bool builtin_json_bool ( const TArray<uint64_t> & tape, int32_t index, Context * context ) {
+        char kind = json_kind(json_entry(tape, index, context));
+        if ( kind!='t' && kind!='f' ) context->throw_error_ex("json value at %i is not a bool", index);
+        return kind=='t';
+    }
+
+    char * builtin_json_string ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context ) {
+        auto record = json_string_record(tape, strings, index, context);
+        uint32_t length = json_record_length(record);
+        if ( !length ) return nullptr;
+        return context->stringHeap->allocateString((const char *) record + sizeof(uint32_t), length);
+    }
+
+    StringView builtin_json_view ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context ) {
+        auto record = json_string_record(tape, strings, index, context);
+        return StringView { (const char *) record + sizeof(uint32_t), json_record_length(record) };
+    }
+
+    void builtin_json_for_each ( const TArray<uint64_t> & tape, int32_t index, const Block & block, Context * context ) {
+        uint64_t entry = json_container(tape, index, '[', context);
+        int32_t end = json_skip(tape, entry, index, context);
+        vec4f args[1];
+        for ( int32_t i=index+1; i<end; ) {
+            args[0] = cast<int32_t>::from(i);
+            context->invoke(block, args, nullptr);
+            i = json_skip(tape, json_entry(tape, i, context), i, context);
+        }
+    }
+
+    // keys are passed as temporary strings, which point directly into the string buffer
+    void builtin_json_for_each_field ( const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, const Block & block, Context * context ) {
+        uint64_t entry = json_container(tape, index, '{', context);
+        int32_t end = json_skip(tape, entry, index, context);
+        vec4f args[2];
+        for ( int32_t i=index+1; i<end; ) {
+            auto record = json_string_record(tape, strings, i, context);
+            args[0] = cast<char *>::from(json_record_length(record) ? (char *) record + sizeof(uint32_t) : nullptr);
+            args[1] = cast<int32_t>::from(i + 1);
+            context->invoke(block, args, nullptr);
+            i = json_skip(tape, json_entry(tape, i + 1, context), i + 1, context);
+        }
+    }
+
+    // writer
+
+    static void json_write_escaped ( StringBuilderWriter & writer, const char * str, uint32_t len ) {
+        static const char * hex = "0123456789abcdef";
+        writer.writeChars('\"', 1);
+        const char * s = str;
+        const char * end = str + len;
+        while ( s != end ) {
+            const char * e = s;
+            while ( e!=end && *e!='\"' && *e!='\\' && uint8_t(*e)>=0x20 ) e++;
+            if ( e!=s ) writer.writeStr(s, e - s);
+            if ( e==end ) break;
+            char ch = *e;
+            switch ( ch ) {
+                case '\"':  writer.writeStr("\\\"", 2); break;
+                case '\\':  writer.writeStr("\\\\", 2); break;
+                case '\b':  writer.writeStr("\\b", 2); break;
+                case '\f':  writer.writeStr("\\f", 2); break;
+                case '\n':  writer.writeStr("\\n", 2); break;
+                case '\r':  writer.writeStr("\\r", 2); break;
+                case '\t':  writer.writeStr("\\t", 2); break;
+                default: {
+                        char code[6] = { '\\', 'u', '0', '0', hex[(ch>>4) & 0xf], hex[ch & 0xf] };
+                        writer.writeStr(code, 6);
+                    }
+                    break;
+            }
+            s = e + 1;
+        }
+        writer.writeChars('\"', 1);
+    }
+
+    void builtin_json_write_string ( StringBuilderWriter & writer, const char * str ) {
+        json_write_escaped(writer, str ? str : "", str ? uint32_t(strlen(str)) : 0);
+    }
+
+    void builtin_json_write_number ( StringBuilderWriter & writer, double value ) {
+        char buffer[32];
+        int len;
+        if ( value!=value || value==HUGE_VAL || value==-HUGE_VAL ) {
+            writer.writeStr("null", 4);
+            return;
+        } else if ( value>-1e15 && value<1e15 && value==double(int64_t(value)) ) {    // range first, out of range cast is UB
+            len = snprintf(buffer, sizeof(buffer), "%lld", (long long) int64_t(value));
+        } else {
+            // shortest of the two which reads back exactly
+            len = snprintf(buffer, sizeof(buffer), "%.15g", value);
+            if ( strtod(buffer, nullptr)!=value ) {
+                len = snprintf(buffer, sizeof(buffer), "%.17g", value);
+            }
+        }
+        writer.writeStr(buffer, len);
+    }
+
+    static int32_t json_write_value ( StringBuilderWriter & writer, const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, uint32_t depth, Context * context ) {
+        uint64_t entry = json_entry(tape, index, context);
+        switch ( json_kind(entry) ) {
+            case '{':
+            case '[': {
+                    if ( depth > JSON_MAX_DEPTH ) context->throw_error("json is nested too deep");
+                    bool isObject = json_kind(entry)=='{';
+                    int32_t end = json_skip(tape, entry, index, context);
+                    writer.writeChars(isObject ? '{' : '[', 1);
+                    for ( int32_t i=index+1; i<end; ) {
+                        if ( i!=index+1 ) writer.writeChars(',', 1);
+                        if ( isObject ) {
+                            auto record = json_string_record(tape, strings, i, context);
+                            json_write_escaped(writer, (const char *) record + sizeof(uint32_t), json_record_length(record));
+                            writer.writeChars(':', 1);
+                            i ++;
+                        }
+                        i = json_write_value(writer, tape, strings, i, depth + 1, context);
+                    }
+                    writer.writeChars(isObject ? '}' : ']', 1);
+                    return end;
+                }
+            case '\"': {
+                    auto record = json_string_record(tape, strings, index, context);
+                    json_write_escaped(writer, (const char *) record + sizeof(uint32_t), json_record_length(record));
+                    return index + 1;
+                }
+            case 'd':
+                builtin_json_write_number(writer, builtin_json_number(tape, index, context));
+                return index + 2;
+            case 't':
+                writer.writeStr("true", 4);
+                return index + 1;
+            case 'f':
+                writer.writeStr("false", 5);
+                return index + 1;
+            case 'n':
+                writer.writeStr("null", 4);
+                return index + 1;
+            default:
+                context->throw_error_ex("json tape is corrupted at %i", index);
+                return index + 1;
+        }
+    }
+
+    void builtin_json_write ( StringBuilderWriter & writer, const TArray<uint64_t> & tape, const TArray<uint8_t> & strings, int32_t index, Context * context ) {
+        json_write_value(writer, tape, strings, index, 0, context);
+    }
+
+    class Module_JsonNative : public Module {
+    public:
+        Module_JsonNative() : Module("json_native") {
+            DAS_PROFILE_SECTION("Module_JsonNative");
+            ModuleLibrary lib;
+            lib.addModule(this);
+            lib.addBuiltInModule();
+            lib.addModule(Module::require("strings"));
+            // parser
+            addExtern<DAS_BIND_FUN(builtin_json_parse)>(*this, lib, "json_parse",
+                SideEffects::modifyArgumentAndExternal, "builtin_json_parse")->args({"text","tape","strings","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_parse_bytes)>(*this, lib, "json_parse",
+                SideEffects::modifyArgumentAndExternal, "builtin_json_parse_bytes")->args({"text","tape","strings","context"});
+            // tape access
+            addExtern<DAS_BIND_FUN(builtin_json_kind)>(*this, lib, "json_kind",
+                SideEffects::none, "builtin_json_kind")->args({"tape","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_next)>(*this, lib, "json_next",
+                SideEffects::none, "builtin_json_next")->args({"tape","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_length)>(*this, lib, "json_length",
+                SideEffects::none, "builtin_json_length")->args({"tape","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_at)>(*this, lib, "json_at",
+                SideEffects::none, "builtin_json_at")->args({"tape","index","element","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_find)>(*this, lib, "json_find",
+                SideEffects::none, "builtin_json_find")->args({"tape","strings","index","key","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_number)>(*this, lib, "json_number",
+                SideEffects::none, "builtin_json_number")->args({"tape","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_bool)>(*this, lib, "json_bool",
+                SideEffects::none, "builtin_json_bool")->args({"tape","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_string)>(*this, lib, "json_string",
+                SideEffects::none, "builtin_json_string")->args({"tape","strings","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_view)>(*this, lib, "json_view",
+                SideEffects::none, "builtin_json_view")->args({"tape","strings","index","context"})->unsafeOperation = true;
+            addExtern<DAS_BIND_FUN(builtin_json_for_each)>(*this, lib, "json_for_each",
+                SideEffects::invoke, "builtin_json_for_each")->args({"tape","index","block","context"});
+            addExtern<DAS_BIND_FUN(builtin_json_for_each_field)>(*this, lib, "json_for_each_field",
+                SideEffects::invoke, "builtin_json_for_each_field")->args({"tape","strings","index","block","context"});
+            // writer
+            addExtern<DAS_BIND_FUN(builtin_json_write_string)>(*this, lib, "json_write_string",
+                SideEffects::modifyArgument, "builtin_json_write_string")->args({"writer","str"});
+            addExtern<DAS_BIND_FUN(builtin_json_write_number)>(*this, lib, "json_write_number",
+                SideEffects::modifyArgument, "builtin_json_write_number")->args({"writer","value"});
+            addExtern<DAS_BIND_FUN(builtin_json_write)>(*this, lib, "json_write",
+                SideEffects::modifyArgument, "builtin_json_write")->args({"writer","tape","strings","index","context"});
+            verifyAotReady();
+        }
+        virtual ModuleAotType aotRequire ( TextWriter & tw ) const override {
+            tw << "#include \"daScript/simulate/aot_builtin_json.h\"\n";
+            return ModuleAotType::cpp;
+        }
+    };
+}
+
+REGISTER_MODULE_IN_NAMESPACE(Module_JsonNative,das);
+
@@ -0,0 +1,610 @@
+#include "daScript/misc/platform.h"
+
+#include "module_builtin.h"
+
+#include "daScript/ast/ast_interop.h"
+#include "daScript/ast/ast_handle.h"
+#include "daScript/simulate/aot_builtin_regex.h"
+#include "daScript/simulate/runtime_string.h"
+#include "daScript/misc/arraytype.h"
+#include "daScript/misc/performance_time.h"
+
+MAKE_TYPE_FACTORY(RegexEngine, das::RegexEngine)
+
+namespace das {
+
+    // program reader. the tree is rebuilt, so that it can be compiled both forward and backward
+
+    struct RegexNode {
+        RegexOp             op = RegexOp::Char;
+        int32_t             arg = 0;        // group index, or greedy flag
+        string              text;
+        uint32_t            cset[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        vector<RegexNode>   subs;
+    };
+
+    struct RegexProgramReader {
+        const int32_t * prog = nullptr;
+        int32_t         size = 0;
+        int32_t         at = 0;
+        string          error;
+        bool fail ( const char * message ) {
+            if ( error.empty() ) error = string(message) + " at " + to_string(at);
+            return false;
+        }
+        bool read ( RegexNode & node, int32_t depth ) {
+            if ( depth>1024 ) return fail("regex is too deeply nested");
+            if ( at>=size ) return fail("unexpected end of program");
+            int32_t op = prog[at++];
+            if ( op<int32_t(RegexOp::Char) || op>int32_t(RegexOp::Union) ) return fail("invalid operation");
+            node.op = RegexOp(op);
+            switch ( node.op ) {
+            case RegexOp::Char: {
+                    if ( at>=size ) return fail("expecting length");
+                    int32_t len = prog[at++];
+                    if ( len<=0 || len>size-at ) return fail("invalid length");
+                    node.text.reserve(len);
+                    for ( int32_t i=0; i!=len; ++i ) node.text.push_back(char(prog[at++]));
+                }
+                return true;
+            case RegexOp::Set:
+                if ( size-at<8 ) return fail("expecting character set");
+                for ( int32_t i=0; i!=8; ++i ) node.cset[i] = uint32_t(prog[at++]);
+                return true;
+            case RegexOp::Any:
+            case RegexOp::Eos:
+                return true;
+            case RegexOp::Group:
+            case RegexOp::Plus:
+            case RegexOp::Star:
+            case RegexOp::Question:
+                if ( at>=size ) return fail("expecting argument");
+                node.arg = prog[at++];
+                node.subs.resize(1);
+                return read(node.subs[0], depth+1);
+            case RegexOp::Concat:
+                node.subs.resize(2);
+                return read(node.subs[0], depth+1) && read(node.subs[1], depth+1);
+            case RegexOp::Union: {
+                    if ( at>=size ) return fail("expecting count");
+                    int32_t count = prog[at++];
+                    if ( count<=0 || count>size-at ) return fail("invalid count");
+                    node.subs.resize(count);
+                    for ( auto & sub : node.subs ) {
+                        if ( !read(sub, depth+1) ) return false;
+                    }
+                }
+                return true;
+            }
+            return fail("invalid operation");
+        }
+    };
+
+    // thompson construction. splits list the preferred branch first, the pike vm follows that order
+
+    struct RegexCompiler {
+        vector<RegexInstruction> &  code;
+        bool                        reverse;
+        int32_t                     groups;
+        string                      error;
+        RegexCompiler ( vector<RegexInstruction> & c, bool r, int32_t g ) : code(c), reverse(r), groups(g) {}
+        int32_t emit ( uint8_t op ) {
+            code.emplace_back();
+            code.back().op = op;
+            return int32_t(code.size()) - 1;
+        }
+        int32_t here() const { return int32_t(code.size()); }
+        void split ( int32_t at, int32_t preferred, int32_t other ) {
+            code[at].x = preferred;
+            code[at].y = other;
+        }
+        void compile ( const RegexNode & node ) {
+            switch ( node.op ) {
+            case RegexOp::Char: {
+                    int32_t len = int32_t(node.text.size());
+                    for ( int32_t i=0; i!=len; ++i ) {
+                        uint8_t ch = uint8_t(node.text[reverse ? len-1-i : i]);
+                        int32_t pc = emit(RegexInstruction::Set);
+                        code[pc].cset[ch>>5] |= 1u << (ch & 31);
+                    }
+                }
+                break;
+            case RegexOp::Set: {
+                    int32_t pc = emit(RegexInstruction::Set);
+                    memcpy(code[pc].cset, node.cset, sizeof(node.cset));
+                }
+                break;
+            case RegexOp::Any: {
+                    int32_t pc = emit(RegexInstruction::Set);
+                    for ( auto & w : code[pc].cset ) w = 0xffffffff;
+                    code[pc].cset[0] &= ~1u;
+                }
+                break;
+            case RegexOp::Eos:
+                emit(RegexInstruction::Eos);
+                break;
+            case RegexOp::Group:
+                if ( node.arg<0 || node.arg>=groups ) {
+                    error = "group index " + to_string(node.arg) + " out of range";
+                    return;
+                }
+                if ( !reverse ) code[emit(RegexInstruction::Save)].x = node.arg * 2;
+                compile(node.subs[0]);
+                if ( !reverse ) code[emit(RegexInstruction::Save)].x = node.arg * 2 + 1;
+                break;
+            case RegexOp::Plus: {
+                    int32_t loop = here();
+                    compile(node.subs[0]);
+                    int32_t sp = emit(RegexInstruction::Split);
+                    if ( node.arg ) split(sp, loop, sp+1); else split(sp, sp+1, loop);
+                }
+                break;
+            case RegexOp::Star: {
+                    int32_t sp = emit(RegexInstruction::Split);
+                    compile(node.subs[0]);
+                    code[emit(RegexInstruction::Jump)].x = sp;
+                    if ( node.arg ) split(sp, sp+1, here()); else split(sp, here(), sp+1);
+                }
+                break;
+            case RegexOp::Question: {
+                    int32_t sp = emit(RegexInstruction::Split);
+                    compile(node.subs[0]);
+                    if ( node.arg ) split(sp, sp+1, here()); else split(sp, here(), sp+1);
+                }
+                break;
+            case RegexOp::Concat:
+                compile(node.subs[reverse ? 1 : 0]);
+                compile(node.subs[reverse ? 0 : 1]);
+                break;
+            case RegexOp::Union: {
+                    vector<int32_t> jumps;
+                    int32_t count = int32_t(node.subs.size());
+                    for ( int32_t i=0; i!=count; ++i ) {
+                        if ( i+1!=count ) {
+                            int32_t sp = emit(RegexInstruction::Split);
+                            compile(node.subs[i]);
+                            jumps.push_back(emit(RegexInstruction::Jump));
+                            split(sp, sp+1, here());
+                        } else {
+                            compile(node.subs[i]);
+                        }
+                    }
+                    for ( auto j : jumps ) code[j].x = here();
+                }
+                break;
+            }
+        }
+    };
+
+    // lazy dfa
+
+    void RegexDfa::init ( const vector<RegexInstruction> * prog, bool unanch ) {
+        program = prog;
+        unanchored = unanch;
+        marks.resize(prog->size());
+        flush();
+    }
+
+    void RegexDfa::flush () {
+        states.clear();
+        lookup.clear();
+        next.clear();
+        flags.clear();
+        startState = startAtEndState = -1;
+        vector<int32_t> dead;
+        state(dead);
+    }
+
+    void RegexDfa::fresh () {
+        if ( ++generation==0 ) {
+            fill(marks.begin(), marks.end(), 0);
+            generation = 1;
+        }
+    }
+
+    // adds all instructions, which consume input, and are reachable from pc without consuming any
+    void RegexDfa::closure ( int32_t pc, bool followEos, vector<int32_t> & set ) {
+        stack.push_back(pc);
+        while ( !stack.empty() ) {
+            int32_t at = stack.back();
+            stack.pop_back();
+            if ( marks[at]==generation ) continue;
+            marks[at] = generation;
+            const auto & inst = (*program)[at];
+            switch ( inst.op ) {
+            case RegexInstruction::Jump:    stack.push_back(inst.x); break;
+            case RegexInstruction::Split:   stack.push_back(inst.y); stack.push_back(inst.x); break;
+            case RegexInstruction::Save:    stack.push_back(at+1); break;
+            case RegexInstruction::Eos:
+                if ( followEos ) stack.push_back(at+1);
+                else set.push_back(at);
+                break;
+            default:
+                set.push_back(at);
+                break;
+            }
+        }
+    }
+
+    int32_t RegexDfa::state ( vector<int32_t> & set ) {
+        sort(set.begin(), set.end());
+        string key((const char *)set.data(), set.size()*sizeof(int32_t));
+        auto it = lookup.find(key);
+        if ( it!=lookup.end() ) return it->second;
+        int32_t id = int32_t(states.size());
+        uint8_t flag = 0;
+        vector<int32_t> atEnd;
+        fresh();
+        for ( auto pc : set ) {
+            auto op = (*program)[pc].op;
+            if ( op==RegexInstruction::Match ) {
+                flag |= FLAG_MATCH | FLAG_MATCH_AT_END;
+            } else if ( op==RegexInstruction::Eos ) {
+                closure(pc+1, true, atEnd);
+            }
+        }
+        for ( auto pc : atEnd ) {
+            if ( (*program)[pc].op==RegexInstruction::Match ) flag |= FLAG_MATCH_AT_END;
+        }
+        states.push_back(set);
+        lookup[key] = id;
+        next.resize(next.size() + 256, -1);
+        flags.push_back(flag);
+        return id;
+    }
+
+    int32_t RegexDfa::start () {
+        if ( startState<0 ) {
+            vector<int32_t> set;
+            fresh();
+            closure(0, false, set);
+            startState = state(set);
+        }
+        return startState;
+    }
+
+    // only the reverse dfa needs this. it starts at the end of the text, where $ is satisfied
+    int32_t RegexDfa::startAtEnd () {
+        if ( startAtEndState<0 ) {
+            vector<int32_t> set;
+            fresh();
+            closure(0, true, set);
+            startAtEndState = state(set);
+        }
+        return startAtEndState;
+    }
+
+    int32_t RegexDfa::compute ( int32_t st, uint8_t ch ) {
+        if ( states.size()>=MAX_STATES ) {
+            auto current = states[st];
+            flush();
+            flushes ++;
+            st = state(current);
+        }
+        vector<int32_t> set;
+        fresh();
+        for ( auto pc : states[st] ) {
+            const auto & inst = (*program)[pc];
+            if ( inst.op==RegexInstruction::Set && inst.has(ch) ) closure(pc+1, false, set);
+        }
+        if ( unanchored ) closure(0, false, set);
+        int32_t t = state(set);
+        next[(st<<8) | ch] = t;
+        return t;
+    }
+
+    // engine
+
+    RegexEngine::RegexEngine ( const int32_t * prog, int32_t size, int32_t ngroups ) : groups(ngroups) {
+        RegexProgramReader reader;
+        reader.prog = prog;
+        reader.size = size;
+        RegexNode root;
+        if ( !reader.read(root, 0) ) {
+            error = reader.error;
+            return;
+        }
+        if ( reader.at!=size ) {
+            error = "unexpected trailing data in program";
+            return;
+        }
+        RegexCompiler fwd(program, false, groups);
+        fwd.compile(root);
+        fwd.emit(RegexInstruction::Match);
+        RegexCompiler bwd(reversed, true, groups);
+        bwd.compile(root);
+        bwd.emit(RegexInstruction::Match);
+        if ( !fwd.error.empty() ) {
+            error = fwd.error;
+            return;
+        }
+        forward.init(&program, false);
+        backward.init(&reversed, true);
+        marks.resize(program.size());
+        // prefilter. all matches start with one of the characters in the first set,
+        // unless the regex can match an empty string or starts with $
+        vector<int32_t> set;
+        forward.fresh();
+        forward.closure(0, false, set);
+        canPrefilter = true;
+        for ( auto pc : set ) {
+            const auto & inst = program[pc];
+            if ( inst.op!=RegexInstruction::Set ) {
+                canPrefilter = false;
+                break;
+            }
+            for ( int32_t i=0; i!=8; ++i ) firstSet[i] |= inst.cset[i];
+        }
+        if ( !canPrefilter ) return;
+        for ( int32_t ch=1; ch!=256 && firstBytes.size()<=4; ++ch ) {
+            if ( firstSet[ch>>5] & (1u<<(ch & 31)) ) firstBytes.push_back(char(ch));
+        }
+        if ( firstBytes.size()>4 ) firstBytes.clear();
+        // longest literal, which all matches start with
+        while ( set.size()==1 && prefix.size()<64 ) {
+            const auto & inst = program[set[0]];
+            if ( inst.op!=RegexInstruction::Set ) break;
+            int32_t single = -1;
+            for ( int32_t ch=0; ch!=256; ++ch ) {
+                if ( inst.has(uint8_t(ch)) ) {
+                    if ( single!=-1 ) { single = -1; break; }
+                    single = ch;
+                }
+            }
+            if ( single<=0 ) break;
+            prefix.push_back(char(single));
+            int32_t pc = set[0] + 1;
+            set.clear();
+            forward.fresh();
+            forward.closure(pc, false, set);
+        }
+    }
+
+    int32_t RegexEngine::candidate ( const char * str, int32_t from, int32_t len ) const {
+        if ( !canPrefilter || from>=len ) return from<len ? from : -1;
+        const char * found = nullptr;
+        if ( prefix.size()>=2 ) {
+            found = find_substring(str + from, uint32_t(len - from), prefix.c_str(), uint32_t(prefix.size()));
+        } else if ( !firstBytes.empty() ) {
+            found = find_first_of(str + from, uint32_t(len - from), firstBytes.c_str(), uint32_t(firstBytes.size()));
+        } else {
+            for ( int32_t i=from; i<len; ++i ) {
+                uint8_t ch = uint8_t(str[i]);
+                if ( firstSet[ch>>5] & (1u<<(ch & 31)) ) return i;
+            }
+        }
+        return found ? int32_t(found - str) : -1;
+    }
+
+    // end of the longest match, which starts at from. dfa runs until it can't match anymore.
+    // unique is set when there is no other match, which starts there. then its also the one the pike vm would pick
+    int32_t RegexEngine::longest ( const uint8_t * str, int32_t from, int32_t len, int32_t & scanned, bool & unique ) {
+        int32_t st = forward.start();
+        int32_t last = forward.isMatch(st) ? from : -1;
+        int32_t ends = last>=0 ? 1 : 0;
+        int32_t i = from;
+        for ( ; i<len; ++i ) {
+            st = forward.step(st, str[i]);
+            if ( st==RegexDfa::DEAD ) break;
+            if ( forward.isMatch(st) ) {
+                last = i + 1;
+                ends ++;
+            }
+        }
+        if ( i==len && forward.isMatchAtEnd(st) && last!=len ) {
+            last = len;
+            ends ++;
+        }
+        scanned = i - from;
+        unique = ends<=1;
+        return last;
+    }
+
+    // pike vm, which only runs over the span the dfa already found. threads are kept in priority order,
+    // once one of them matches the ones after it are dropped, and the ones before it keep going.
+    // that way alternatives and repetitions pick the same match as backtracking would, i.e. a|ab matches a in ab.
+    // returns the end of that match, memory is bounded by the program size
+    int32_t RegexEngine::first ( const uint8_t * str, int32_t from, int32_t to, int32_t len, range * caps ) {
+        int32_t nslots = groups * 2;
+        auto add = [&]( int32_t list, int32_t pc, int32_t * cap, int32_t pos, auto && self ) -> void {
+            if ( marks[pc]==generation ) return;
+            marks[pc] = generation;
+            const auto & inst = program[pc];
+            switch ( inst.op ) {
+            case RegexInstruction::Jump:
+                self(list, inst.x, cap, pos, self);
+                break;
+            case RegexInstruction::Split:
+                self(list, inst.x, cap, pos, self);
+                self(list, inst.y, cap, pos, self);
+                break;
+            case RegexInstruction::Save: {
+                    int32_t old = cap[inst.x];
+                    cap[inst.x] = pos;
+                    self(list, pc+1, cap, pos, self);
+                    cap[inst.x] = old;
+                }
+                break;
+            case RegexInstruction::Eos:
+                if ( pos==len ) self(list, pc+1, cap, pos, self);
+                break;
+            default:
+                threads[list].push_back(pc);
+                slots[list].insert(slots[list].end(), cap, cap + nslots);
+                break;
+            }
+        };
+        auto fresh = [&]() {
+            if ( ++generation==0 ) {
+                fill(marks.begin(), marks.end(), 0);
+                generation = 1;
+            }
+        };
+        scratch.assign(nslots, -1);
+        int32_t end = -1;
+        int32_t cur = 0;
+        threads[cur].clear();
+        slots[cur].clear();
+        fresh();
+        add(cur, 0, scratch.data(), from, add);
+        for ( int32_t pos=from; ; ++pos ) {
+            int32_t nxt = cur ^ 1;
+            threads[nxt].clear();
+            slots[nxt].clear();
+            fresh();
+            for ( size_t t=0; t!=threads[cur].size(); ++t ) {
+                const auto & inst = program[threads[cur][t]];
+                int32_t * cap = slots[cur].data() + t*nslots;
+                if ( inst.op==RegexInstruction::Match ) {
+                    end = pos;
+                    scratch.assign(cap, cap + nslots);
+                    break;
+                } else if ( pos<to && inst.has(str[pos]) ) {
+                    add(nxt, threads[cur][t]+1, cap, pos+1, add);
+                }
+            }
+            if ( pos==to || threads[nxt].empty() ) break;
+            cur = nxt;
+        }
+        bool matched = end>=0;
+        if ( !matched ) end = to;       // dfa found a match, so there is one
+        if ( groups ) caps[0] = range(from, end);
+        for ( int32_t g=1; g<groups; ++g ) {
+            int32_t a = matched ? scratch[g*2] : -1;
+            int32_t b = matched ? scratch[g*2+1] : -1;
+            caps[g] = (a>=0 && b>=a) ? range(a, b) : range(0, 0);
+        }
+        return end;
+    }
+
+    // reverse dfa runs backwards from the end, and marks every position where some match starts
+    void RegexEngine::markStarts ( const uint8_t * str, int32_t from, int32_t len, vector<uint64_t> & starts ) {
+        starts.assign((len>>6) + 1, 0);
+        int32_t st = backward.startAtEnd();
+        for ( int32_t i=len-1; i>=from; --i ) {
+            st = backward.step(st, str[i]);
+            if ( backward.isMatch(st) ) starts[i>>6] |= 1ull << (i & 63);
+        }
+    }
+
+    static int32_t regex_next_start ( const vector<uint64_t> & starts, int32_t from, int32_t len ) {
+        for ( int32_t w=from>>6, n=int32_t(starts.size()); w<n; ++w ) {
+            uint64_t bits = starts[w];
+            if ( w==(from>>6) ) bits &= ~0ull << (from & 63);
+            if ( bits ) {
+                int32_t at = (w<<6) + int32_t(__builtin_ctzll(bits));
+                return at<len ? at : -1;
+            }
+        }
+        return -1;
+    }
+
+    int32_t RegexEngine::match ( const char * str, int32_t len, int32_t offset, range * caps ) {
+        lock_guard<mutex> guard(lock);
+        int32_t scanned = 0;
+        bool unique = true;
+        int32_t end = longest((const uint8_t *)str, offset, len, scanned, unique);
+        if ( end>=0 ) {
+            if ( groups>1 || !unique ) end = first((const uint8_t *)str, offset, end, len, caps);
+            else if ( groups ) caps[0] = range(offset, end);
+        }
+        return end;
+    }
+
+    // candidates come from the prefilter. each failed attempt costs the length the dfa scanned,
+    // once that exceeds a few passes over the text, the exact starts are found with one reverse pass,
+    // which keeps the whole search linear
+    void RegexEngine::foreach ( const char * str, int32_t len, range * caps, const Block & block, Context * context ) {
+        auto ustr = (const uint8_t *) str;
+        vector<uint64_t> starts;
+        bool exact = false;
+        bool unique = true;
+        int64_t wasted = 0;
+        int64_t budget = int64_t(len) * 4 + 256;
+        vec4f args[1];
+        for ( int32_t pos=0; pos<len; ) {
+            int32_t end = -1;
+            {
+                lock_guard<mutex> guard(lock);
+                while ( pos>=0 && pos<len ) {
+                    pos = exact ? regex_next_start(starts, pos, len) : candidate(str, pos, len);
+                    if ( pos<0 ) break;
+                    int32_t scanned = 0;
+                    end = longest(ustr, pos, len, scanned, unique);
+                    if ( end>=0 ) break;
+                    wasted += scanned + 1;
+                    pos ++;
+                    if ( !exact && wasted>budget && pos<len ) {
+                        markStarts(ustr, pos, len, starts);
+                        exact = true;
+                    }
+                }
+                if ( end<0 ) break;
+                if ( groups>1 || !unique ) end = first(ustr, pos, end, len, caps);
+                else if ( groups ) caps[0] = range(pos, end);
+            }
+            args[0] = cast<range>::from(range(pos, end));
+            if ( !cast<bool>::to(context->invoke(block, args, nullptr)) ) break;
+            pos = end>pos ? end : pos + 1;
+        }
+    }
+
+    smart_ptr<RegexEngine> builtin_regex_engine ( const TArray<int32_t> & program, int32_t groups, Context * context ) {
+        if ( groups<0 ) context->throw_error_ex("invalid regex group count %i", groups);
+        auto engine = make_smart<RegexEngine>((const int32_t *) program.data, int32_t(program.size), groups);
+        if ( !engine->getError().empty() ) context->throw_error_ex("invalid regex program, %s", engine->getError().c_str());
+        return engine;
+    }
+
+    int32_t builtin_regex_engine_match ( const smart_ptr_raw<RegexEngine> engine, const char * str, int32_t offset, TArray<range> & captures, Context * context ) {
+        if ( !engine ) context->throw_error("regex is not compiled");
+        int32_t len = int32_t(stringLengthSafe(*context, str));
+        if ( offset<0 || offset>len ) context->throw_error_ex("regex match offset %i is out of range 0..%i", offset, len);
+        array_resize(*context, captures, engine->groupCount(), sizeof(range), true);
+        return engine->match(str ? str : "", len, offset, (range *) captures.data);
+    }
+
+    void builtin_regex_engine_foreach ( const smart_ptr_raw<RegexEngine> engine, const char * str, TArray<range> & captures, const Block & block, Context * context ) {
+        if ( !engine ) context->throw_error("regex is not compiled");
+        int32_t len = int32_t(stringLengthSafe(*context, str));
+        array_resize(*context, captures, engine->groupCount(), sizeof(range), true);
+        if ( len ) engine->foreach(str, len, (range *) captures.data, block, context);
+    }
+
+    int32_t builtin_regex_engine_dfa_states ( const smart_ptr_raw<RegexEngine> engine ) {
+        return engine ? engine->dfaStates() : 0;
+    }
+
+    struct RegexEngineAnnotation : ManagedStructureAnnotation<RegexEngine,false,false> {
+        RegexEngineAnnotation(ModuleLibrary & ml)
+            : ManagedStructureAnnotation ("RegexEngine", ml) {
+        }
+    };
+
+    class Module_RegexNative : public Module {
+    public:
+        Module_RegexNative() : Module("regex_native") {
+            DAS_PROFILE_SECTION("Module_RegexNative");
+            ModuleLibrary lib;
+            lib.addModule(this);
+            lib.addBuiltInModule();
+            addAnnotation(make_smart<RegexEngineAnnotation>(lib));
+            addExtern<DAS_BIND_FUN(builtin_regex_engine)>(*this, lib, "regex_engine",
+                SideEffects::modifyExternal, "builtin_regex_engine")->args({"program","groups","context"});
+            addExtern<DAS_BIND_FUN(builtin_regex_engine_match)>(*this, lib, "regex_engine_match",
+                SideEffects::modifyArgumentAndExternal, "builtin_regex_engine_match")->args({"engine","str","offset","captures","context"});
+            addExtern<DAS_BIND_FUN(builtin_regex_engine_foreach)>(*this, lib, "regex_engine_foreach",
+                SideEffects::modifyArgumentAndExternal, "builtin_regex_engine_foreach")->args({"engine","str","captures","block","context"});
+            addExtern<DAS_BIND_FUN(builtin_regex_engine_dfa_states)>(*this, lib, "regex_engine_dfa_states",
+                SideEffects::accessExternal, "builtin_regex_engine_dfa_states")->args({"engine"});
+            verifyAotReady();
+        }
+        virtual ModuleAotType aotRequire ( TextWriter & tw ) const override {
+            tw << "#include \"daScript/simulate/aot_builtin_regex.h\"\n";
+            return ModuleAotType::cpp;
+        }
+    };
+}
+
+REGISTER_MODULE_IN_NAMESPACE(Module_RegexNative,das);
+
@@ -7,6 +7,7 @@
 #include "daScript/simulate/sim_policy.h"
 #include "daScript/simulate/fs_file_info.h"
 #include "daScript/simulate/simulate_visit_op.h"
+#include "daScript/simulate/simulate_fusion_profile.h"
 
 #include "daScript/misc/performance_time.h"
 
@@ -511,6 +512,8 @@ namespace das {
             addField<DAS_BIND_MANAGED_FIELD(persistent_heap)>("persistent_heap");
             addField<DAS_BIND_MANAGED_FIELD(heap_size_hint)>("heap_size_hint");
             addField<DAS_BIND_MANAGED_FIELD(string_heap_size_hint)>("string_heap_size_hint");
+            addField<DAS_BIND_MANAGED_FIELD(string_heap_header)>("string_heap_header");
+            addField<DAS_BIND_MANAGED_FIELD(fork_globals_image)>("fork_globals_image");
         // rtti
             addField<DAS_BIND_MANAGED_FIELD(rtti)>("rtti");
         // language
@@ -529,6 +532,9 @@ namespace das {
             addField<DAS_BIND_MANAGED_FIELD(no_optimizations)>("no_optimizations");
             addField<DAS_BIND_MANAGED_FIELD(fail_on_no_aot)>("fail_on_no_aot");
             addField<DAS_BIND_MANAGED_FIELD(fail_on_lack_of_aot_export)>("fail_on_lack_of_aot_export");
+            addField<DAS_BIND_MANAGED_FIELD(compile_threads)>("compile_threads");
+            addField<DAS_BIND_MANAGED_FIELD(bytecode_engine)>("bytecode_engine");
+            addField<DAS_BIND_MANAGED_FIELD(profile_fusion)>("profile_fusion");
         // debugger
             addField<DAS_BIND_MANAGED_FIELD(debugger)>("debugger");
         }
@@ -806,6 +812,22 @@ namespace das {
         return context->stringHeap->allocateString(str);
     }
 
+    char * rtti_fusion_profile_report ( uint64_t minCount, Context * context ) {
+        TextWriter tw;
+        getFusionProfile().writeReport(tw, minCount);
+        return context->stringHeap->allocateString(tw.str());
+    }
+
+    char * rtti_fusion_profile_source ( uint64_t minCount, Context * context ) {
+        TextWriter tw;
+        getFusionProfile().writeFusionSource(tw, minCount);
+        return context->stringHeap->allocateString(tw.str());
+    }
+
+    void rtti_reset_fusion_profile () {
+        getFusionProfile().reset();
+    }
+
 #if !DAS_NO_FILEIO
 
     void rtti_builtin_compile_file ( char * modName, smart_ptr<FileAccess> access, const CodeOfPolicies & cop,
@@ -1024,6 +1046,13 @@ namespace das {
                 SideEffects::modifyExternal, "isCompatibleCast");
             addExtern<DAS_BIND_FUN(rtti_get_das_type_name)>(*this, lib,  "get_das_type_name",
                 SideEffects::none, "rtti_get_das_type_name");
+            // fusion profile
+            addExtern<DAS_BIND_FUN(rtti_fusion_profile_report)>(*this, lib,  "fusion_profile_report",
+                SideEffects::modifyExternal, "rtti_fusion_profile_report");
+            addExtern<DAS_BIND_FUN(rtti_fusion_profile_source)>(*this, lib,  "fusion_profile_source",
+                SideEffects::modifyExternal, "rtti_fusion_profile_source");
+            addExtern<DAS_BIND_FUN(rtti_reset_fusion_profile)>(*this, lib,  "reset_fusion_profile",
+                SideEffects::modifyExternal, "rtti_reset_fusion_profile");
             // current line info
             addExtern<DAS_BIND_FUN(getCurrentLineInfo), SimNode_ExtFuncCallAndCopyOrMove>(*this, lib,
                 "get_line_info", SideEffects::none, "getCurrentLineInfo");
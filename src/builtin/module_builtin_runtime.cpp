@@ -15,6 +15,8 @@
 #include "daScript/simulate/aot.h"
 #include "daScript/misc/sysos.h"
 
+MAKE_TYPE_FACTORY(TableStats, das::TableStats)
+
 namespace das
 {
 #if defined(__clang__)
@@ -320,6 +322,33 @@ namespace das
         table_clear(*context, arr);
     }
 
+    void builtin_table_reserve ( Table & arr, int32_t size, int32_t szk, int32_t szv, Context * context ) {
+        if ( size<0 ) context->throw_error("can't reserve negative table size");
+        table_reserve(*context, arr, uint32_t(size), szk, szv);
+    }
+
+    void builtin_table_stats ( const Table & arr, TableStats & stats ) {
+        table_stats(arr, stats);
+    }
+
+    struct TableStatsAnnotation : ManagedStructureAnnotation <TableStats,true> {
+        TableStatsAnnotation(ModuleLibrary & ml) : ManagedStructureAnnotation ("TableStats", ml) {
+            validationNeverFails = true;
+            addField<DAS_BIND_MANAGED_FIELD(capacity)>("capacity");
+            addField<DAS_BIND_MANAGED_FIELD(size)>("size");
+            addField<DAS_BIND_MANAGED_FIELD(tombstones)>("tombstones");
+            addField<DAS_BIND_MANAGED_FIELD(max_probe)>("max_probe");
+            addField<DAS_BIND_MANAGED_FIELD(total_probe)>("total_probe");
+            addField<DAS_BIND_MANAGED_FIELD(rehashes)>("rehashes");
+            addField<DAS_BIND_MANAGED_FIELD(incremental_rehashes)>("incremental_rehashes");
+            addField<DAS_BIND_MANAGED_FIELD(rehash_usec)>("rehash_usec");
+            addField<DAS_BIND_MANAGED_FIELD(rehashing)>("rehashing");
+        }
+        virtual bool canMove() const override { return true; }
+        virtual bool canCopy() const override { return true; }
+        virtual bool isLocal() const override { return true; }
+    };
+
     vec4f _builtin_hash ( Context & context, SimNode_CallBase * call, vec4f * args ) {
         auto uhash = hash_value(context, args[0], call->types[0]);
         return cast<uint32_t>::from(uhash);
@@ -345,6 +374,10 @@ namespace das
         context->collectStringHeap(info);
     }
 
+    void heap_collect ( bool sheap, Context * context, LineInfoArg * info ) {
+        context->collectHeap(info, sheap);
+    }
+
     void string_heap_report ( Context * context ) {
         context->stringHeap->report();
     }
@@ -584,8 +617,7 @@ namespace das
     void builtin_table_free ( Table & tab, int szk, int szv, Context * __context__ ) {
         if ( tab.data ) {
             if ( !tab.lock || tab.hopeless ) {
-                uint32_t oldSize = tab.capacity*(szk+szv+sizeof(uint32_t));
-                __context__->heap->free(tab.data, oldSize);
+                table_free(*__context__, tab, szk+szv);
             } else {
                 __context__->throw_error("can't delete locked table");
             }
@@ -841,6 +873,8 @@ namespace das
         addAnnotation(make_smart<MarkUsedFunctionAnnotation>());
         addAnnotation(make_smart<LocalOnlyFunctionAnnotation>());
         addAnnotation(make_smart<PersistentStructureAnnotation>());
+        // table stats
+        addAnnotation(make_smart<TableStatsAnnotation>(lib));
         // typeinfo macros
         addTypeInfoMacro(make_smart<ClassInfoMacro>());
         // command line arguments
@@ -914,6 +948,9 @@ namespace das
         auto shc = addExtern<DAS_BIND_FUN(string_heap_collect)>(*this, lib, "string_heap_collect",
                 SideEffects::modifyExternal, "string_heap_collect");
         shc->unsafeOperation = true;
+        auto hc = addExtern<DAS_BIND_FUN(heap_collect)>(*this, lib, "heap_collect",
+                SideEffects::modifyExternal, "heap_collect");
+        hc->unsafeOperation = true;
         addExtern<DAS_BIND_FUN(string_heap_report)>(*this, lib, "string_heap_report",
                 SideEffects::modifyExternal, "string_heap_report");
        addExtern<DAS_BIND_FUN(heap_report)>(*this, lib, "heap_report",
@@ -936,6 +973,8 @@ namespace das
         addExtern<DAS_BIND_FUN(builtin_table_clear)>(*this, lib, "clear", SideEffects::modifyArgument, "builtin_table_clear");
         addExtern<DAS_BIND_FUN(builtin_table_size)>(*this, lib, "length", SideEffects::none, "builtin_table_size");
         addExtern<DAS_BIND_FUN(builtin_table_capacity)>(*this, lib, "capacity", SideEffects::none, "builtin_table_capacity");
+        addExtern<DAS_BIND_FUN(builtin_table_reserve)>(*this, lib, "__builtin_table_reserve", SideEffects::modifyArgument, "builtin_table_reserve");
+        addExtern<DAS_BIND_FUN(builtin_table_stats)>(*this, lib, "table_stats", SideEffects::modifyArgument, "builtin_table_stats");
         addExtern<DAS_BIND_FUN(builtin_table_lock)>(*this, lib, "__builtin_table_lock",
                                                     SideEffects::modifyArgumentAndExternal, "builtin_table_lock");
         addExtern<DAS_BIND_FUN(builtin_table_unlock)>(*this, lib, "__builtin_table_unlock",
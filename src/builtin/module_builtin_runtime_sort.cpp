@@ -4,6 +4,7 @@
 
 #include "daScript/ast/ast_interop.h"
 #include "daScript/simulate/aot_builtin.h"
+#include "daScript/simulate/aot_builtin_jobque.h"
 #include "daScript/simulate/sim_policy.h"
 #include "das_qsort_r.h"
 
@@ -27,20 +28,214 @@ namespace das
         });
     }
 
+    enum {
+        radixSortMin = 256,         // std::sort is faster below that
+        parallelSortMin = 65536,    // and sorting on the job que only pays off above that
+        parallelChunkMin = 16384
+    };
+
+    // sorts chunks on the job que, then merges them pairwise. only with the job que running ('with_job_que'),
+    // and not from its own worker threads, which would be waiting on each other
+    template <typename TT, typename SortChunk, typename Less>
+    bool parallel_sort ( TT * data, uint32_t length, SortChunk && sortChunk, Less && less ) {
+        if ( length<parallelSortMin ) return false;
+        auto jq = getJobQue();
+        if ( !jq || jq->isWorkerThread() ) return false;
+        int chunks = 1;
+        while ( chunks*2<=jq->getTotalHwJobs() && length/(chunks*2)>=parallelChunkMin ) chunks *= 2;
+        if ( chunks==1 ) return false;
+        vector<TT> temp(length);
+        vector<uint32_t> bounds(chunks+1);
+        for ( int c=0; c<=chunks; ++c ) bounds[c] = uint32_t(uint64_t(length)*c/chunks);
+        jq->parallel_for(0, chunks, [&](int from, int to) {
+            for ( int c=from; c<to; ++c ) {
+                sortChunk(data + bounds[c], temp.data() + bounds[c], bounds[c+1] - bounds[c]);
+            }
+        }, 0, JobPriority::Default, chunks);
+        TT * src = data;
+        TT * dst = temp.data();
+        for ( int width=1; width<chunks; width*=2 ) {
+            jq->parallel_for(0, chunks/(width*2), [&](int from, int to) {
+                for ( int p=from; p<to; ++p ) {
+                    uint32_t lo = bounds[p*width*2], mid = bounds[p*width*2+width], hi = bounds[p*width*2+width*2];
+                    merge(src+lo, src+mid, src+mid, src+hi, dst+lo, less);
+                }
+            }, 0, JobPriority::Default, chunks/(width*2));
+            swap(src, dst);
+        }
+        if ( src!=data ) memcpy(data, src, length*sizeof(TT));
+        return true;
+    }
+
     void builtin_sort_string ( void * data, int32_t length ) {
         if ( length<=1 ) return;
         const char ** pdata = (const char **) data;
-        sort ( pdata, pdata + length, [&](const char * a, const char * b){
+        auto less = [](const char * a, const char * b){
             return strcmp(to_rts(a), to_rts(b))<0;
-        });
+        };
+        auto sortChunk = [&](const char ** chunk, const char **, uint32_t size) {
+            sort ( chunk, chunk + size, less );
+        };
+        if ( !parallel_sort(pdata, uint32_t(length), sortChunk, less) ) {
+            sortChunk(pdata, nullptr, uint32_t(length));
+        }
     }
 
+    // radix sort orders unsigned keys, which are mapped from the values so that they order the same way.
+    // floats with the sign bit set are flipped, the rest get the sign bit. nans go to the ends
+    template <typename TT> struct RadixKey;
+    template <> struct RadixKey<int32_t> {
+        typedef uint32_t UT;
+        static __forceinline UT to ( int32_t v ) { return uint32_t(v) ^ 0x80000000u; }
+        static __forceinline int32_t from ( UT k ) { return int32_t(k ^ 0x80000000u); }
+    };
+    template <> struct RadixKey<uint32_t> {
+        typedef uint32_t UT;
+        static __forceinline UT to ( uint32_t v ) { return v; }
+        static __forceinline uint32_t from ( UT k ) { return k; }
+    };
+    template <> struct RadixKey<int64_t> {
+        typedef uint64_t UT;
+        static __forceinline UT to ( int64_t v ) { return uint64_t(v) ^ 0x8000000000000000ull; }
+        static __forceinline int64_t from ( UT k ) { return int64_t(k ^ 0x8000000000000000ull); }
+    };
+    template <> struct RadixKey<uint64_t> {
+        typedef uint64_t UT;
+        static __forceinline UT to ( uint64_t v ) { return v; }
+        static __forceinline uint64_t from ( UT k ) { return k; }
+    };
+    template <> struct RadixKey<float> {
+        typedef uint32_t UT;
+        static __forceinline UT to ( float v ) {
+            uint32_t b; memcpy(&b, &v, sizeof(b));
+            return (b & 0x80000000u) ? ~b : (b | 0x80000000u);
+        }
+        static __forceinline float from ( UT k ) {
+            uint32_t b = (k & 0x80000000u) ? (k & 0x7fffffffu) : ~k;
+            float v; memcpy(&v, &b, sizeof(v));
+            return v;
+        }
+    };
+    template <> struct RadixKey<double> {
+        typedef uint64_t UT;
+        static __forceinline UT to ( double v ) {
+            uint64_t b; memcpy(&b, &v, sizeof(b));
+            return (b & 0x8000000000000000ull) ? ~b : (b | 0x8000000000000000ull);
+        }
+        static __forceinline double from ( UT k ) {
+            uint64_t b = (k & 0x8000000000000000ull) ? (k & 0x7fffffffffffffffull) : ~k;
+            double v; memcpy(&v, &b, sizeof(v));
+            return v;
+        }
+    };
+
+    // lsd radix sort, a byte at a time, stable. histograms of all the bytes are built in one pass,
+    // and bytes which are the same for every key are skipped. index, if any, is permuted along with the keys
+    template <typename UT>
+    void radix_sort ( UT * keys, UT * tempKeys, uint32_t * index, uint32_t * tempIndex, uint32_t length ) {
+        enum { digits = sizeof(UT) };
+        uint32_t counts[digits][256];
+        memset(counts, 0, sizeof(counts));
+        for ( uint32_t i=0; i!=length; ++i ) {
+            UT k = keys[i];
+            for ( int d=0; d!=digits; ++d ) {
+                counts[d][(k >> (d*8)) & 0xff] ++;
+            }
+        }
+        UT * src = keys, * dst = tempKeys;
+        uint32_t * srcIndex = index, * dstIndex = tempIndex;
+        for ( int d=0; d!=digits; ++d ) {
+            uint32_t * count = counts[d];
+            int shift = d*8;
+            if ( count[(src[0] >> shift) & 0xff]==length ) continue;
+            uint32_t offset[256];
+            uint32_t total = 0;
+            for ( int b=0; b!=256; ++b ) {
+                offset[b] = total;
+                total += count[b];
+            }
+            if ( srcIndex ) {
+                for ( uint32_t i=0; i!=length; ++i ) {
+                    uint32_t at = offset[(src[i] >> shift) & 0xff]++;
+                    dst[at] = src[i];
+                    dstIndex[at] = srcIndex[i];
+                }
+                swap(srcIndex, dstIndex);
+            } else {
+                for ( uint32_t i=0; i!=length; ++i ) {
+                    dst[offset[(src[i] >> shift) & 0xff]++] = src[i];
+                }
+            }
+            swap(src, dst);
+        }
+        if ( src!=keys ) {
+            memcpy(keys, src, length*sizeof(UT));
+            if ( index ) memcpy(index, srcIndex, length*sizeof(uint32_t));
+        }
+    }
+
+    // values are sorted as keys, and mapped back
+    template <typename TT>
+    void builtin_sort ( TT * data, int32_t length ) {
+        if ( length<=1 ) return;
+        if ( length<radixSortMin ) {
+            sort ( data, data + length );
+            return;
+        }
+        typedef typename RadixKey<TT>::UT UT;
+        vector<UT> keys(length);
+        for ( int32_t i=0; i!=length; ++i ) keys[i] = RadixKey<TT>::to(data[i]);
+        auto sortChunk = [](UT * chunk, UT * temp, uint32_t size) {
+            radix_sort<UT>(chunk, temp, nullptr, nullptr, size);
+        };
+        if ( !parallel_sort(keys.data(), uint32_t(length), sortChunk, [](UT a, UT b) { return a<b; }) ) {
+            vector<UT> temp(length);
+            sortChunk(keys.data(), temp.data(), uint32_t(length));
+        }
+        for ( int32_t i=0; i!=length; ++i ) data[i] = RadixKey<TT>::from(keys[i]);
+    }
+
+    // keys are extracted by the script, one per element. elements are then permuted in the order of the keys, stable
+    template <typename KT>
+    void builtin_sort_by_key ( void * data, int32_t elementSize, int32_t length, const KT * keys ) {
+        if ( length<=1 ) return;
+        typedef typename RadixKey<KT>::UT UT;
+        vector<UT> sortKeys(length*2);
+        vector<uint32_t> index(length*2);
+        for ( int32_t i=0; i!=length; ++i ) {
+            sortKeys[i] = RadixKey<KT>::to(keys[i]);
+            index[i] = uint32_t(i);
+        }
+        radix_sort<UT>(sortKeys.data(), sortKeys.data() + length, index.data(), index.data() + length, uint32_t(length));
+        char * bytes = (char *) data;
+        vector<char> temp(size_t(length)*elementSize);
+        for ( int32_t i=0; i!=length; ++i ) {
+            memcpy(temp.data() + size_t(i)*elementSize, bytes + size_t(index[i])*elementSize, elementSize);
+        }
+        memcpy(bytes, temp.data(), temp.size());
+    }
+
+    template void builtin_sort<int32_t> ( int32_t *, int32_t );
+    template void builtin_sort<uint32_t> ( uint32_t *, int32_t );
+    template void builtin_sort<int64_t> ( int64_t *, int32_t );
+    template void builtin_sort<uint64_t> ( uint64_t *, int32_t );
+    template void builtin_sort<float> ( float *, int32_t );
+    template void builtin_sort<double> ( double *, int32_t );
+    template void builtin_sort_by_key<int32_t> ( void *, int32_t, int32_t, const int32_t * );
+    template void builtin_sort_by_key<uint32_t> ( void *, int32_t, int32_t, const uint32_t * );
+    template void builtin_sort_by_key<int64_t> ( void *, int32_t, int32_t, const int64_t * );
+    template void builtin_sort_by_key<uint64_t> ( void *, int32_t, int32_t, const uint64_t * );
+    template void builtin_sort_by_key<float> ( void *, int32_t, int32_t, const float * );
+    template void builtin_sort_by_key<double> ( void *, int32_t, int32_t, const double * );
+
 #define xstr(a) str(a)
 #define str(a) #a
 
 #define ADD_NUMERIC_SORT(CTYPE) \
     addExtern<DAS_BIND_FUN(builtin_sort<CTYPE>)>(*this, lib, "__builtin_sort", \
         SideEffects::modifyArgumentAndExternal, "builtin_sort<" xstr(CTYPE) ">"); \
+    addExtern<DAS_BIND_FUN(builtin_sort_by_key<CTYPE>)>(*this, lib, "__builtin_sort_by_key", \
+        SideEffects::modifyArgumentAndExternal, "builtin_sort_by_key<" xstr(CTYPE) ">"); \
     addExtern<DAS_BIND_FUN(builtin_sort_cblock<CTYPE>)>(*this, lib, "__builtin_sort_cblock", \
         SideEffects::modifyArgumentAndExternal, "builtin_sort_cblock<" xstr(CTYPE) ">");
 
@@ -10,6 +10,7 @@
 #include "daScript/misc/debug_break.h"
 
 MAKE_TYPE_FACTORY(StringBuilderWriter, StringBuilderWriter)
+MAKE_TYPE_FACTORY(string_view, das::StringView)
 
 namespace das
 {
@@ -19,6 +20,22 @@ namespace das
         }
     };
 
+    struct StringViewAnnotation : ManagedValueAnnotation<StringView> {
+        StringViewAnnotation() : ManagedValueAnnotation<StringView>("string_view","das::StringView") {}
+        virtual bool canClone() const override { return true; }
+        virtual SimNode * simulateClone ( Context & context, const LineInfo & at, SimNode * l, SimNode * r ) const override {
+            return context.code->makeNode<SimNode_CloneRefValueT<StringView>>(at, l, r);
+        }
+        virtual void walk ( DataWalker & walker, void * data ) override {
+            if ( !walker.reading ) {
+                StringView * view = (StringView *) data;
+                string text(view->text ? view->text : "", view->length);
+                char * str = (char *) text.c_str();
+                walker.String(str);
+            }
+        }
+    };
+
     int32_t get_character_at ( const char * str, int32_t index, Context * context ) {
         const uint32_t strLen = stringLengthSafe ( *context, str );
         if ( uint32_t(index)>=strLen ) {
@@ -136,55 +153,43 @@ namespace das
         return ret;
     }
 
-    __forceinline char to_lower(char ch) {
-        return (ch >= 'A' && ch <= 'Z') ? (ch - 'A' + 'a') : ch;
-    }
-
     char* builtin_string_tolower ( const char *str, Context * context ) {
         const uint32_t strLen = stringLengthSafe ( *context, str );
         if (!strLen)
             return nullptr;
-        char * ret = context->stringHeap->allocateString(str, strLen);
-        for (char *d = ret, *end = ret + strLen; d != end; ++str, ++d)
-          *d = (char)to_lower(*str);
+        char * ret = context->stringHeap->allocateString(nullptr, strLen);
+        to_lower_bytes(ret, str, strLen);
         return ret;
     }
 
-    char* builtin_string_tolower_in_place(char* str) {
+    char* builtin_string_tolower_in_place(char* str, Context * context) {
         if (!str) return nullptr;
-        char* pch = str;
-        for (;;) {
-            char ch = *pch;
-            if (ch == 0) break;
-            else if (ch >= 'A' && ch <= 'Z') *pch = ch - 'A' + 'a';
-            pch++;
+        if ( !context ) {
+            to_lower_bytes(str, str, uint32_t(strlen(str)));
+            return str;
         }
+        to_lower_bytes(str, str, stringLength(*context, str));
+        if ( auto hdr = stringHeader(*context, str) ) hdr->hash = 0;
         return str;
     }
 
-    __forceinline char to_upper(char ch) {
-        return (ch >= 'a' && ch <= 'z') ? (ch - 'a' + 'A') : ch;
-    }
-
     char* builtin_string_toupper ( const char *str, Context * context ) {
         const uint32_t strLen = stringLengthSafe ( *context, str );
         if (!strLen)
             return nullptr;
-        char * ret = context->stringHeap->allocateString(str, strLen);
-        for (char *d = ret, *end = ret + strLen; d != end; ++str, ++d)
-          *d = (char)to_upper(*str);
+        char * ret = context->stringHeap->allocateString(nullptr, strLen);
+        to_upper_bytes(ret, str, strLen);
         return ret;
     }
 
-    char* builtin_string_toupper_in_place ( char* str ) {
+    char* builtin_string_toupper_in_place ( char* str, Context * context ) {
         if (!str) return nullptr;
-        char* pch = str;
-        for (;;) {
-            char ch = *pch;
-            if (ch == 0) break;
-            else if (ch >= 'a' && ch <= 'z') *pch = ch - 'a' + 'A';
-            pch++;
+        if ( !context ) {
+            to_upper_bytes(str, str, uint32_t(strlen(str)));
+            return str;
         }
+        to_upper_bytes(str, str, stringLength(*context, str));
+        if ( auto hdr = stringHeader(*context, str) ) hdr->hash = 0;
         return str;
     }
 
@@ -298,8 +303,10 @@ namespace das
 
     void write_escape_string ( StringBuilderWriter & writer, char * str ) {
         if ( !str ) return;
-        auto estr = escapeString(str,false);
-        writer.writeStr(estr.c_str(), estr.length());
+        const uint32_t strLen = uint32_t(strlen(str));
+        vector<char> estr(escape_string_length(str, strLen, false));
+        escape_string_to(estr.data(), str, strLen, false);
+        writer.writeStr(estr.data(), estr.size());
     }
 
     char * to_string_char ( int ch, Context * context ) {
@@ -318,34 +325,7 @@ namespace das
         return res;
     }
 
-    void builtin_string_split_by_char ( const char * str, const char * delim, const Block & block, Context * context ) {
-        if ( !str ) str = "";
-        if ( !delim ) delim = "";
-        vector<const char *> tokens;
-        vector<string> words;
-        const char * ch = str;
-        auto delimLen = stringLengthSafe(*context,delim);
-        if ( delimLen ) {
-            while ( *ch ) {
-                const char * tok = ch;
-                while ( *ch && !strchr(delim,*ch) ) ch++;
-                words.push_back(string(tok,ch-tok));
-                if ( !*ch ) break;
-                while ( *ch && strchr(delim,*ch) ) ch++;
-                if ( !*ch ) words.push_back("");
-            }
-        } else {
-            auto len = stringLengthSafe(*context,str);
-            words.reserve(len);
-            while ( *ch ) {
-                words.push_back(string(1,*ch));
-                ch ++;
-            }
-        }
-        tokens.reserve(words.size());
-        for ( auto & tok : words ) {
-            tokens.push_back(tok.c_str());
-        }
+    static void invoke_split_block ( vector<const char *> & tokens, const Block & block, Context * context ) {
         if ( tokens.empty() ) tokens.push_back("");
         Array arr;
         arr.data = (char *) tokens.data();
@@ -356,57 +336,95 @@ namespace das
         context->invoke(block, args, nullptr);
     }
 
-    void builtin_string_split ( const char * str, const char * delim, const Block & block, Context * context ) {
+    static void split_to_chars ( const char * str, uint32_t strLen, const Block & block, Context * context ) {
+        vector<char> buffer(strLen * 2);
+        vector<const char *> tokens;
+        tokens.reserve(strLen);
+        for ( uint32_t i=0; i!=strLen; ++i ) {
+            buffer[i*2] = str[i];
+            tokens.push_back(&buffer[i*2]);
+        }
+        invoke_split_block(tokens, block, context);
+    }
+
+    // tokens point into a copy of the string, with the first character of each delimiter run replaced by 0
+    void builtin_string_split_by_char ( const char * str, const char * delim, const Block & block, Context * context ) {
         if ( !str ) str = "";
         if ( !delim ) delim = "";
+        auto strLen = stringLengthSafe(*context,str);
+        auto delimLen = stringLengthSafe(*context,delim);
+        if ( !delimLen ) {
+            split_to_chars(str, strLen, block, context);
+            return;
+        }
+        vector<char> buffer(str, str + strLen + 1);
         vector<const char *> tokens;
-        vector<string> words;
-        const char * ch = str;
+        char * ch = buffer.data();
+        char * end = ch + strLen;
+        while ( ch != end ) {
+            char * tok = ch;
+            char * d = (char *) find_first_of(ch, uint32_t(end - ch), delim, delimLen);
+            tokens.push_back(tok);
+            if ( !d ) break;
+            *d = 0;
+            ch = d + 1;
+            while ( ch != end && memchr(delim, *ch, delimLen) ) ch++;
+            if ( ch == end ) tokens.push_back(end);
+        }
+        invoke_split_block(tokens, block, context);
+    }
+
+    void builtin_string_split ( const char * str, const char * delim, const Block & block, Context * context ) {
+        if ( !str ) str = "";
+        if ( !delim ) delim = "";
+        auto strLen = stringLengthSafe(*context,str);
         auto delimLen = stringLengthSafe(*context,delim);
-        if ( delimLen ) {
-            while ( *ch ) {
-                const char * tok = ch;
-                while ( *ch && strncmp(delim,ch,delimLen)!=0 ) ch++;
-                words.push_back(string(tok,ch-tok));
-                if ( !*ch ) break;
-                while ( *ch && strncmp(delim,ch,delimLen)==0 ) ch+=delimLen;
-                if ( !*ch ) words.push_back("");
-            }
-        } else {
-            auto len = stringLengthSafe(*context,str);
-            words.reserve(len);
-            while ( *ch ) {
-                words.push_back(string(1,*ch));
-                ch ++;
-            }
+        if ( !delimLen ) {
+            split_to_chars(str, strLen, block, context);
+            return;
         }
-        tokens.reserve(words.size());
-        for ( auto & tok : words ) {
-            tokens.push_back(tok.c_str());
+        vector<char> buffer(str, str + strLen + 1);
+        vector<const char *> tokens;
+        char * ch = buffer.data();
+        char * end = ch + strLen;
+        while ( ch != end ) {
+            char * tok = ch;
+            char * d = (char *) find_substring(ch, uint32_t(end - ch), delim, delimLen);
+            tokens.push_back(tok);
+            if ( !d ) break;
+            *d = 0;
+            ch = d + delimLen;
+            while ( uint32_t(end - ch) >= delimLen && memcmp(ch, delim, delimLen)==0 ) ch += delimLen;
+            if ( ch == end ) tokens.push_back(end);
         }
-        if ( tokens.empty() ) tokens.push_back("");
-        Array arr;
-        arr.data = (char *) tokens.data();
-        arr.capacity = arr.size = uint32_t(tokens.size());
-        arr.lock = 1;
-        vec4f args[1];
-        args[0] = cast<Array *>::from(&arr);
-        context->invoke(block, args, nullptr);
+        invoke_split_block(tokens, block, context);
     }
 
     char * builtin_string_replace ( const char * str, const char * toSearch, const char * replaceStr, Context * context ) {
         auto toSearchSize = stringLengthSafe(*context, toSearch);
         if ( !toSearchSize ) return (char *) str;
-        string data = str ? str : "";
+        auto strLen = stringLengthSafe(*context, str);
         auto replaceStrSize = stringLengthSafe(*context,replaceStr);
-        const char * repl = replaceStr ? replaceStr : "";
-        const char * toss = toSearch ? toSearch : "";
-        size_t pos = data.find(toss);
-        while ( pos != string::npos ) {
-            data.replace(pos, toSearchSize, repl);
-            pos = data.find(toss, pos + replaceStrSize);
+        const char * end = str + strLen;
+        vector<const char *> found;
+        for ( const char * s = str; (s = find_substring(s, uint32_t(end - s), toSearch, toSearchSize)); s += toSearchSize ) {
+            found.push_back(s);
+        }
+        if ( found.empty() ) return context->stringHeap->allocateString(str, strLen);
+        const uint32_t count = uint32_t(found.size());
+        char * res = context->stringHeap->allocateString(nullptr, strLen + count * replaceStrSize - count * toSearchSize);
+        if ( !res ) return nullptr;
+        char * d = res;
+        const char * s = str;
+        for ( auto at : found ) {
+            memcpy(d, s, at - s);
+            d += at - s;
+            if ( replaceStrSize ) memcpy(d, replaceStr, replaceStrSize);
+            d += replaceStrSize;
+            s = at + toSearchSize;
         }
-        return context->stringHeap->allocateString(data);
+        memcpy(d, s, end - s);
+        return res;
     }
 
     class StrdupDataWalker : public DataWalker {
@@ -423,7 +441,10 @@ namespace das
 
     char * builtin_string_escape ( const char *str, Context * context ) {
         if ( !str ) return nullptr;
-        return context->stringHeap->allocateString(escapeString(str,false));
+        const uint32_t strLen = stringLengthSafe(*context, str);
+        char * res = context->stringHeap->allocateString(nullptr, escape_string_length(str, strLen, false));
+        if ( res ) escape_string_to(res, str, strLen, false);
+        return res;
     }
 
     char * builtin_string_unescape ( const char *str, Context * context ) {
@@ -506,6 +527,182 @@ namespace das
             return s;
         }
     }
+    // string view
+
+    StringView builtin_view ( const char * str, Context * context ) {
+        return { str ? str : "", stringLengthSafe(*context, str) };
+    }
+
+    StringView builtin_view_bytes ( const TArray<uint8_t> & bytes ) {
+        return { bytes.size ? bytes.data : "", bytes.size };
+    }
+
+    char * builtin_view_string ( StringView view, Context * context ) {
+        return context->stringHeap->allocateString(view.text, view.length);
+    }
+
+    int32_t builtin_view_length ( StringView view ) {
+        return int32_t(view.length);
+    }
+
+    bool builtin_view_empty ( StringView view ) {
+        return view.length == 0;
+    }
+
+    int32_t builtin_view_character_at ( StringView view, int32_t index, Context * context ) {
+        if ( uint32_t(index)>=view.length ) {
+            context->throw_error_ex("string_view character index out of range, %u of %u", uint32_t(index), view.length);
+        }
+        return ((uint8_t *)view.text)[index];
+    }
+
+    StringView builtin_view_slice1 ( StringView view, int32_t start, int32_t end ) {
+        const int32_t len = int32_t(view.length);
+        start = clamp_int((start < 0) ? (len + start) : start, 0, len);
+        end = clamp_int((end < 0) ? (len + end) : end, 0, len);
+        return end > start ? StringView{ view.text + start, uint32_t(end - start) } : StringView{ view.text, 0 };
+    }
+
+    StringView builtin_view_slice2 ( StringView view, int32_t start ) {
+        return builtin_view_slice1(view, start, int32_t(view.length));
+    }
+
+    StringView builtin_view_strip_left ( StringView view ) {
+        while ( view.length && isspace((uint8_t)view.text[0]) ) {
+            view.text ++;
+            view.length --;
+        }
+        return view;
+    }
+
+    StringView builtin_view_strip_right ( StringView view ) {
+        while ( view.length && isspace((uint8_t)view.text[view.length-1]) ) {
+            view.length --;
+        }
+        return view;
+    }
+
+    StringView builtin_view_strip ( StringView view ) {
+        return builtin_view_strip_right(builtin_view_strip_left(view));
+    }
+
+    int32_t builtin_view_find1 ( StringView view, const char * substr, int32_t start, Context * context ) {
+        const uint32_t from = clamp_int(start, 0, int32_t(view.length));
+        const char * ret = find_substring(view.text + from, view.length - from, substr, stringLengthSafe(*context, substr));
+        return ret ? int32_t(ret - view.text) : -1;
+    }
+
+    int32_t builtin_view_find2 ( StringView view, const char * substr, Context * context ) {
+        return builtin_view_find1(view, substr, 0, context);
+    }
+
+    bool builtin_view_starts_with ( StringView view, const char * cmp, Context * context ) {
+        const uint32_t cmpLen = stringLengthSafe(*context, cmp);
+        return (cmpLen > view.length) ? false : memcmp(view.text, cmp, cmpLen) == 0;
+    }
+
+    bool builtin_view_ends_with ( StringView view, const char * cmp, Context * context ) {
+        const uint32_t cmpLen = stringLengthSafe(*context, cmp);
+        return (cmpLen > view.length) ? false : memcmp(view.text + view.length - cmpLen, cmp, cmpLen) == 0;
+    }
+
+    bool builtin_view_equ ( StringView a, StringView b ) {
+        return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+    }
+
+    bool builtin_view_nequ ( StringView a, StringView b ) {
+        return !builtin_view_equ(a, b);
+    }
+
+    bool builtin_view_equ_str ( StringView a, const char * b ) {
+        return builtin_view_equ(a, { b, b ? uint32_t(strlen(b)) : 0 });
+    }
+
+    bool builtin_view_nequ_str ( StringView a, const char * b ) {
+        return !builtin_view_equ(a, { b, b ? uint32_t(strlen(b)) : 0 });
+    }
+
+    bool builtin_str_equ_view ( const char * a, StringView b ) {
+        return builtin_view_equ({ a, a ? uint32_t(strlen(a)) : 0 }, b);
+    }
+
+    bool builtin_str_nequ_view ( const char * a, StringView b ) {
+        return !builtin_view_equ({ a, a ? uint32_t(strlen(a)) : 0 }, b);
+    }
+
+    // same tokens as builtin_string_split, but they point into the original text
+    void builtin_view_split ( StringView view, const char * delim, const Block & block, Context * context ) {
+        if ( !delim ) delim = "";
+        auto delimLen = stringLengthSafe(*context,delim);
+        vector<StringView> tokens;
+        const char * ch = view.text;
+        const char * end = view.text + view.length;
+        if ( !delimLen ) {
+            tokens.reserve(view.length);
+            for ( ; ch != end; ++ch ) tokens.push_back({ ch, 1 });
+        } else {
+            while ( ch != end ) {
+                const char * d = find_substring(ch, uint32_t(end - ch), delim, delimLen);
+                if ( !d ) {
+                    tokens.push_back({ ch, uint32_t(end - ch) });
+                    break;
+                }
+                tokens.push_back({ ch, uint32_t(d - ch) });
+                ch = d + delimLen;
+                while ( uint32_t(end - ch) >= delimLen && memcmp(ch, delim, delimLen)==0 ) ch += delimLen;
+                if ( ch == end ) tokens.push_back({ end, 0 });
+            }
+        }
+        if ( tokens.empty() ) tokens.push_back({ view.text, 0 });
+        Array arr;
+        arr.data = (char *) tokens.data();
+        arr.capacity = arr.size = uint32_t(tokens.size());
+        arr.lock = 1;
+        vec4f args[1];
+        args[0] = cast<Array *>::from(&arr);
+        context->invoke(block, args, nullptr);
+    }
+
+    template <typename TT, typename Convert>
+    __forceinline TT view_to_number ( StringView view, Convert && convert, const char * error, Context * context ) {
+        char buf[128];
+        string big;
+        const char * str = buf;
+        if ( view.length < sizeof(buf) ) {
+            memcpy(buf, view.text, view.length);
+            buf[view.length] = 0;
+        } else {
+            big.assign(view.text, view.length);
+            str = big.c_str();
+        }
+        char * endptr = nullptr;
+        TT ret = convert(str, &endptr);
+        if ( endptr == str ) {
+            context->throw_error(error);
+            return TT(0);
+        }
+        return ret;
+    }
+
+    int32_t builtin_view_to_int ( StringView view, Context * context ) {
+        return view_to_number<int32_t>(view, [](const char * str, char ** endptr) { return int32_t(strtol(str, endptr, 10)); },
+            "string_view-to-int conversion failed. String is not an integer number", context);
+    }
+
+    float builtin_view_to_float ( StringView view, Context * context ) {
+        return view_to_number<float>(view, [](const char * str, char ** endptr) { return strtof(str, endptr); },
+            "string_view-to-float conversion failed. String is not an float number", context);
+    }
+
+    double builtin_view_to_double ( StringView view, Context * context ) {
+        return view_to_number<double>(view, [](const char * str, char ** endptr) { return strtod(str, endptr); },
+            "string_view-to-double conversion failed. String is not an double number", context);
+    }
+
+    void builtin_view_write ( StringBuilderWriter & writer, StringView view ) {
+        writer.writeStr(view.text, view.length);
+    }
+
     class Module_Strings : public Module {
     public:
         Module_Strings() : Module("strings") {
@@ -595,9 +792,9 @@ namespace das
             addExtern<DAS_BIND_FUN(builtin_empty)>(*this, lib, "empty", SideEffects::none, "builtin_empty");
             addExtern<DAS_BIND_FUN(builtin_empty_das_string)>(*this, lib, "empty", SideEffects::none, "builtin_empty_das_string");
             addExtern<DAS_BIND_FUN(builtin_string_tolower_in_place)>(*this, lib, "to_lower_in_place",
-                SideEffects::none, "builtin_string_tolower_in_place")->arg("str")->unsafeOperation = true;
+                SideEffects::none, "builtin_string_tolower_in_place")->args({"str","context"})->unsafeOperation = true;
             addExtern<DAS_BIND_FUN(builtin_string_toupper_in_place)>(*this, lib, "to_upper_in_place",
-                SideEffects::none, "builtin_string_toupper_in_place")->arg("str")->unsafeOperation = true;
+                SideEffects::none, "builtin_string_toupper_in_place")->args({"str","context"})->unsafeOperation = true;
             addExtern<DAS_BIND_FUN(builtin_string_split_by_char)>(*this, lib, "builtin_string_split_by_char",
                 SideEffects::modifyExternal, "builtin_string_split_by_char")->args({"str","delimiter","block","context"});
             addExtern<DAS_BIND_FUN(builtin_string_split)>(*this, lib, "builtin_string_split",
@@ -630,6 +827,60 @@ namespace das
             // string buffer
             addExtern<DAS_BIND_FUN(builtin_reserve_string_buffer)>(*this, lib, "reserve_string_buffer",
                 SideEffects::none,"builtin_reserve_string_buffer");
+            // string view
+            addAnnotation(make_smart<StringViewAnnotation>());
+            addExtern<DAS_BIND_FUN(builtin_view)>(*this, lib, "view",
+                SideEffects::none, "builtin_view")->args({"str","context"})->unsafeOperation = true;
+            addExtern<DAS_BIND_FUN(builtin_view_bytes)>(*this, lib, "view",
+                SideEffects::none, "builtin_view_bytes")->arg("bytes")->unsafeOperation = true;
+            addExtern<DAS_BIND_FUN(builtin_view_string)>(*this, lib, "string",
+                SideEffects::none, "builtin_view_string")->args({"view","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_length)>(*this, lib, "length",
+                SideEffects::none, "builtin_view_length")->arg("view");
+            addExtern<DAS_BIND_FUN(builtin_view_empty)>(*this, lib, "empty",
+                SideEffects::none, "builtin_view_empty")->arg("view");
+            addExtern<DAS_BIND_FUN(builtin_view_character_at)>(*this, lib, "character_at",
+                SideEffects::none, "builtin_view_character_at")->args({"view","index","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_slice1)>(*this, lib, "slice",
+                SideEffects::none, "builtin_view_slice1")->args({"view","start","end"});
+            addExtern<DAS_BIND_FUN(builtin_view_slice2)>(*this, lib, "slice",
+                SideEffects::none, "builtin_view_slice2")->args({"view","start"});
+            addExtern<DAS_BIND_FUN(builtin_view_strip)>(*this, lib, "strip",
+                SideEffects::none, "builtin_view_strip")->arg("view");
+            addExtern<DAS_BIND_FUN(builtin_view_strip_left)>(*this, lib, "strip_left",
+                SideEffects::none, "builtin_view_strip_left")->arg("view");
+            addExtern<DAS_BIND_FUN(builtin_view_strip_right)>(*this, lib, "strip_right",
+                SideEffects::none, "builtin_view_strip_right")->arg("view");
+            addExtern<DAS_BIND_FUN(builtin_view_find1)>(*this, lib, "find",
+                SideEffects::none, "builtin_view_find1")->args({"view","substr","start","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_find2)>(*this, lib, "find",
+                SideEffects::none, "builtin_view_find2")->args({"view","substr","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_starts_with)>(*this, lib, "starts_with",
+                SideEffects::none, "builtin_view_starts_with")->args({"view","cmp","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_ends_with)>(*this, lib, "ends_with",
+                SideEffects::none, "builtin_view_ends_with")->args({"view","cmp","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_equ)>(*this, lib, "==",
+                SideEffects::none, "builtin_view_equ")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_view_nequ)>(*this, lib, "!=",
+                SideEffects::none, "builtin_view_nequ")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_view_equ_str)>(*this, lib, "==",
+                SideEffects::none, "builtin_view_equ_str")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_view_nequ_str)>(*this, lib, "!=",
+                SideEffects::none, "builtin_view_nequ_str")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_str_equ_view)>(*this, lib, "==",
+                SideEffects::none, "builtin_str_equ_view")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_str_nequ_view)>(*this, lib, "!=",
+                SideEffects::none, "builtin_str_nequ_view")->args({"a","b"});
+            addExtern<DAS_BIND_FUN(builtin_view_split)>(*this, lib, "builtin_view_split",
+                SideEffects::modifyExternal, "builtin_view_split")->args({"view","delimiter","block","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_to_int)>(*this, lib, "int",
+                SideEffects::none, "builtin_view_to_int")->args({"view","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_to_float)>(*this, lib, "float",
+                SideEffects::none, "builtin_view_to_float")->args({"view","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_to_double)>(*this, lib, "double",
+                SideEffects::none, "builtin_view_to_double")->args({"view","context"});
+            addExtern<DAS_BIND_FUN(builtin_view_write)>(*this, lib, "write",
+                SideEffects::modifyExternal, "builtin_view_write")->args({"writer","view"});
             // lets make sure its all aot ready
             verifyAotReady();
         }
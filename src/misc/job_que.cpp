@@ -4,24 +4,48 @@
 
 namespace das {
 
-    JobQue::JobQue()
-        : mSleepMs(0)
+    // worker thread identity, so that jobs spawned from jobs go straight into the local deque
+    static thread_local JobQue * g_currentJobQue = nullptr;
+    static thread_local int g_currentWorker = -1;
+
+    JobQue::JobQue( int threadCount )
+        : mSleeping(0)
         , mShutdown(false)
-        , mThreadCount( 0 )
-        , mJobsRunning(0) {
-        mThreadCount = max(1,(static_cast<int>(thread::hardware_concurrency())));
+        , mNextInbox(0)
+        , mJobsQueued(0)
+        , mJobsPending(0) {
+        for ( auto & cp : mCategoryPending ) {
+            cp = 0;
+        }
+        mTotalThreads = threadCount>0 ? threadCount : get_num_threads();
         SetCurrentThreadPriority(JobPriority::High);
-        for (int j = 0; j < mThreadCount; j++) {
-            mThreads.emplace_back(make_unique<thread>([=]() {
+        for (int j = 0; j < mTotalThreads; j++) {
+            mThreads.emplace_back(make_unique<ThreadEntry>());
+        }
+        for (int j = 0; j < mTotalThreads; j++) {
+            mThreads[j]->threadPointer = make_unique<thread>([=]() {
                 string thread_name = "JobQue_Job_" + to_string(j);
                 SetCurrentThreadName(thread_name);
                 job(j);
-            }));
+            });
         }
     }
 
     JobQue::~JobQue () {
         join();
+        for ( auto & th : mThreads ) {
+            for ( auto & lane : th->lanes ) {
+                while ( auto entry = lane.take() ) {
+                    delete entry;
+                }
+            }
+            for ( auto & lane : th->inbox.lanes ) {
+                for ( auto entry : lane ) {
+                    delete entry;
+                }
+            }
+        }
+        mThreads.clear();
     }
 
     void JobQue::EvalOnMainThread(Job && expr) {
@@ -51,18 +75,20 @@ namespace das {
 
     void JobQue::join() {
         mShutdown = true;
-        while ( mThreadCount ) {
-            this_thread::yield();
+        {
+            lock_guard<mutex> lock(mSleepMutex);
+            mCond.notify_all();
         }
         for (auto & th : mThreads) {
-            th.threadPointer->join();
+            if ( th->threadPointer ) {
+                th->threadPointer->join();
+                th->threadPointer.reset();
+            }
         }
-        mThreads.clear();
     }
 
     bool JobQue::isEmpty ( bool includingMainThreadJobs ) {
-        lock_guard<mutex> lock(mFifoMutex);
-        bool queue_is_empty = (mJobsRunning == 0) && (mFifo.size() == 0);
+        bool queue_is_empty = mJobsPending == 0;
         if ( includingMainThreadJobs ) {
             lock_guard<mutex> mainThreadLock(mEvalMainThreadMutex);
             return queue_is_empty && mEvalMainThread.empty();
@@ -71,91 +97,139 @@ namespace das {
     }
 
     bool JobQue::areJobsPending(JobCategory category) {
-        lock_guard<mutex> lock(mFifoMutex);
-        if (find_if(mFifo.begin(), mFifo.end(), [=](const JobEntry& jobEntry) {
-                return jobEntry.category == category; }) != mFifo.end()) {
-            return true;
-        }
-        if (find_if(mThreads.begin(), mThreads.end(), [=](const ThreadEntry& threadEntry) {
-                return threadEntry.currentPriority != JobPriority::Inactive && threadEntry.currentCategory == category; }) != mThreads.end()) {
-            return true;
-        }
-        return false;
+        return mCategoryPending[category % numCategoryCounters] != 0;
     }
 
     int JobQue::getTotalHwJobs() {
-        return mThreadCount;
+        return mTotalThreads;
+    }
+
+    bool JobQue::isWorkerThread() const {
+        return g_currentJobQue==this;
     }
 
     int JobQue::getNumberOfQueuedJobs() {
-        lock_guard<mutex> lock(mFifoMutex);
-        return int(mFifo.size());
+        return mJobsQueued;
     }
 
-    void JobQue::submit(Job && job, JobCategory category, JobPriority priority) {
-        auto  it = lower_bound(mFifo.begin(), mFifo.end(), priority, [](const JobEntry& lhs, JobPriority priority) {
-            return lhs.priority >= priority; });
-        mFifo.emplace(it, move(job), category, priority);
+    void JobQue::submit(JobEntry * entry) {
+        DAS_ASSERTF(entry->priority>=JobPriority::Minimum && entry->priority<=JobPriority::Maximum, "invalid job priority");
+        int lane = laneIndex(entry->priority);
+        mJobsPending++;
+        mCategoryPending[entry->category % numCategoryCounters]++;
+        // counted before its published, so that the worker which takes it never sees the count go negative
+        mJobsQueued++;
+        if ( g_currentJobQue==this ) {
+            mThreads[g_currentWorker]->lanes[lane].push(entry);
+        } else {
+            auto & inbox = mThreads[mNextInbox++ % uint32_t(mTotalThreads)]->inbox;
+            lock_guard<mutex> lock(inbox.lock);
+            inbox.lanes[lane].push_back(entry);
+            inbox.count++;
+        }
+    }
+
+    void JobQue::wakeUp(int count) {
+        // pairs with the sleeper incrementing mSleeping before checking mJobsQueued
+        if ( mSleeping ) {
+            lock_guard<mutex> lock(mSleepMutex);
+            if ( count==1 ) {
+                mCond.notify_one();
+            } else {
+                mCond.notify_all();
+            }
+        }
     }
 
     void JobQue::push(Job && job, JobCategory category, JobPriority priority) {
-        lock_guard<mutex> lock(mFifoMutex);
-        submit(move(job), category, priority);
-        mCond.notify_one();
+        submit(new JobEntry(move(job), category, priority));
+        wakeUp(1);
+    }
+
+    JobQue::JobEntry * JobQue::takeFromInbox(Inbox & inbox, int lane) {
+        if ( inbox.count==0 ) return nullptr;
+        lock_guard<mutex> lock(inbox.lock);
+        auto & fifo = inbox.lanes[lane];
+        if ( fifo.empty() ) return nullptr;
+        auto entry = fifo.front();
+        fifo.pop_front();
+        inbox.count--;
+        return entry;
+    }
+
+    JobQue::JobEntry * JobQue::findJob(int threadIndex) {
+        auto & self = *mThreads[threadIndex];
+        for ( int lane = 0; lane != numLanes; ++lane ) {
+            if ( auto entry = self.lanes[lane].take() ) return entry;
+            if ( auto entry = takeFromInbox(self.inbox, lane) ) return entry;
+            for ( int i = 1; i < mTotalThreads; ++i ) {
+                auto & victim = *mThreads[(threadIndex + i) % mTotalThreads];
+                if ( auto entry = victim.lanes[lane].steal() ) return entry;
+                if ( auto entry = takeFromInbox(victim.inbox, lane) ) return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void JobQue::execute(int threadIndex, JobEntry * entry) {
+        mJobsQueued--;
+        auto & self = *mThreads[threadIndex];
+        if ( self.currentPriority!=entry->priority ) {
+            self.currentPriority = entry->priority;
+            SetCurrentThreadPriority(entry->priority);
+        }
+        entry->function();
+        auto category = entry->category;
+        delete entry;
+        mCategoryPending[category % numCategoryCounters]--;
+        mJobsPending--;
     }
 
     void JobQue::job(int threadIndex) {
+        g_currentJobQue = this;
+        g_currentWorker = threadIndex;
+        int idle = 0;
         while (!mShutdown) {
-            Job job;
-            {
-                unique_lock<mutex> lock(mFifoMutex);
-                if ( mCond.wait_for(lock, chrono::milliseconds(mSleepMs), [&]() { return mFifo.size() != 0; }) ) {
-                    DAS_ASSERTF(mFifo.size() > 0, "There must be at least one job available");
-                    job = move(mFifo.front().function);
-                    mThreads[threadIndex].currentPriority = mFifo.front().priority;
-                    mThreads[threadIndex].currentCategory = mFifo.front().category;
-                    mFifo.pop_front();
-                    mJobsRunning++;
-                } else {
-                    continue;
-                }
-            }
-            SetCurrentThreadPriority(mThreads[threadIndex].currentPriority);
-            job();
-            {
-                unique_lock<mutex> lock(mFifoMutex);
-                mThreads[threadIndex].currentPriority = JobPriority::Inactive;
-                mJobsRunning--;
+            auto entry = mJobsQueued ? findJob(threadIndex) : nullptr;
+            if ( entry ) {
+                execute(threadIndex, entry);
+                idle = 0;
+            } else if ( ++idle < spinBeforeSleep ) {
+                this_thread::yield();
+            } else {
+                idle = 0;
+                unique_lock<mutex> lock(mSleepMutex);
+                mSleeping++;
+                mCond.wait(lock, [&]() { return mJobsQueued != 0 || mShutdown; });
+                mSleeping--;
             }
         }
-        mThreadCount--;
+        g_currentJobQue = nullptr;
+        g_currentWorker = -1;
     }
 
     void JobQue::parallel_for ( JobStatus & status, int from, int to, const JobChunk & chunk,
             JobCategory category, JobPriority priority, int chunk_count, int step ) {
         if ( from >= to ) return;
-        if ( chunk_count==-1 ) chunk_count = mThreadCount * 4;
+        if ( chunk_count==-1 ) chunk_count = mTotalThreads * 4;
         step = max ( ( to - from + 1 ) / chunk_count, step );
         int numChunks = (to - from + step) / step;
         if ( numChunks==1 ) {
             chunk(from, to);
             return;
         }
-        int onMainThread = max ( (numChunks + mThreadCount)  / (mThreadCount+1), 1 );
+        int onMainThread = max ( (numChunks + mTotalThreads)  / (mTotalThreads+1), 1 );
         int onThreads  = numChunks - onMainThread;
         status.Clear(onThreads);
-        {
-            lock_guard<mutex> lock(mFifoMutex);
-            for (int ch = 0; ch < onThreads; ++ch) {
-                int i0 = from + ch * step;
-                int i1 = i0 + step;
-                submit([=,&status](){
-                    chunk(i0, i1);
-                    status.Notify();
-                }, category, priority);
-            }
-            mCond.notify_all();
+        for (int ch = 0; ch < onThreads; ++ch) {
+            int i0 = from + ch * step;
+            int i1 = i0 + step;
+            submit(new JobEntry([=,&status](){
+                chunk(i0, i1);
+                status.Notify();
+            }, category, priority));
         }
+        wakeUp(onThreads);
         chunk(from + onThreads * step, to);
     }
 
@@ -168,7 +242,7 @@ namespace das {
     void JobQue::parallel_for_with_consume(int from, int to, const JobChunk & chunk, const JobChunk & consume,
         JobCategory category, JobPriority priority, int chunk_count, int step) {
         if (from >= to) return;
-        if (chunk_count == -1) chunk_count = mThreadCount * 4;
+        if (chunk_count == -1) chunk_count = mTotalThreads * 4;
         step = max((to - from) / chunk_count, step);
         int numChunks = (to - from) / step;
         if (numChunks == 1) {
@@ -179,33 +253,27 @@ namespace das {
         deque<Job> producerFifoJobs;
         mutex producerFifoMutex;
         condition_variable condition;
-        {
-            lock_guard<mutex> lock(mFifoMutex);
-            for (int ch = 0; ch < numChunks; ++ch) {
-                int i0 = from + ch * step;
-                int i1 = min(i0 + step, to);
-                submit([=, &chunk, &producerFifoJobs, &producerFifoMutex, &condition]() {
-                    chunk(i0, i1);
-                    {
-                        lock_guard<mutex> producerFifoLock(producerFifoMutex);
-                        producerFifoJobs.push_back(([=]() { consume(i0, i1); }));
-                        condition.notify_one();
-                    }
-                }, category, priority);
-            }
-            mCond.notify_all();
+        for (int ch = 0; ch < numChunks; ++ch) {
+            int i0 = from + ch * step;
+            int i1 = ch==numChunks-1 ? to : min(i0 + step, to);
+            submit(new JobEntry([=, &chunk, &producerFifoJobs, &producerFifoMutex, &condition]() {
+                chunk(i0, i1);
+                {
+                    lock_guard<mutex> producerFifoLock(producerFifoMutex);
+                    producerFifoJobs.push_back(([=]() { consume(i0, i1); }));
+                    condition.notify_one();
+                }
+            }, category, priority));
         }
+        wakeUp(numChunks);
         {
             int chunksRemaining = numChunks;
             while (chunksRemaining > 0) {
                 deque<Job> consumerFifoJobs;
                 {
                     unique_lock<mutex> producerFifoLock(producerFifoMutex);
-                    if (condition.wait_for(producerFifoLock, chrono::milliseconds(mSleepMs), [&]() {return producerFifoJobs.size() > 0; })) {
-                        consumerFifoJobs.swap(producerFifoJobs);
-                    } else {
-                        continue;
-                    }
+                    condition.wait(producerFifoLock, [&]() {return producerFifoJobs.size() > 0; });
+                    consumerFifoJobs.swap(producerFifoJobs);
                 }
                 for (auto & job : consumerFifoJobs) {
                     job();
@@ -65,6 +65,7 @@ namespace das {
 #endif
             char * ptr = (char *) das_aligned_alloc16(size);
             bigStuff[ptr] = size;
+            bigIndexDirty = true;
 #if DAS_TRACK_ALLOCATIONS
             if ( g_tracker==g_breakpoint ) os_debug_break();
             bigStuffId[ptr] = g_tracker ++;
@@ -79,8 +80,7 @@ namespace das {
             DAS_ASSERT(size && size<=DAS_MAX_SHOE_ALLOCATION);
             uint32_t si = (size >> 4) - 1;
             uint32_t total = grow(si);
-            shoe.chunks[si] = new Deck(total, size, shoe.chunks[si]);
-            return shoe.chunks[si]->allocate();
+            return shoe.addDeck(total, size)->allocate();
         }
 #endif
     }
@@ -114,6 +114,7 @@ namespace das {
             das_aligned_free16(itb->first);
 #endif
             bigStuff.erase(itb);
+            bigIndexDirty = true;
             totalAllocated -= size;
 #if DAS_TRACK_ALLOCATIONS
             bigStuffId.erase(ptr);
@@ -156,6 +157,7 @@ namespace das {
 #endif
         }
         bigStuff.clear();
+        bigIndexDirty = true;
 #if DAS_TRACK_ALLOCATIONS
         bigStuffId.clear();
         bigStuffAt.clear();
@@ -177,15 +179,8 @@ namespace das {
 #if !DAS_TRACK_ALLOCATIONS
         for ( uint32_t si=0; si!=DAS_MAX_SHOE_CUNKS; ++si ) {   // we re-track all small allocations
             for ( auto ch=shoe.chunks[si]; ch; ch=ch->next ) {
-                uint32_t utotal = ch->total / 32;
-                for ( uint32_t i=0; i!=utotal; ++i ) {
-                    uint32_t b = ch->bits[i];
-                    for ( uint32_t j=0; j!=32; ++j ) {          // TODO: this is COUNTBITS * size
-                        if ( b & (1<<j) ) {
-                            totalAllocated += ch->size;
-                        }
-                    }
-                }
+                ch->sweep();
+                totalAllocated += ch->allocated * ch->size;
             }
         }
 #endif
@@ -199,6 +194,51 @@ namespace das {
                 it = bigStuff.erase(it);
             }
         }
+        bigIndexDirty = true;
+    }
+
+    // finds allocation, which contains the pointer. pointer does not have to point to the beginning of it
+    char * MemoryModel::locate ( char * ptr, uint32_t & size ) const {
+        if ( auto ch = shoe.findDeck(ptr) ) {
+            uint32_t idx = uint32_t((ptr - ch->data) / ch->size);
+            if ( !(ch->bits[idx>>5] & (1u<<(idx&31))) ) return nullptr;    // free slot
+            size = ch->size;
+            return ch->data + idx * ch->size;
+        }
+        auto itb = bigStuff.find(ptr);
+        if ( itb!=bigStuff.end() ) {
+            size = itb->second & ~DAS_PAGE_GC_MASK;
+            return ptr;
+        }
+        if ( bigIndexDirty ) {
+            bigIndex.clear();
+            bigIndex.reserve(bigStuff.size());
+            for ( auto & it : bigStuff ) {
+                bigIndex.emplace_back((char *)it.first, it.second & ~DAS_PAGE_GC_MASK);
+            }
+            sort(bigIndex.begin(), bigIndex.end());
+            bigIndexDirty = false;
+        }
+        auto it = upper_bound(bigIndex.begin(), bigIndex.end(), ptr, [](char * p, const pair<char *,uint32_t> & b) {
+            return p < b.first;
+        });
+        if ( it!=bigIndex.begin() ) {
+            --it;
+            if ( ptr < it->first + it->second ) {
+                size = it->second;
+                return it->first;
+            }
+        }
+        return nullptr;
+    }
+
+    void MemoryModel::markAllocation ( char * ptr, uint32_t size ) {
+        auto itb = bigStuff.find(ptr);
+        if ( itb!=bigStuff.end() ) {
+            itb->second |= DAS_PAGE_GC_MASK;
+        } else if ( size <= DAS_MAX_SHOE_ALLOCATION ) {
+            shoe.mark(ptr, size);
+        }
     }
 
     char * LinearChunkAllocator::reallocate ( char * ptr, uint32_t size, uint32_t nsize ) {
@@ -254,6 +294,18 @@ namespace das {
         }
     }
 
+    void LinearChunkAllocator::adopt ( LinearChunkAllocator & other ) {
+        if ( !other.chunk ) return;
+        if ( chunk ) {
+            auto tail = chunk;
+            while ( tail->next ) tail = tail->next;
+            tail->next = other.chunk;
+        } else {
+            chunk = other.chunk;
+        }
+        other.chunk = nullptr;
+    }
+
     char * LinearChunkAllocator::allocateName ( const string & name ) {
         if (!name.empty()) {
             auto length = uint32_t(name.length());
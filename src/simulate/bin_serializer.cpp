@@ -4,50 +4,139 @@
 #include "daScript/simulate/simulate.h"
 #include "daScript/simulate/hash.h"
 
+#if defined(_MSC_VER)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace das {
 
 #ifndef DEBUG_BIN_DATA
 #define DEBUG_BIN_DATA(...)
 #endif
 
+    #define DAS_BIN_STREAM_MAGIC    0x42534144u     // DASB
+    #define DAS_BIN_STREAM_VERSION  1u
+
+    struct BinStreamHeader {
+        uint32_t    magic;
+        uint32_t    version;
+        uint64_t    schema;
+    };
+
     struct BinDataSerialize : DataWalker {
         char * bytesAt = nullptr;
-        uint32_t bytesAllocated = 0;
-        uint32_t bytesWritten = 0;
-        uint32_t bytesGrow = 1024;
+        uint64_t bytesAllocated = 0;
+        uint64_t bytesWritten = 0;
+    // streaming
+        enum { streamChunk = 64*1024, bulkAlign = 16 };
+        BinaryStream * stream = nullptr;
+        vector<char> buffer;
+        uint64_t streamBase = 0;        // stream offset of bytesAt[0]
+        bool bulk = false;              // raw pod arrays are written in one piece
+        bool skipArrayData = false;
+    // mapped
+        bool mapped = false;
+        bool lastArrayMapped = false;
+        vector<Array *> mappedArrays;
+        vector<Array *> lockedArrays;
     // writer
         BinDataSerialize ( Context & ctx ) {
             DEBUG_BIN_DATA("writing\n");
             context = &ctx;
             reading = false;
         }
-        BinDataSerialize ( Context & ctx, char * b, uint32_t l ) {
+        BinDataSerialize ( Context & ctx, char * b, uint64_t l ) {
             context = &ctx;
             reading = true;
             bytesAt = b;
             bytesAllocated = l;
-            DEBUG_BIN_DATA("reading %i bytes\n", bytesAllocated);
+            DEBUG_BIN_DATA("reading %i bytes\n", int(bytesAllocated));
         }
-        __forceinline void read ( void * data, uint32_t size ) {
+        BinDataSerialize ( Context & ctx, BinaryStream & s, bool r ) {
+            context = &ctx;
+            reading = r;
+            stream = &s;
+            bulk = true;
+            buffer.resize(streamChunk);
+            bytesAt = buffer.data();
+            bytesAllocated = reading ? 0 : streamChunk;
+        }
+        __forceinline uint64_t position() const {
+            return streamBase + bytesWritten;
+        }
+        __forceinline void read ( void * data, uint64_t size ) {
             if ( bytesWritten + size <= bytesAllocated ) {
-                DEBUG_BIN_DATA("reading %i bytes at %i\n", size, bytesWritten );
+                DEBUG_BIN_DATA("reading %i bytes at %i\n", int(size), int(bytesWritten) );
                 memcpy ( data, bytesAt + bytesWritten, size );
                 bytesWritten += size;
+            } else if ( stream ) {
+                refill((char *)data, size);
             } else {
                 error("binary data too short");
             }
         }
-        __forceinline void write ( void * data, uint32_t size ) {
+        void refill ( char * data, uint64_t size ) {
+            uint64_t avail = bytesAllocated - bytesWritten;
+            memcpy ( data, bytesAt + bytesWritten, avail );
+            data += avail;
+            size -= avail;
+            streamBase += bytesAllocated;
+            bytesAllocated = bytesWritten = 0;
+            if ( size >= streamChunk ) {    // big reads go straight to the destination
+                if ( stream->read(data, size)!=size ) error("binary data too short");
+                streamBase += size;
+                return;
+            }
+            bytesAllocated = stream->read(bytesAt, streamChunk);
+            if ( bytesAllocated < size ) error("binary data too short");
+            memcpy ( data, bytesAt, size );
+            bytesWritten = size;
+        }
+        __forceinline void write ( const void * data, uint64_t size ) {
             if ( bytesWritten + size > bytesAllocated ) {
-                uint32_t newSize = das::max ( bytesAllocated + bytesGrow, bytesWritten + size );
-                bytesAt = context->heap->reallocate(bytesAt, bytesAllocated, newSize);
-                context->heap->mark_comment(bytesAt, "binary serializer write");
-                bytesAllocated = newSize;
+                if ( stream ) {
+                    flush();
+                    if ( size > bytesAllocated ) {  // bigger than the buffer, goes straight to the sink
+                        if ( stream->write(data, size)!=size ) error("binary stream write failed");
+                        streamBase += size;
+                        return;
+                    }
+                } else {
+                    grow(bytesWritten + size);
+                }
             }
-            DEBUG_BIN_DATA("writing %i bytes at %i\n", size, bytesWritten );
+            DEBUG_BIN_DATA("writing %i bytes at %i\n", int(size), int(bytesWritten) );
             memcpy ( bytesAt + bytesWritten, data, size );
             bytesWritten += size;
         }
+        void grow ( uint64_t size ) {
+            if ( size > UINT32_MAX ) error("binary data too large, use the streaming serializer");
+            uint64_t newSize = das::min ( das::max ( das::max(bytesAllocated*2, uint64_t(1024)), size ), uint64_t(UINT32_MAX) );
+            bytesAt = context->heap->reallocate(bytesAt, uint32_t(bytesAllocated), uint32_t(newSize));
+            if ( !bytesAt ) context->throw_error("out of linear allocator memory");
+            context->heap->mark_comment(bytesAt, "binary serializer write");
+            bytesAllocated = newSize;
+        }
+        void flush () {
+            if ( bytesWritten ) {
+                if ( stream->write(bytesAt, bytesWritten)!=bytesWritten ) error("binary stream write failed");
+                streamBase += bytesWritten;
+                bytesWritten = 0;
+            }
+        }
+        void align () {
+            uint64_t pad = (bulkAlign - position() % bulkAlign) % bulkAlign;
+            if ( !pad ) return;
+            char zero[bulkAlign];
+            if ( reading ) {
+                read(zero, pad);
+            } else {
+                memset(zero, 0, pad);
+                write(zero, pad);
+            }
+        }
         template <typename TT>
         __forceinline void save ( TT & data ) {
             write ( &data, sizeof(TT) );
@@ -77,12 +166,61 @@ namespace das {
                 save(data);
             }
         }
+        bool header ( TypeInfo * info ) {
+            BinStreamHeader head = { DAS_BIN_STREAM_MAGIC, DAS_BIN_STREAM_VERSION, binary_schema_hash(info) };
+            if ( reading ) {
+                BinStreamHeader test;
+                if ( stream && !bytesAllocated ) bytesAllocated = stream->read(bytesAt, streamChunk);
+                if ( bytesAllocated - bytesWritten < sizeof(test) ) return false;
+                load(test);
+                if ( test.magic==head.magic && test.version==head.version && test.schema==head.schema ) return true;
+                bytesWritten -= sizeof(test);   // not ours, nothing is consumed
+                return false;
+            } else {
+                save(head);
+                return true;
+            }
+        }
         void close () {
-            if ( !reading && bytesAt ) {
-                DEBUG_BIN_DATA("close at %i bytes\n\n", bytesWritten);
-                bytesAt = context->heap->reallocate(bytesAt, bytesAllocated, bytesWritten);
+            if ( stream ) {
+                if ( !reading ) {
+                    flush();
+                } else {
+                    stream->unread(bytesAllocated - bytesWritten);  // pipes can't, and the read ahead is lost
+                }
+            } else if ( !reading && bytesAt ) {
+                DEBUG_BIN_DATA("close at %i bytes\n\n", int(bytesWritten));
+                bytesAt = context->heap->reallocate(bytesAt, uint32_t(bytesAllocated), uint32_t(bytesWritten));
             }
         }
+        // pod arrays, which point into the mapped data, are let go of. everything else gets unlocked
+        void detach () {
+            for ( auto arr : lockedArrays ) {
+                array_unlock(*context, *arr);
+            }
+            for ( auto arr : mappedArrays ) {
+                memset(arr, 0, sizeof(Array));
+            }
+            lockedArrays.clear();
+            mappedArrays.clear();
+        }
+        bool bulkArray ( TypeInfo * ti ) const {
+            return bulk && ti->firstType->isRawPod() && ti->firstType->type!=Type::tHandle;
+        }
+        void mapArray ( Array * pa, uint32_t newSize, uint32_t stride ) {
+            if ( pa->isLocked() ) context->throw_error("can't map into a locked array");
+            if ( pa->data ) context->heap->free(pa->data, pa->capacity*stride);
+            memset(pa, 0, sizeof(Array));
+            if ( !newSize ) return;
+            uint64_t bytes = uint64_t(newSize) * stride;
+            if ( bytesWritten + bytes > bytesAllocated ) error("binary data too short");
+            pa->data = bytesAt + bytesWritten;
+            pa->size = pa->capacity = newSize;
+            pa->lock = 1;
+            bytesWritten += bytes;
+            mappedArrays.push_back(pa);
+            lastArrayMapped = true;
+        }
     // data structures
         virtual void beforeStructure ( char *, StructInfo * si ) override {
             verify(si->hash);
@@ -93,15 +231,50 @@ namespace das {
         }
         virtual void beforeArray ( Array * pa, TypeInfo * ti ) override {
             verify(ti->hash);
+            uint32_t stride = getTypeSize(ti->firstType);
             if ( reading ) {
                 uint32_t newSize = 0;
                 load(newSize);
-                array_clear(*context, *pa);
-                array_resize(*context, *pa, newSize, getTypeBaseSize(ti), true);
+                if ( bulkArray(ti) ) {
+                    align();
+                    if ( mapped ) {
+                        mapArray(pa, newSize, stride);
+                    } else {
+                        array_clear(*context, *pa);
+                        array_resize(*context, *pa, newSize, stride, false);
+                        read(pa->data, uint64_t(newSize) * stride);
+                    }
+                    skipArrayData = true;
+                } else {
+                    array_clear(*context, *pa);
+                    array_resize(*context, *pa, newSize, stride, true);
+                }
             } else {
                 save(pa->size);
+                if ( bulkArray(ti) ) {
+                    align();
+                    write(pa->data, uint64_t(pa->size) * stride);
+                    skipArrayData = true;
+                }
             }
         }
+        virtual void afterArray ( Array * pa, TypeInfo * ) override {
+            if ( mapped ) {
+                // so that nothing moves the arrays we are about to detach
+                if ( !lastArrayMapped ) {
+                    array_lock(*context, *pa);
+                    lockedArrays.push_back(pa);
+                }
+                lastArrayMapped = false;
+            }
+        }
+        virtual void walk_array ( char * pa, uint32_t stride, uint32_t count, TypeInfo * ti ) override {
+            if ( skipArrayData ) {
+                skipArrayData = false;
+                return;
+            }
+            DataWalker::walk_array(pa, stride, count, ti);
+        }
         virtual void beforeTable ( Table *, TypeInfo * ) override {
             error("binary serialization of tables is not supported");
         }
@@ -254,8 +427,8 @@ namespace das {
         writer.close();
         Array arr;
         arr.data = writer.bytesAt;
-        arr.size = writer.bytesWritten;
-        arr.capacity = writer.bytesWritten;
+        arr.size = uint32_t(writer.bytesWritten);
+        arr.capacity = uint32_t(writer.bytesWritten);
         arr.lock = 1;
         arr.flags = 0;
         vec4f arg = cast<char *>::from((char *)&arr);
@@ -277,4 +450,176 @@ namespace das {
         return v_zero();
     }
 
+    // schema hash. 64 bit fnv over the layout of the type - struct and field names, offsets, sizes, enumeration values
+
+    struct BinSchemaHash {
+        uint64_t hash = 14695981039346656037ul;
+        das_hash_map<void *,uint32_t> visited;
+        void write ( const void * data, size_t size ) {
+            const uint8_t * block = (const uint8_t *) data;
+            while ( size-- ) {
+                hash = ( hash ^ *block++ ) * 1099511628211ul;
+            }
+        }
+        void write ( const char * str ) {
+            write(str, str ? strlen(str)+1 : 0);
+        }
+        template <typename TT>
+        void write ( TT value ) {
+            write(&value, sizeof(TT));
+        }
+        void type ( TypeInfo * info ) {
+            write(uint32_t(info->type));
+            write(info->dimSize);
+            write(info->dim, info->dimSize*sizeof(uint32_t));
+            if ( info->type!=Type::tVoid && info->type!=Type::anyArgument ) {
+                write(uint32_t(getTypeSize(info)));
+            }
+            if ( info->type==Type::tHandle ) write(info->hash);
+            if ( info->structType ) structure(info->structType);
+            if ( info->enumType ) enumeration(info->enumType);
+            if ( info->firstType ) type(info->firstType);
+            if ( info->secondType ) type(info->secondType);
+            for ( uint32_t i=0; i!=info->argCount; ++i ) {
+                if ( info->argNames ) write(info->argNames[i]);
+                type(info->argTypes[i]);
+            }
+        }
+        bool seen ( void * what ) {
+            auto it = visited.find(what);
+            if ( it!=visited.end() ) {
+                write(it->second);
+                return true;
+            }
+            visited[what] = uint32_t(visited.size());
+            return false;
+        }
+        void structure ( StructInfo * si ) {
+            write(si->name);
+            if ( seen(si) ) return;
+            write(si->size);
+            write(si->count);
+            for ( uint32_t i=0; i!=si->count; ++i ) {
+                VarInfo * vi = si->fields[i];
+                write(vi->name);
+                write(vi->offset);
+                type(vi);
+            }
+        }
+        void enumeration ( EnumInfo * ei ) {
+            write(ei->name);
+            if ( seen(ei) ) return;
+            write(ei->count);
+            for ( uint32_t i=0; i!=ei->count; ++i ) {
+                write(ei->fields[i]->name);
+                write(ei->fields[i]->value);
+            }
+        }
+    };
+
+    uint64_t binary_schema_hash ( TypeInfo * info ) {
+        BinSchemaHash sh;
+        TypeInfo ti = *info;
+        ti.flags &= ~TypeInfo::flag_ref;
+        sh.type(&ti);
+        return sh.hash;
+    }
+
+    // streams
+
+    uint64_t FileBinaryStream::write ( const void * data, uint64_t size ) {
+        return fwrite(data, 1, size, file);
+    }
+
+    uint64_t FileBinaryStream::read ( void * data, uint64_t size ) {
+        return fread(data, 1, size, file);
+    }
+
+    bool FileBinaryStream::unread ( uint64_t size ) {
+        if ( !size ) return true;
+#if defined(_MSC_VER)
+        return _fseeki64(file, -int64_t(size), SEEK_CUR)==0;
+#else
+        return fseeko(file, -off_t(size), SEEK_CUR)==0;
+#endif
+    }
+
+#if defined(_MSC_VER)
+    #define das_fd_write(fd,data,size)  _write(fd,data,unsigned(size))
+    #define das_fd_read(fd,data,size)   _read(fd,data,unsigned(size))
+#else
+    #define das_fd_write(fd,data,size)  ::write(fd,data,size)
+    #define das_fd_read(fd,data,size)   ::read(fd,data,size)
+#endif
+
+    uint64_t FdBinaryStream::write ( const void * data, uint64_t size ) {
+        const char * bytes = (const char *) data;
+        uint64_t total = 0;
+        while ( total < size ) {
+            auto res = das_fd_write(fd, bytes + total, das::min(size - total, uint64_t(1u<<30)));
+            if ( res <= 0 ) break;
+            total += res;
+        }
+        return total;
+    }
+
+    uint64_t FdBinaryStream::read ( void * data, uint64_t size ) {
+        char * bytes = (char *) data;
+        uint64_t total = 0;
+        while ( total < size ) {
+            auto res = das_fd_read(fd, bytes + total, das::min(size - total, uint64_t(1u<<30)));
+            if ( res <= 0 ) break;
+            total += res;
+        }
+        return total;
+    }
+
+    bool FdBinaryStream::unread ( uint64_t size ) {
+        if ( !size ) return true;
+#if defined(_MSC_VER)
+        return _lseeki64(fd, -int64_t(size), SEEK_CUR)!=-1;
+#else
+        return lseek(fd, -off_t(size), SEEK_CUR)!=-1;
+#endif
+    }
+
+    uint64_t binary_save_stream ( Context & context, BinaryStream & out, vec4f data, TypeInfo * info ) {
+        BinDataSerialize writer(context, out, false);
+        writer.header(info);
+        writer.walk(data, info);
+        writer.close();
+        return writer.position();
+    }
+
+    bool binary_load_stream ( Context & context, BinaryStream & in, char * data, TypeInfo * info ) {
+        BinDataSerialize reader(context, in, true);
+        bool loaded = reader.header(info);
+        if ( loaded ) {
+            TypeInfo ti = *info;
+            ti.flags &= ~TypeInfo::flag_ref;
+            reader.walk(data, &ti);
+        }
+        reader.close();
+        return loaded;
+    }
+
+    bool binary_map_stream ( Context & context, char * bytes, uint64_t size, char * data, TypeInfo * info, const Block & block, uint64_t * used ) {
+        if ( used ) *used = 0;
+        BinDataSerialize reader(context, bytes, size);
+        reader.bulk = true;
+        reader.mapped = true;
+        bool completed = context.runWithCatch([&]() {
+            bool loaded = reader.header(info);
+            if ( loaded ) {
+                TypeInfo ti = *info;
+                ti.flags &= ~TypeInfo::flag_ref;
+                reader.walk(data, &ti);
+            }
+            if ( used ) *used = loaded ? reader.position() : 0;
+            vec4f arg = cast<bool>::from(loaded);
+            context.invoke(block, &arg, nullptr);
+        });
+        reader.detach();
+        return completed;
+    }
 }
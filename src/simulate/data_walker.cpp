@@ -132,28 +132,35 @@ namespace das {
         int keySize = getTypeSize(info->firstType);
         int valueSize = getTypeSize(info->secondType);
         uint32_t count = 0;
-        for ( uint32_t i=0; i!=tab->capacity; ++i ) {
-            if ( tab->hashes[i] > HASH_KILLED32 ) {
-                bool last = (count == (tab->size-1));
-                // key
-                char * key = tab->keys + i*keySize;
-                beforeTableKey(tab, info, key, info->firstType, count, last);
-                if ( cancel ) return;
-                walk ( key, info->firstType );
-                if ( cancel ) return;
-                afterTableKey(tab, info, key, info->firstType, count, last);
-                if ( cancel ) return;
-                // value
-                char * value = tab->data + i*valueSize;
-                beforeTableValue(tab, info, value, info->secondType, count, last);
-                if ( cancel ) return;
-                walk ( value, info->secondType );
-                if ( cancel ) return;
-                afterTableValue(tab, info, value, info->secondType, count, last);
-                if ( cancel ) return;
-                // next
-                count ++;
+        auto walkSlots = [&]( const Table & slots ) {
+            for ( uint32_t i=0; i!=slots.capacity; ++i ) {
+                if ( slots.hashes[i] > HASH_KILLED32 ) {
+                    bool last = (count == (tab->size-1));
+                    // key
+                    char * key = slots.keys + i*keySize;
+                    beforeTableKey(tab, info, key, info->firstType, count, last);
+                    if ( cancel ) return;
+                    walk ( key, info->firstType );
+                    if ( cancel ) return;
+                    afterTableKey(tab, info, key, info->firstType, count, last);
+                    if ( cancel ) return;
+                    // value
+                    char * value = slots.data + i*valueSize;
+                    beforeTableValue(tab, info, value, info->secondType, count, last);
+                    if ( cancel ) return;
+                    walk ( value, info->secondType );
+                    if ( cancel ) return;
+                    afterTableValue(tab, info, value, info->secondType, count, last);
+                    if ( cancel ) return;
+                    // next
+                    count ++;
+                }
             }
+        };
+        walkSlots(*tab);
+        // slots of the rehashing table which are not migrated yet
+        if ( !cancel && tab->rehashing ) {
+            walkSlots(table_rehash_source(*tab));
         }
     }
 
@@ -2,6 +2,7 @@
 
 #include "daScript/simulate/debug_info.h"
 #include "daScript/ast/ast.h"
+#include "daScript/misc/job_que.h"
 
 #include "daScript/misc/enums.h"
 #include "daScript/misc/arraytype.h"
@@ -487,6 +488,7 @@ namespace das
     FileInfo * FileAccess::setFileInfo ( const string & fileName, FileInfoPtr && info ) {
         // TODO: test. for now we need to allow replace
         // if ( files.find(fileName)!=files.end() ) return nullptr;
+        lock_guard<mutex> guard(filesLock);
         files[fileName] = move(info);
         auto ins = files.find(fileName);
         ins->second->name = (char *) ins->first.c_str();
@@ -494,9 +496,12 @@ namespace das
     }
 
     FileInfo * FileAccess::getFileInfo ( const string & fileName ) {
-        auto it = files.find(fileName);
-        if ( it != files.end() ) {
-            return it->second.get();
+        {
+            lock_guard<mutex> guard(filesLock);
+            auto it = files.find(fileName);
+            if ( it != files.end() ) {
+                return it->second.get();
+            }
         }
         auto ni = getNewFileInfo(fileName);
         if ( ni ) {
@@ -505,6 +510,26 @@ namespace das
         return ni;
     }
 
+    void FileAccess::prefetchFileInfo ( const vector<string> & fileNames, JobQue & que ) {
+        vector<string> toLoad;
+        for ( const auto & fileName : fileNames ) {
+            if ( files.find(fileName)==files.end() && find(toLoad.begin(),toLoad.end(),fileName)==toLoad.end() ) {
+                toLoad.push_back(fileName);
+            }
+        }
+        if ( toLoad.size()<=1 ) {
+            for ( const auto & fileName : toLoad ) {
+                getFileInfo(fileName);
+            }
+            return;
+        }
+        que.parallel_for(0, int(toLoad.size()), [&]( int from, int to ) {
+            for ( int i=from; i!=to; ++i ) {
+                getFileInfo(toLoad[i]);
+            }
+        }, 0, JobPriority::Default);
+    }
+
     string FileAccess::getIncludeFileName ( const string & fileName, const string & incFileName ) const {
         auto np = fileName.find_last_of("\\/");
         if ( np != string::npos ) {
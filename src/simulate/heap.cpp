@@ -99,7 +99,7 @@ namespace das {
                     uint32_t b = ch->bits[i];
                     for ( uint32_t j=0; j!=32; ++j ) {    // todo: simpler bit loop
                         if ( b & (1<<j) ) {
-                            fn ( ch->data + (i*32 + j)*ch->size );
+                            fn ( ch->data + (i*32 + j)*ch->size + headerSize() );
                         }
                     }
                 }
@@ -107,7 +107,7 @@ namespace das {
         }
         if ( !model.bigStuff.empty() ) {
             for ( auto it : model.bigStuff ) {
-                fn ( (char*) it.first );
+                fn ( (char*) it.first + headerSize() );
             }
         }
     }
@@ -128,6 +128,11 @@ namespace das {
         }
     }
 
+    void StringHeapAllocator::setHeader ( bool on ) {
+        DAS_ASSERTF(bytesAllocated()==0, "string header can only be switched on the empty heap");
+        needHeader = on && canHaveHeader();
+    }
+
     void StringHeapAllocator::reset() {
         das_string_set empty;
         swap ( internMap, empty );
@@ -144,6 +149,10 @@ namespace das {
 
     void StringHeapAllocator::recognize ( char * str ) {
         if ( !str ) return;
+        if ( auto hdr = header(str) ) {
+            if ( needIntern ) internMap.insert(StrHashEntry(str,hdr->size));
+            return;
+        }
         uint32_t length = uint32_t(strlen(str));
         uint32_t size = length + 1;
         size = (size + 15) & ~15;
@@ -189,10 +198,18 @@ namespace das {
                     return (char *) it->ptr;
                 }
             }
-            if ( auto str = (char *)allocate(length + 1) ) {
+            if ( auto str = (char *)allocate(headerSize() + length + 1) ) {
 #if DAS_TRACK_ALLOCATIONS
                 if ( g_tracker_string==g_breakpoint_string ) os_debug_break();
 #endif
+                if ( needHeader ) {
+                    auto hdr = (StringHeader *) str;
+                    str += sizeof(StringHeader);
+                    hdr->hash = 0;
+                    hdr->length = StringHeader::lengthUnknown;    // text may have zeros in it, or come later
+                    hdr->size = length;
+                    hdr->check = StringHeader::makeCheck(str, length);
+                }
                 if ( text ) memcpy(str, text, length);
                 str[length] = 0;
                 if ( needIntern && text ) internMap.insert(StrHashEntry(str,length));
@@ -203,6 +220,14 @@ namespace das {
     }
 
     void StringHeapAllocator::freeString ( char * text, uint32_t length ) {
+        if ( needHeader ) {
+            auto hdr = (StringHeader *)(text - sizeof(StringHeader));
+            length = hdr->size;
+            hdr->check = 0;
+            if ( needIntern ) internMap.erase(StrHashEntry(text,length));
+            free ( (char *) hdr, uint32_t(sizeof(StringHeader)) + length + 1 );
+            return;
+        }
         if ( needIntern ) internMap.erase(StrHashEntry(text,length));
         free ( text, length + 1 );
     }
@@ -230,6 +255,20 @@ namespace das {
         }
     }
 
+    bool PersistentStringAllocator::isOwnString ( const char * base, uint32_t & capacity ) {
+#if !DAS_TRACK_ALLOCATIONS
+        if ( auto ch = model.shoe.findDeck((char *)base) ) {       // page lookup, any size class
+            if ( (uint32_t(base - ch->data) % ch->size)!=0 ) return false;  // start of the slot, not somewhere in the middle
+            capacity = ch->size;
+            return true;
+        }
+#endif
+        auto it = model.bigStuff.find((void *)base);
+        if ( it == model.bigStuff.end() ) return false;
+        capacity = it->second;
+        return true;
+    }
+
     bool PersistentStringAllocator::mark() {
         model.shoe.beforeGC();
         return true;
@@ -263,7 +302,7 @@ namespace das {
                     uint32_t b = ch->bits[i];
                     for ( uint32_t j=0; j!=32; ++j ) {
                         if ( b & (1<<j) ) {
-                            char * str = ( ch->data + (i*32 + j)*ch->size );
+                            char * str = ( ch->data + (i*32 + j)*ch->size + headerSize() );
                             tout << "\t\t" << presentStr(buf,str,32) << "\n";
                         }
                     }
@@ -276,7 +315,7 @@ namespace das {
         if ( !model.bigStuff.empty() ) {
             tout << "big stuff:\n";
             for ( auto it : model.bigStuff ) {
-                char * ch = (char *)it.first;
+                char * ch = (char *)it.first + headerSize();
                 strncpy(buf,ch,32);
                 buf[32] = 0;
                 tout << "\t" << presentStr(buf,ch,32) << " size " << it.second << " bytes\n";
@@ -293,13 +332,12 @@ namespace das {
             tout << HEX << intptr_t(ch->data) << DEC << "\t"
                 << ch->offset << " of " << ch->size << "\n";
             char * tail = ch->data + ch->offset;
-            for ( char * txt = ch->data; txt!=tail; ) {
+            for ( char * base = ch->data; base!=tail; ) {
+                char * txt = base + headerSize();
                 strncpy(buf,txt,32);
                 buf[32] = 0;
                 tout << "\t" << presentStr(buf,txt,32) << "\n";
-                auto sz = uint32_t(strlen(txt)) + 1;
-                sz = ( sz + model.alignMask ) & ~model.alignMask;
-                txt += sz;
+                base += ( allocationSize(txt) + model.alignMask ) & ~model.alignMask;
             }
         }
     }
@@ -307,11 +345,10 @@ namespace das {
     void LinearStringAllocator::forEachString ( const callable<void (const char *)> & fn ) {
         for ( auto ch=model.chunk; ch; ch=ch->next ) {
             char * tail = ch->data + ch->offset;
-            for ( char * txt = ch->data; txt!=tail; ) {
+            for ( char * base = ch->data; base!=tail; ) {
+                char * txt = base + headerSize();
                 fn(txt);
-                auto sz = uint32_t(strlen(txt)) + 1;
-                sz = ( sz + model.alignMask ) & ~model.alignMask;
-                txt += sz;
+                base += ( allocationSize(txt) + model.alignMask ) & ~model.alignMask;
             }
         }
     }
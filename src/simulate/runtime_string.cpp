@@ -117,25 +117,162 @@ namespace das
     }
 
     string escapeString ( const string & input, bool das_escape ) {
-        const char* str = input.c_str();
-        const char* strEnd = str + input.length();
+        uint32_t len = uint32_t(input.length());
         string result;
-        result.reserve(input.size());
-        for( ; str < strEnd; ++str ) {
-            switch ( *str ) {
-                case '\"':  result.append("\\\"");  break;
-                case '\\':  result.append("\\\\");  break;
-                case '\b':  result.append("\\b");   break;
-                case '\f':  result.append("\\f");   break;
-                case '\n':  result.append("\\n");   break;
-                case '\r':  result.append("\\r");   break;
-                case '\t':  result.append("\\t");   break;
-                case '{':   if (das_escape) result.append("\\{"); else result.append("{");  break;
-                case '}':   if (das_escape) result.append("\\}"); else result.append("}");  break;
-                default:    result.append(1, *str); break;
+        result.resize(escape_string_length(input.c_str(), len, das_escape));
+        if ( !result.empty() ) escape_string_to(&result[0], input.c_str(), len, das_escape);
+        return result;
+    }
+
+    // byte scanning kernels
+
+    __forceinline vec4i v_ldu_bytes ( const char * str ) {
+        return v_ldui((const int *)str);
+    }
+
+    const char * find_substring ( const char * str, uint32_t len, const char * substr, uint32_t sublen ) {
+        if ( sublen==0 ) return str;
+        if ( sublen>len ) return nullptr;
+        const char * last = str + len - sublen;
+        // candidates are positions where the first two and the last character of substr match
+        const uint32_t second = sublen > 1 ? 1 : 0;
+        vec4i first = v_splatsi8(substr[0]);
+        vec4i next = v_splatsi8(substr[second]);
+        vec4i tail = v_splatsi8(substr[sublen-1]);
+        const char * s = str;
+        for ( ; s + 16 <= last + 1; s += 16 ) {
+            vec4i eqf = v_cmp_eqi8(v_ldu_bytes(s), first);
+            vec4i eqn = v_cmp_eqi8(v_ldu_bytes(s + second), next);
+            vec4i eqt = v_cmp_eqi8(v_ldu_bytes(s + sublen - 1), tail);
+            uint32_t mask = uint32_t(v_signmaski8(v_andi(v_andi(eqf, eqn), eqt)));
+            while ( mask ) {
+                uint32_t i = __builtin_ctz(mask);
+                if ( memcmp(s + i, substr, sublen)==0 ) return s + i;
+                mask &= mask - 1;
             }
         }
-        return result;
+        for ( ; s <= last; ++s ) {
+            if ( *s==substr[0] && memcmp(s, substr, sublen)==0 ) return s;
+        }
+        return nullptr;
+    }
+
+    const char * find_first_of ( const char * str, uint32_t len, const char * set, uint32_t setLen ) {
+        const char * end = str + len;
+        const char * s = str;
+        if ( setLen==0 ) return nullptr;
+        if ( setLen<=4 ) {
+            vec4i c0 = v_splatsi8(set[0]);
+            vec4i c1 = v_splatsi8(set[setLen>1 ? 1 : 0]);
+            vec4i c2 = v_splatsi8(set[setLen>2 ? 2 : 0]);
+            vec4i c3 = v_splatsi8(set[setLen>3 ? 3 : 0]);
+            for ( ; s + 16 <= end; s += 16 ) {
+                vec4i b = v_ldu_bytes(s);
+                vec4i m = v_ori(v_ori(v_cmp_eqi8(b, c0), v_cmp_eqi8(b, c1)), v_ori(v_cmp_eqi8(b, c2), v_cmp_eqi8(b, c3)));
+                if ( uint32_t mask = uint32_t(v_signmaski8(m)) ) return s + __builtin_ctz(mask);
+            }
+        }
+        uint32_t table[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        for ( uint32_t i=0; i!=setLen; ++i ) {
+            uint8_t ch = uint8_t(set[i]);
+            table[ch>>5] |= 1u << (ch & 31);
+        }
+        for ( ; s < end; ++s ) {
+            uint8_t ch = uint8_t(*s);
+            if ( table[ch>>5] & (1u << (ch & 31)) ) return s;
+        }
+        return nullptr;
+    }
+
+    // returns first character which may need escaping: " \ \b \t \n \v \f \r, and { } for das_escape
+    const char * find_escape ( const char * str, uint32_t len, bool das_escape ) {
+        const char * end = str + len;
+        const char * s = str;
+        vec4i quote = v_splatsi8('\"');
+        vec4i slash = v_splatsi8('\\');
+        vec4i lo = v_splatsi8('\b' - 1);
+        vec4i hi = v_splatsi8('\r' + 1);
+        vec4i lbr = v_splatsi8(das_escape ? '{' : '\"');
+        vec4i rbr = v_splatsi8(das_escape ? '}' : '\"');
+        for ( ; s + 16 <= end; s += 16 ) {
+            vec4i b = v_ldu_bytes(s);
+            vec4i m = v_ori(v_cmp_eqi8(b, quote), v_cmp_eqi8(b, slash));
+            m = v_ori(m, v_andi(v_cmp_gti8(b, lo), v_cmp_gti8(hi, b)));
+            m = v_ori(m, v_ori(v_cmp_eqi8(b, lbr), v_cmp_eqi8(b, rbr)));
+            if ( uint32_t mask = uint32_t(v_signmaski8(m)) ) return s + __builtin_ctz(mask);
+        }
+        for ( ; s < end; ++s ) {
+            char ch = *s;
+            if ( ch=='\"' || ch=='\\' || (ch>='\b' && ch<='\r') || (das_escape && (ch=='{' || ch=='}')) ) return s;
+        }
+        return nullptr;
+    }
+
+    __forceinline const char * escape_sequence ( char ch, bool das_escape ) {
+        switch ( ch ) {
+            case '\"':  return "\\\"";
+            case '\\':  return "\\\\";
+            case '\b':  return "\\b";
+            case '\f':  return "\\f";
+            case '\n':  return "\\n";
+            case '\r':  return "\\r";
+            case '\t':  return "\\t";
+            case '{':   return das_escape ? "\\{" : nullptr;
+            case '}':   return das_escape ? "\\}" : nullptr;
+            default:    return nullptr;
+        }
+    }
+
+    uint32_t escape_string_length ( const char * str, uint32_t len, bool das_escape ) {
+        uint32_t total = len;
+        const char * end = str + len;
+        while ( const char * s = find_escape(str, uint32_t(end - str), das_escape) ) {
+            if ( escape_sequence(*s, das_escape) ) total ++;
+            str = s + 1;
+        }
+        return total;
+    }
+
+    char * escape_string_to ( char * dst, const char * str, uint32_t len, bool das_escape ) {
+        const char * end = str + len;
+        while ( const char * s = find_escape(str, uint32_t(end - str), das_escape) ) {
+            memcpy(dst, str, s - str);
+            dst += s - str;
+            if ( auto esc = escape_sequence(*s, das_escape) ) {
+                *dst++ = esc[0];
+                *dst++ = esc[1];
+            } else {
+                *dst++ = *s;
+            }
+            str = s + 1;
+        }
+        memcpy(dst, str, end - str);
+        return dst + (end - str);
+    }
+
+    template <char A, char Z>
+    __forceinline void flip_case_bytes ( char * dst, const char * str, uint32_t len ) {
+        const char * end = str + len;
+        vec4i lo = v_splatsi8(A - 1);
+        vec4i hi = v_splatsi8(Z + 1);
+        vec4i bit = v_splatsi8(0x20);
+        for ( ; str + 16 <= end; str += 16, dst += 16 ) {
+            vec4i b = v_ldu_bytes(str);
+            vec4i m = v_andi(v_cmp_gti8(b, lo), v_cmp_gti8(hi, b));
+            v_stu_w(dst, v_xori(b, v_andi(m, bit)));
+        }
+        for ( ; str < end; ++str, ++dst ) {
+            char ch = *str;
+            *dst = (ch >= A && ch <= Z) ? char(ch ^ 0x20) : ch;
+        }
+    }
+
+    void to_upper_bytes ( char * dst, const char * str, uint32_t len ) {
+        flip_case_bytes<'a','z'>(dst, str, len);
+    }
+
+    void to_lower_bytes ( char * dst, const char * str, uint32_t len ) {
+        flip_case_bytes<'A','Z'>(dst, str, len);
     }
 
     string getFewLines ( const char* st, int ROW, int COL, int LROW, int LCOL, int TAB ) {
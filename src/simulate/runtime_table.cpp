@@ -1,16 +1,28 @@
 #include "daScript/misc/platform.h"
 
 #include "daScript/simulate/runtime_table_nodes.h"
+#include "daScript/misc/performance_time.h"
 
 namespace das
 {
     void table_clear ( Context & context, Table & arr ) {
         if ( arr.isLocked() ) context.throw_error("can't clear locked table");
+        if ( arr.rehashing ) {
+            auto rec = table_rehash(arr);
+            context.heap->free(rec->oldData, table_memory_size(rec->oldCapacity, rec->keySize + rec->valueSize));
+            rec->oldData = nullptr;
+            arr.rehashing = false;
+        }
         memset(arr.hashes, 0, arr.capacity * sizeof(uint32_t));
+#if DAS_TABLE_CONTROL_BYTES
+        if ( arr.capacity ) memset(table_control(arr), TABLE_CTRL_EMPTY, table_control_size(arr.capacity));
+#endif
         arr.size = 0;
     }
 
     void table_lock ( Context & context, Table & arr ) {
+        // iterators, and everything else which holds on to the slots, expect them not to move
+        if ( arr.rehashing ) table_rehash_finish(context, arr);
         if ( arr.shared || arr.hopeless ) return;
         arr.lock ++;
         if ( arr.lock==0 ) context.throw_error("table lock overflow");
@@ -22,6 +34,233 @@ namespace das
         arr.lock --;
     }
 
+    // storage and rehash
+
+    bool table_allocate ( Context & context, Table & tab, uint32_t capacity, uint32_t keySize, uint32_t valueSize ) {
+        uint32_t memSize = table_memory_size(capacity, keySize + valueSize);
+        tab.data = (char *) context.heap->allocate(memSize);
+        context.heap->mark_comment(tab.data, "table");
+        if ( !tab.data ) {
+            context.throw_error("can't grow table, out of heap");
+            return false;
+        }
+        tab.keys = tab.data + capacity * valueSize;
+        tab.hashes = (uint32_t *)(tab.keys + capacity * keySize);
+        tab.capacity = capacity;
+        tab.maxLookups = TableProbe::computeMaxLookups(capacity);
+        tab.shift = TableProbe::computeShift(capacity);
+        memset(tab.data, 0, capacity * valueSize);
+        memset(tab.hashes, 0, capacity * sizeof(uint32_t));
+#if DAS_TABLE_CONTROL_BYTES
+        memset(table_control(tab), TABLE_CTRL_EMPTY, table_control_size(capacity));
+#endif
+        auto rec = table_rehash(tab);
+        memset(rec, 0, sizeof(TableRehash));
+        rec->keySize = keySize;
+        rec->valueSize = valueSize;
+        return true;
+    }
+
+    void table_free ( Context & context, Table & tab, uint32_t keyValueSize ) {
+        if ( !tab.data ) return;
+        if ( tab.rehashing ) {
+            auto rec = table_rehash(tab);
+            context.heap->free(rec->oldData, table_memory_size(rec->oldCapacity, keyValueSize));
+        }
+        context.heap->free(tab.data, table_memory_size(tab.capacity, keyValueSize));
+    }
+
+    Table table_rehash_source ( const Table & tab ) {
+        auto rec = table_rehash(tab);
+        Table old;
+        memset(&old, 0, sizeof(Table));
+        old.data = rec->oldData;
+        old.capacity = rec->oldCapacity;
+        old.keys = old.data + old.capacity * rec->valueSize;
+        old.hashes = (uint32_t *)(old.keys + old.capacity * rec->keySize);
+        old.maxLookups = TableProbe::computeMaxLookups(old.capacity);
+        old.shift = TableProbe::computeShift(old.capacity);
+        return old;
+    }
+
+    // copies live slots of one table to another, which is expected to have no such keys
+    static bool table_copy_slots ( Table & to, const Table & from, uint32_t keySize, uint32_t valueSize ) {
+        for ( uint32_t i=0; i!=from.capacity; ++i ) {
+            auto hash = from.hashes[i];
+            if ( hash>HASH_KILLED32 ) {
+                int index = TableProbe::insertNew(to, hash);
+                if ( index==-1 ) return false;
+                to.hashes[index] = hash;
+#if DAS_TABLE_CONTROL_BYTES
+                TableProbe::setControl(to, index, TableProbe::hashTag(hash));
+#endif
+                memcpy(to.keys + index*keySize, from.keys + i*keySize, keySize);
+                memcpy(to.data + index*valueSize, from.data + i*valueSize, valueSize);
+            }
+        }
+        return true;
+    }
+
+    // stop-the-world rehash into a table of at least this capacity, including the slots which are still being migrated
+    bool table_rehash_full ( Context & context, Table & tab, uint32_t capacity, uint32_t keySize, uint32_t valueSize ) {
+        auto t0 = ref_time_ticks();
+        uint32_t rehashes = 0, incremental = 0;
+        uint64_t rehashTime = 0;
+        if ( tab.data ) {
+            auto rec = table_rehash(tab);
+            rehashes = rec->rehashes;
+            incremental = rec->incremental;
+            rehashTime = rec->rehashTime;
+        }
+        for ( ;; capacity *= 2 ) {
+            Table newTab;
+            memset(&newTab, 0, sizeof(Table));
+            if ( !table_allocate(context, newTab, capacity, keySize, valueSize) ) {
+                return false;
+            }
+            if ( table_copy_slots(newTab, tab, keySize, valueSize)
+                    && (!tab.rehashing || table_copy_slots(newTab, table_rehash_source(tab), keySize, valueSize)) ) {
+                table_free(context, tab, keySize + valueSize);
+                newTab.size = tab.size;
+                newTab.lock = tab.lock;
+                newTab.flags = tab.flags;
+                newTab.rehashing = false;
+                auto rec = table_rehash(newTab);
+                rec->rehashes = rehashes + 1;
+                rec->incremental = incremental;
+                rec->rehashTime = rehashTime + get_time_usec(t0);
+                tab = newTab;
+                return true;
+            }
+            context.heap->free(newTab.data, table_memory_size(capacity, keySize + valueSize));
+        }
+    }
+
+    // large tables switch to the new allocation right away, and migrate the old one a step at a time on access.
+    // the new allocation is twice as big, so migration is done long before it fills up
+    bool table_grow ( Context & context, Table & tab, uint32_t keySize, uint32_t valueSize ) {
+        if ( tab.rehashing ) table_rehash_finish(context, tab);
+        uint32_t newCapacity = das::max(uint32_t(TableProbe::minCapacity), tab.capacity*2);
+        if ( !DAS_TABLE_INCREMENTAL_REHASH || tab.capacity < uint32_t(DAS_TABLE_INCREMENTAL_REHASH) ) {
+            return table_rehash_full(context, tab, newCapacity, keySize, valueSize);
+        }
+        auto t0 = ref_time_ticks();
+        TableRehash prev = *table_rehash(tab);
+        Table newTab;
+        memset(&newTab, 0, sizeof(Table));
+        if ( !table_allocate(context, newTab, newCapacity, keySize, valueSize) ) {
+            return false;
+        }
+        newTab.size = tab.size;
+        newTab.lock = tab.lock;
+        newTab.flags = tab.flags;
+        newTab.rehashing = true;
+        auto rec = table_rehash(newTab);
+        rec->oldData = tab.data;
+        rec->oldCapacity = tab.capacity;
+        rec->rehashes = prev.rehashes + 1;
+        rec->incremental = prev.incremental + 1;
+        rec->rehashTime = prev.rehashTime + get_time_usec(t0);
+        tab = newTab;
+        table_rehash_step(context, tab, TABLE_REHASH_STEP);
+        return true;
+    }
+
+    // moves one slot of the previous allocation to the new one, or returns -1 if it does not fit
+    int table_rehash_move ( Context &, Table & tab, Table & old, uint32_t oldIndex ) {
+        auto rec = table_rehash(tab);
+        auto hash = old.hashes[oldIndex];
+        int index = TableProbe::insertNew(tab, hash);
+        if ( index==-1 ) {
+            return -1;
+        }
+        tab.hashes[index] = hash;
+        memcpy(tab.keys + index*rec->keySize, old.keys + oldIndex*rec->keySize, rec->keySize);
+        memcpy(tab.data + index*rec->valueSize, old.data + oldIndex*rec->valueSize, rec->valueSize);
+        old.hashes[oldIndex] = HASH_KILLED32;
+#if DAS_TABLE_CONTROL_BYTES
+        TableProbe::setControl(tab, index, TableProbe::hashTag(hash));
+        TableProbe::setControl(old, oldIndex, TABLE_CTRL_DELETED);
+#endif
+        return index;
+    }
+
+    // migration never moves slots which are already in the new allocation, so lookups keep values where they are.
+    // if a slot does not fit, migration stops there until the table grows again
+    void table_rehash_step ( Context & context, Table & tab, uint32_t slots ) {
+        if ( !tab.rehashing ) return;
+        auto t0 = ref_time_ticks();
+        Table old = table_rehash_source(tab);
+        auto rec = table_rehash(tab);
+        uint32_t last = das::min(rec->cursor + slots, old.capacity);
+        uint32_t i = rec->cursor;
+        for ( ; i!=last; ++i ) {
+            if ( old.hashes[i]>HASH_KILLED32 && table_rehash_move(context, tab, old, i)==-1 ) {
+                break;
+            }
+        }
+        rec->cursor = i;
+        if ( i==old.capacity ) {
+            context.heap->free(old.data, table_memory_size(old.capacity, rec->keySize + rec->valueSize));
+            rec->oldData = nullptr;
+            rec->oldCapacity = 0;
+            rec->cursor = 0;
+            tab.rehashing = false;
+        }
+        rec->rehashTime += get_time_usec(t0);
+    }
+
+    void table_rehash_finish ( Context & context, Table & tab ) {
+        if ( !tab.rehashing ) return;
+        table_rehash_step(context, tab, table_rehash(tab)->oldCapacity);
+        if ( tab.rehashing ) {
+            auto rec = table_rehash(tab);
+            table_rehash_full(context, tab, tab.capacity*2, rec->keySize, rec->valueSize);
+        }
+    }
+
+    void table_reserve ( Context & context, Table & tab, uint32_t size, uint32_t keySize, uint32_t valueSize ) {
+        if ( tab.isLocked() ) context.throw_error("can't reserve locked table");
+        uint32_t capacity = TableProbe::minCapacity;
+        while ( capacity < size*2 && capacity < 0x80000000u ) capacity *= 2;
+        if ( capacity > tab.capacity ) {
+            table_rehash_full(context, tab, capacity, keySize, valueSize);
+        }
+    }
+
+    static void table_probe_stats ( const Table & tab, TableStats & stats ) {
+        uint32_t mask = tab.capacity - 1;
+        for ( uint32_t i=0; i!=tab.capacity; ++i ) {
+            auto hash = tab.hashes[i];
+            if ( hash>HASH_KILLED32 ) {
+                uint32_t probe = ((i - TableProbe::indexFromHash(hash, tab.shift)) & mask) + 1;
+                stats.max_probe = das::max(stats.max_probe, probe);
+                stats.total_probe += probe;
+            } else if ( hash==HASH_KILLED32 ) {
+                stats.tombstones ++;
+            }
+        }
+    }
+
+    void table_stats ( const Table & tab, TableStats & stats ) {
+        memset(&stats, 0, sizeof(TableStats));
+        stats.capacity = tab.capacity;
+        stats.size = tab.size;
+        if ( !tab.data ) return;
+        table_probe_stats(tab, stats);
+        auto rec = table_rehash(tab);
+        stats.rehashes = rec->rehashes;
+        stats.incremental_rehashes = rec->incremental;
+        stats.rehash_usec = rec->rehashTime;
+        stats.rehashing = tab.rehashing;
+        if ( tab.rehashing ) {
+            // slots of the previous allocation count as probes, migrated ones are not tombstones of this table
+            uint32_t tombstones = stats.tombstones;
+            table_probe_stats(table_rehash_source(tab), stats);
+            stats.tombstones = tombstones;
+        }
+    }
+
     // TableIterator
 
     size_t TableIterator::nextValid ( size_t index ) const {
@@ -105,8 +344,7 @@ namespace das
         for ( uint32_t i=0; i!=total; ++i, pTable-- ) {
             if ( pTable->data ) {
                 if ( !pTable->isLocked() ) {
-                    uint32_t oldSize = pTable->capacity*(vts_add_kts + sizeof(uint32_t));
-                    context.heap->free(pTable->data, oldSize);
+                    table_free(context, *pTable, vts_add_kts);
                 } else {
                     context.throw_error("deleting locked table");
                     return v_zero();
@@ -0,0 +1,218 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/simulate/sampling_profiler.h"
+#include "daScript/misc/performance_time.h"
+
+#include "daScript/simulate/simulate_visit_op.h"
+
+namespace das {
+
+    SamplingProfiler::SamplingProfiler ( uint32_t every ) : sampleEvery(every), samplePending(false) {
+        reset();
+    }
+
+    void SamplingProfiler::reset() {
+        stepsSinceSample = 0;
+        samplePending = false;
+        lastTicks = ref_time_ticks();
+        elapsedUsec = 0;
+        functions.clear();
+        functionIndex.clear();
+        nodes.clear();
+        nodes.emplace_back();
+        children.clear();
+        samples.clear();
+    }
+
+    uint32_t SamplingProfiler::getFunction ( FuncInfo * info ) {
+        auto it = functionIndex.find(info);
+        if ( it != functionIndex.end() ) return it->second;
+        uint32_t index = uint32_t(functions.size());
+        functions.push_back(info ? info->name : "[aot]");
+        functionIndex[info] = index;
+        return index;
+    }
+
+    uint32_t SamplingProfiler::getChild ( uint32_t parent, uint32_t function ) {
+        uint64_t key = (uint64_t(parent) << 32) | function;
+        auto it = children.find(key);
+        if ( it != children.end() ) return it->second;
+        uint32_t index = uint32_t(nodes.size());
+        StackNode node;
+        node.parent = parent;
+        node.function = function;
+        nodes.push_back(node);
+        children[key] = index;
+        return index;
+    }
+
+    void SamplingProfiler::getPath ( uint32_t node, vector<uint32_t> & path ) const {
+        path.clear();
+        for ( ; node; node = nodes[node].parent ) {
+            path.push_back(nodes[node].function);
+        }
+        reverse(path.begin(), path.end());
+    }
+
+    void SamplingProfiler::sample ( Context & context, const LineInfo &, FuncInfo * leaf ) {
+#if DAS_ENABLE_STACK_WALK
+        elapsedUsec += get_time_usec(lastTicks);
+        lastTicks = ref_time_ticks();
+        // same walk as the stack walker, only we need the function
+        frames.clear();
+        if ( leaf ) frames.push_back(leaf);
+        char * sp = context.stack.ap();
+        while ( sp < context.stack.top() ) {
+            Prologue * pp = (Prologue *) sp;
+            FuncInfo * info = nullptr;
+            if ( pp->info ) {
+                intptr_t iblock = intptr_t(pp->block);
+                info = (iblock & 1) ? ((Block *) (iblock & ~1))->info : pp->info;
+            }
+            frames.push_back(info);
+            sp += info ? info->stackSize : pp->stackSize;
+        }
+        uint32_t node = 0;
+        for ( auto it = frames.rbegin(); it != frames.rend(); ++it ) {
+            node = getChild(node, getFunction(*it));
+        }
+        nodes[node].self ++;
+        samples.push_back({node, elapsedUsec});
+#endif
+    }
+
+    vector<SamplingProfiler::FunctionSamples> SamplingProfiler::getFunctionSamples() const {
+        vector<FunctionSamples> times(functions.size());
+        for ( size_t i=0; i!=functions.size(); ++i ) {
+            times[i].name = functions[i];
+        }
+        vector<uint32_t> path;
+        vector<bool> seen(functions.size(), false);
+        for ( uint32_t ni=1; ni<uint32_t(nodes.size()); ++ni ) {
+            auto & node = nodes[ni];
+            if ( !node.self ) continue;
+            times[node.function].exclusive += node.self;
+            getPath(ni, path);
+            for ( auto fn : path ) {            // recursion counts once
+                if ( seen[fn] ) continue;
+                seen[fn] = true;
+                times[fn].inclusive += node.self;
+            }
+            for ( auto fn : path ) {
+                seen[fn] = false;
+            }
+        }
+        sort(times.begin(), times.end(), [](const FunctionSamples & a, const FunctionSamples & b) {
+            return a.inclusive!=b.inclusive ? a.inclusive > b.inclusive : a.exclusive > b.exclusive;
+        });
+        return times;
+    }
+
+    void SamplingProfiler::writeReport ( TextWriter & tout ) const {
+        uint64_t total = samples.size();
+        tout << "SAMPLING PROFILER: " << total << " samples, " << int64_t(elapsedUsec/1000) << " ms\n";
+        if ( !total ) return;
+        char line[64];
+        tout << " incl%   excl%   samples  function\n";
+        for ( auto & ft : getFunctionSamples() ) {
+            snprintf(line, sizeof(line), "%6.2f  %6.2f  %8llu  ",
+                ft.inclusive*100.0/total, ft.exclusive*100.0/total, (unsigned long long) ft.inclusive);
+            tout << line << ft.name << "\n";
+        }
+    }
+
+    // one line per unique call stack, root first, separated by ';' - the input of flamegraph.pl and speedscope
+    void SamplingProfiler::writeCollapsedStacks ( TextWriter & tout ) const {
+        vector<uint32_t> path;
+        for ( uint32_t ni=1; ni<uint32_t(nodes.size()); ++ni ) {
+            if ( !nodes[ni].self ) continue;
+            getPath(ni, path);
+            for ( size_t i=0; i!=path.size(); ++i ) {
+                if ( i ) tout << ";";
+                tout << functions[path[i]];
+            }
+            tout << " " << nodes[ni].self << "\n";
+        }
+    }
+
+    static void writeJsonString ( TextWriter & tout, const string & str ) {
+        tout << "\"";
+        for ( auto ch : str ) {
+            if ( ch=='"' || ch=='\\' ) {
+                tout << "\\" << ch;
+            } else if ( uint8_t(ch) < 32 ) {
+                tout << " ";
+            } else {
+                tout << ch;
+            }
+        }
+        tout << "\"";
+    }
+
+    // consecutive samples are turned into begin / end events, so that the trace shows the call timeline
+    void SamplingProfiler::writeChromeTrace ( TextWriter & tout ) const {
+        tout << "{\"traceEvents\":[\n";
+        bool first = true;
+        auto event = [&]( uint32_t fn, const char * ph, int64_t ts ) {
+            if ( !first ) tout << ",\n";
+            first = false;
+            tout << "{\"name\":";
+            writeJsonString(tout, functions[fn]);
+            tout << ",\"ph\":\"" << ph << "\",\"ts\":" << ts << ",\"pid\":0,\"tid\":0}";
+        };
+        vector<uint32_t> prev, path;
+        int64_t ts = 0;
+        for ( auto & smp : samples ) {
+            ts = smp.usec;
+            getPath(smp.node, path);
+            size_t common = 0;
+            while ( common<prev.size() && common<path.size() && prev[common]==path[common] ) {
+                common ++;
+            }
+            for ( size_t i=prev.size(); i>common; --i ) {
+                event(prev[i-1], "E", ts);
+            }
+            for ( size_t i=common; i<path.size(); ++i ) {
+                event(path[i], "B", ts);
+            }
+            swap(prev, path);
+        }
+        for ( size_t i=prev.size(); i>0; --i ) {
+            event(prev[i-1], "E", ts);
+        }
+        tout << "\n]}\n";
+    }
+
+    void Context::sampleStep ( const LineInfo & at ) {
+        sampler->onStep(*this, at);
+    }
+
+    // entry hook. by the time function code runs, its frame is on the stack, so the sample is attributed to the function itself.
+    // fastcall functions have no frame, they are added on top of the stack
+    struct SimNode_SampleEntry : SimNode {
+        SimNode_SampleEntry ( const LineInfo & at, SimNode * b, FuncInfo * l ) : SimNode(at), body(b), leaf(l) {}
+        virtual SimNode * visit ( SimVisitor & vis ) override {
+            V_BEGIN();
+            V_OP(SampleEntry);
+            V_SUB(body);
+            V_END();
+        }
+        virtual vec4f eval ( Context & context ) override {
+            if ( context.sampler ) {
+                context.sampler->onStep(context, debugInfo, leaf);
+            }
+            return body->eval(context);
+        }
+        SimNode * body;
+        FuncInfo * leaf;
+    };
+
+    void SamplingProfiler::instrumentFunctions ( Context & context ) {
+        for ( int i=0; i!=context.getTotalFunctions(); ++i ) {
+            auto fn = context.getFunction(i);
+            if ( !fn->code || fn->sampled || fn->bytecode ) continue;  // bytecode calls bytecode directly, it has to stay SimNode_Bytecode
+            fn->code = context.code->makeNode<SimNode_SampleEntry>(fn->code->debugInfo, fn->code, fn->fastcall ? fn->debugInfo : nullptr);
+            fn->sampled = true;
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include "daScript/simulate/simulate_nodes.h"
 #include "daScript/simulate/runtime_string.h"
 #include "daScript/simulate/debug_print.h"
+#include "daScript/simulate/sampling_profiler.h"
 #include "daScript/misc/fpe.h"
 #include "daScript/misc/debug_break.h"
 
@@ -702,6 +703,7 @@ namespace das
         heap->setInitialSize(ctx.heap->getInitialSize());
         stringHeap->setInitialSize(ctx.stringHeap->getInitialSize());
         stringHeap->setIntern(ctx.stringHeap->isIntern());
+        stringHeap->setHeader(ctx.stringHeap->isHeader());
         // globals
         annotationData = ctx.annotationData;
         globalsSize = ctx.globalsSize;
@@ -736,9 +738,10 @@ namespace das
         // register
         std::lock_guard<std::mutex> guard(g_DebugAgentMutex);
         if ( g_DebugAgent ) g_DebugAgent->onCreateContext(this);
+        globalsImage = ctx.globalsImage;
         // now, make it good to go
         restart();
-        runInitScript();
+        initGlobals();
         restart();
     }
 
@@ -857,10 +860,62 @@ namespace das
             pa->shared = true;
         }
         virtual void beforeTable ( Table * pa, TypeInfo * ) override {
+            if ( pa->rehashing ) table_rehash_finish(*context, *pa);    // lookups would migrate it otherwise
             pa->shared = true;
         }
     };
 
+    // image is copied byte for byte, so globals can't hold pointers (into the globals, or anywhere else),
+    // or handled types which are not pod, i.e. own memory of their own
+    class GlobalsImageWalker : public DataWalker {
+    public:
+        bool canCopy = true;
+        virtual void beforePtr ( char * pa, TypeInfo * ) override {
+            if ( *(char **)pa ) {
+                canCopy = false;
+                cancel = true;
+            }
+        }
+        virtual void beforeHandle ( char *, TypeInfo * ti ) override {
+            if ( !(ti->flags & TypeInfo::flag_isPod) ) {
+                canCopy = false;
+                cancel = true;
+            }
+        }
+    };
+
+    // snapshot of globals, as they are after the init script. it can only be taken when globals don't point to the heap,
+    // or to each other. [init] functions are part of the init script, contexts which start from the image don't run them.
+    // unless withInitFunctions is set, there can't be any - those are expected to run for every context
+    bool Context::makeGlobalsImage ( bool withInitFunctions ) {
+        globalsImage.reset();
+        if ( !globals || heap->bytesAllocated() || stringHeap->bytesAllocated() ) return false;
+        if ( !withInitFunctions ) {
+            for ( int j=0; j!=totalFunctions; ++j ) {
+                if ( functions[j].debugInfo->flags & FuncInfo::flag_init ) return false;
+            }
+        }
+        GlobalsImageWalker giw;
+        giw.context = this;
+        for ( int i=0; i!=totalVariables && giw.canCopy; ++i ) {
+            auto & pv = globalVariables[i];
+            if ( !pv.shared ) {
+                giw.walk(globals + pv.offset, pv.debugInfo);
+            }
+        }
+        if ( !giw.canCopy ) return false;
+        globalsImage = make_shared<vector<char>>(globals, globals + globalsSize);
+        return true;
+    }
+
+    void Context::initGlobals ( ) {
+        if ( globalsImage ) {
+            memcpy ( globals, globalsImage->data(), globalsSize );
+        } else {
+            runInitScript();
+        }
+    }
+
     void Context::runInitScript ( ) {
         DAS_ASSERTF(insideContext==0,"can't run init script on the locked context");
         char * EP, *SP;
@@ -914,6 +969,7 @@ namespace das
         // now, share the data
         if ( sharedOwner && shared ) {
             SharedDataWalker sdw;
+            sdw.context = this;
             for ( int i=0; i!=totalVariables; ++i ) {
                 auto & pv = globalVariables[i];
                 if ( pv.init && pv.shared ) {
@@ -0,0 +1,232 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/simulate/simulate_bytecode.h"
+#include "daScript/simulate/simulate_visit_op.h"
+
+// threaded dispatch needs labels as values
+#if defined(__GNUC__) || defined(__clang__)
+#define DAS_BYTECODE_THREADED   1
+#else
+#define DAS_BYTECODE_THREADED   0
+#endif
+
+namespace das
+{
+    const char * getBcOpName ( BcOp op ) {
+        static const char * names[] = {
+#define DAS_BYTECODE_NAME(name) #name,
+            DAS_BYTECODE_OPS(DAS_BYTECODE_NAME)
+#undef DAS_BYTECODE_NAME
+        };
+        return uint32_t(op) < uint32_t(BcOp::count) ? names[int32_t(op)] : "???";
+    }
+
+    void printBytecode ( TextWriter & ss, const SimNode_Bytecode * node ) {
+        ss << "// " << node->registerCount << " registers, " << node->argCount << " arguments\n";
+        for ( uint32_t i=0; i!=node->codeSize; ++i ) {
+            auto & ins = node->instructions[i];
+            ss << "\t" << i << "\t" << getBcOpName(ins.op) << "\t" << ins.a << ", " << ins.b << ", " << ins.c;
+            if ( ins.op==BcOp::Call ) {
+                auto & cs = node->calls[ins.b];
+                ss << "\t// fn " << cs.fnIndex << " (r" << cs.argStart << " x " << cs.argCount << ")";
+            }
+            ss << "\n";
+        }
+    }
+
+    SimNode * SimNode_Bytecode::copyNode ( Context & context, NodeAllocator * code ) {
+        SimNode_Bytecode * that = (SimNode_Bytecode *) SimNode::copyNode(context, code);
+        if ( codeSize ) {
+            that->instructions = (BcInstr *) code->allocate(codeSize * sizeof(BcInstr));
+            memcpy ( that->instructions, instructions, codeSize * sizeof(BcInstr) );
+        }
+        if ( callCount ) {
+            that->calls = (BcCall *) code->allocate(callCount * sizeof(BcCall));
+            memcpy ( that->calls, calls, callCount * sizeof(BcCall) );
+        }
+        return that;
+    }
+
+    SimNode * SimNode_Bytecode::visit ( SimVisitor & vis ) {
+        V_BEGIN();
+        V_OP(Bytecode);
+        V_ARG(codeSize);
+        V_ARG(registerCount);
+        V_ARG(fnIndex);
+        V_END();
+    }
+
+    vec4f SimNode_Bytecode::eval ( Context & context ) {
+        DAS_PROFILE_NODE
+        vec4f * args = context.abiArguments();
+        char * EP, * SP;
+        if ( ownFrame ) {
+            SimFunction * fn = context.getFunction(fnIndex);
+            if ( !context.stack.push(fn->stackSize, EP, SP) ) {
+                context.throw_error_at(debugInfo, "stack overflow while calling %s", fn->mangledName);
+            }
+#if DAS_ENABLE_STACK_WALK
+            Prologue * pp = (Prologue *) context.stack.sp();
+            pp->info = fn->debugInfo;
+            pp->arguments = args;
+            pp->cmres = nullptr;
+            pp->line = nullptr;
+#endif
+        }
+        int32_t * R = frameRegisters(context.stack.sp());
+        for ( uint32_t i=0; i!=argCount; ++i ) {
+            int32_t value = cast<int32_t>::to(args[i]);
+            R[i] = (boolArgs & (1u<<i)) ? int32_t(value!=0) : value;
+        }
+        int32_t res = run(context, R);
+        if ( ownFrame ) {
+            context.stack.pop(EP, SP);
+        }
+        return context.abiResult() = cast<int32_t>::from(res);
+    }
+
+    // kept out of line, so that the interpreter loop does not carry the argument array in its frame
+    ___noinline vec4f SimNode_Bytecode::callTree ( Context & context, const BcCall & cs, SimFunction * fn, const int32_t * R ) {
+        vec4f callArgs[maxCallArguments];
+        for ( int32_t i=0; i!=cs.argCount; ++i ) {
+            callArgs[i] = cast<int32_t>::from(R[cs.argStart + i]);
+        }
+        return context.callOrFastcall(fn, callArgs, (LineInfo *) &cs.at);
+    }
+
+#if DAS_BYTECODE_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+    int32_t SimNode_Bytecode::run ( Context & context, int32_t * __restrict R ) {
+        const BcInstr * __restrict pc = instructions;
+#if DAS_BYTECODE_THREADED
+        static const void * dispatch[] = {
+#define DAS_BYTECODE_LABEL(name) &&op_##name,
+            DAS_BYTECODE_OPS(DAS_BYTECODE_LABEL)
+#undef DAS_BYTECODE_LABEL
+        };
+#define BC_OP(name)     op_##name:
+#define BC_NEXT()       goto *dispatch[int32_t((++pc)->op)]
+#define BC_JUMP(to)     { pc = instructions + (to); goto *dispatch[int32_t(pc->op)]; }
+        goto *dispatch[int32_t(pc->op)];
+#else
+#define BC_OP(name)     case BcOp::name:
+#define BC_NEXT()       { ++pc; continue; }
+#define BC_JUMP(to)     { pc = instructions + (to); continue; }
+        for ( ;; ) switch ( pc->op ) {
+#endif
+        BC_OP(Mov)      R[pc->a] = R[pc->b]; BC_NEXT();
+        BC_OP(Ldi)      R[pc->a] = pc->b; BC_NEXT();
+        // arithmetic wraps around, same as the tree interpreter does
+#define BC_BIN(name,expr) \
+        BC_OP(name)     { int32_t l = R[pc->b], r = R[pc->c]; R[pc->a] = (expr); } BC_NEXT(); \
+        BC_OP(name##K)  { int32_t l = R[pc->b], r = pc->c; R[pc->a] = (expr); } BC_NEXT();
+        BC_BIN(Add, int32_t(uint32_t(l) + uint32_t(r)))
+        BC_BIN(Sub, int32_t(uint32_t(l) - uint32_t(r)))
+        BC_BIN(Mul, int32_t(uint32_t(l) * uint32_t(r)))
+        BC_BIN(And, l & r)
+        BC_BIN(Or,  l | r)
+        BC_BIN(Xor, l ^ r)
+        BC_BIN(Shl, l << r)
+        BC_BIN(Shr, l >> r)
+        BC_BIN(Eq,  int32_t(l == r))
+        BC_BIN(Ne,  int32_t(l != r))
+        BC_BIN(Lt,  int32_t(l <  r))
+        BC_BIN(Le,  int32_t(l <= r))
+        BC_BIN(Gt,  int32_t(l >  r))
+        BC_BIN(Ge,  int32_t(l >= r))
+#undef BC_BIN
+        // immediate divisors are never zero, lowering keeps those in registers
+        BC_OP(Div) {
+            int32_t r = R[pc->c];
+            if ( r==0 ) context.throw_error("division by zero");
+            R[pc->a] = R[pc->b] / r;
+        } BC_NEXT();
+        BC_OP(DivK)     R[pc->a] = R[pc->b] / pc->c; BC_NEXT();
+        BC_OP(Mod) {
+            int32_t r = R[pc->c];
+            if ( r==0 ) context.throw_error("division by zero in modulo");
+            R[pc->a] = R[pc->b] % r;
+        } BC_NEXT();
+        BC_OP(ModK)     R[pc->a] = R[pc->b] % pc->c; BC_NEXT();
+        BC_OP(Neg)      R[pc->a] = int32_t(0u - uint32_t(R[pc->b])); BC_NEXT();
+        BC_OP(Not)      R[pc->a] = int32_t(R[pc->b]==0); BC_NEXT();
+        BC_OP(BNot)     R[pc->a] = ~R[pc->b]; BC_NEXT();
+        BC_OP(Jmp)      BC_JUMP(pc->a);
+        BC_OP(Jz)       if ( !R[pc->a] ) BC_JUMP(pc->b); BC_NEXT();
+        BC_OP(Jnz)      if ( R[pc->a] ) BC_JUMP(pc->b); BC_NEXT();
+#define BC_JCMP(name,cmp) \
+        BC_OP(J##name)      if ( R[pc->a] cmp R[pc->b] ) BC_JUMP(pc->c); BC_NEXT(); \
+        BC_OP(J##name##K)   if ( R[pc->a] cmp pc->b ) BC_JUMP(pc->c); BC_NEXT();
+        BC_JCMP(Eq, ==)
+        BC_JCMP(Ne, !=)
+        BC_JCMP(Lt, <)
+        BC_JCMP(Le, <=)
+        BC_JCMP(Gt, >)
+        BC_JCMP(Ge, >=)
+#undef BC_JCMP
+        // range loop, counter is in a, range end is in a+1. same as SimNode_ForRange, the loop ends when counter hits the end
+        BC_OP(ForNext) {
+            int32_t i = R[pc->a] = int32_t(uint32_t(R[pc->a]) + 1u);
+            if ( i != R[pc->a+1] ) {
+                R[pc->c] = i;
+                BC_JUMP(pc->b);
+            }
+        } BC_NEXT();
+        BC_OP(Call) {
+            const BcCall & cs = calls[pc->b];
+            SimFunction * fn = context.getFunction(cs.fnIndex);
+            int32_t res;
+            if ( fn->bytecode ) {
+                // bytecode to bytecode call skips the tree interpreter altogether. registers of the callee are filled directly,
+                // boxed arguments are only there for the stack walk
+                auto callee = (SimNode_Bytecode *) fn->code;
+                char * EP, * SP;
+                if ( !context.stack.push(fn->stackSize, EP, SP) ) {
+                    context.throw_error_at(cs.at, "stack overflow while calling %s", fn->mangledName);
+                }
+                char * frame = context.stack.sp();
+                int32_t * CR = callee->frameRegisters(frame);
+                for ( int32_t i=0; i!=cs.argCount; ++i ) {
+                    CR[i] = R[cs.argStart + i];
+                }
+#if DAS_ENABLE_STACK_WALK
+                vec4f * CA = frameArguments(frame);
+                for ( int32_t i=0; i!=cs.argCount; ++i ) {
+                    CA[i] = cast<int32_t>::from(CR[i]);
+                }
+                Prologue * pp = (Prologue *) frame;
+                pp->info = fn->debugInfo;
+                pp->arguments = CA;
+                pp->cmres = nullptr;
+                pp->line = (LineInfo *) &cs.at;
+#endif
+                res = callee->run(context, CR);
+                context.stack.pop(EP, SP);
+            } else {
+                int32_t value = cast<int32_t>::to(callTree(context, cs, fn, R));
+                res = cs.boolResult ? int32_t(value!=0) : value;
+            }
+            if ( pc->a >= 0 ) {
+                R[pc->a] = res;
+            }
+        } BC_NEXT();
+        BC_OP(Ret)
+            return R[pc->a];
+        BC_OP(RetVoid)
+            return 0;
+#if !DAS_BYTECODE_THREADED
+        default:
+            DAS_ASSERTF(0, "unsupported bytecode instruction");
+            return 0;
+        }
+#endif
+#undef BC_OP
+#undef BC_NEXT
+#undef BC_JUMP
+    }
+#if DAS_BYTECODE_THREADED
+#pragma GCC diagnostic pop
+#endif
+}
@@ -8,6 +8,7 @@
 #include "daScript/simulate/simulate_fusion.h"
 #include "daScript/simulate/sim_policy.h"
 #include "daScript/simulate/simulate_visit_op.h"
+#include "daScript/misc/job_que.h"
 
 namespace das {
 
@@ -70,6 +71,9 @@ namespace das {
         }
     }
 
+    thread_local bool FusionPointOp2::anyLeft = false;
+    thread_local bool FusionPointOp2::anyRight = false;
+
     SimNode * FusionPointOp2::fuseOp2(const SimNodeInfoLookup & info, SimNode * node, SimNode * node_l, SimNode * node_r, Context * context) {
         anyLeft = anyRight = false;
         SimNode_Op2Fusion * result = (SimNode_Op2Fusion *) match(info,node,node_l,node_r,context);
@@ -152,6 +156,7 @@ namespace das {
             createFusionEngine_call1();
             createFusionEngine_call2();
 #endif
+            createFusionEngine_profiled();
         }
     }
 
@@ -182,12 +187,15 @@ namespace das {
         }
         virtual SimNode * visit ( SimNode * node ) override {
             auto & ni = info[node];
-            auto & nv = (*g_fusionEngine)[fuseName(ni.name, ni.typeName)];
-            for ( const auto & fe : nv ) {
-                auto newNode = fe->fuse(info, node, context);
-                if ( newNode != node ) {
-                    fuse();
-                    return newNode;
+            // engine is shared by the workers, lookup must not insert
+            auto it = g_fusionEngine->find(fuseName(ni.name, ni.typeName));
+            if ( it != g_fusionEngine->end() ) {
+                for ( const auto & fe : it->second ) {
+                    auto newNode = fe->fuse(info, node, context);
+                    if ( newNode != node ) {
+                        fuse();
+                        return newNode;
+                    }
                 }
             }
             return SimVisitor::visit(node);
@@ -198,30 +206,67 @@ namespace das {
         das_hash_map<SimNode *,SimNodeInfo> & info;
     };
 
+    // fuses until there is nothing left to fuse. what gets fused in one tree does not depend on the others
+    static SimNode * fuseTree ( SimNode * node, Context * context, TextWriter & logs ) {
+        for ( ;; ) {
+            SimNodeCollector collector;
+            node->visit(collector);
+            SimFusion fuse(context, logs, move(collector.info));
+            node = node->visit(fuse);
+            if ( !fuse.fused ) return node;
+        }
+    }
+
     void Program::fusion ( Context & context, TextWriter & logs ) {
         // log all functions
         if ( options.getBoolOption("fusion",true) ) {
-            bool anyFusion = true;
-            while ( anyFusion) {
-                anyFusion = false;
-                for ( int g=0; g!=context.totalVariables; ++g ) {
-                    GlobalVariable * var = context.globalVariables + g;
-                    if ( var->init ) {
-                        SimNodeCollector collector;
-                        var->init->visit(collector);
-                        SimFusion fuse(&context, logs, move(collector.info));
-                        var->init = var->init->visit(fuse);
-                        anyFusion |= fuse.fused;
-                    }
+            createFusionEngine();
+            for ( int g=0; g!=context.totalVariables; ++g ) {
+                GlobalVariable * var = context.globalVariables + g;
+                if ( var->init ) {
+                    var->init = fuseTree(var->init, &context, logs);
                 }
-                for ( int i=0; i!=context.totalFunctions; ++i ) {
+            }
+            const int minFunctionsPerWorker = 128;
+            int numWorkers = 1;
+            int compileThreads = options.getIntOption("compile_threads", int(policies.compile_threads));
+            if ( compileThreads>1 ) {
+                numWorkers = das::min(compileThreads, context.totalFunctions / minFunctionsPerWorker);
+            }
+            atomic<int> nextFunction(0);
+            auto fuseFunctions = [&]( Context * ctx ) {
+                for ( ;; ) {
+                    int i = nextFunction++;
+                    if ( i>=context.totalFunctions ) break;
                     SimFunction * fn = context.getFunction(i);
-                    SimNodeCollector collector;
-                    fn->code->visit(collector);
-                    SimFusion fuse(&context, logs, move(collector.info));
-                    fn->code = fn->code->visit(fuse);
-                    anyFusion |= fuse.fused;
+                    fn->code = fuseTree(fn->code, ctx, logs);
+                }
+            };
+            if ( numWorkers<=1 ) {
+                fuseFunctions(&context);
+                return;
+            }
+            // fusion only touches the nodes of the function it fuses, and allocates new ones. every worker allocates
+            // in the code of its own context, which is merged into ours. relocateCode copies it all into one page
+            vector<unique_ptr<Context>> workers;
+            for ( int w=1; w!=numWorkers; ++w ) {
+                workers.push_back(make_unique<Context>(0));
+            }
+            {
+                JobQue que(numWorkers-1);
+                JobStatus status(numWorkers-1);
+                for ( auto & worker : workers ) {
+                    Context * ctx = worker.get();
+                    que.push([&,ctx]() {
+                        fuseFunctions(ctx);
+                        status.Notify();
+                    }, 0, JobPriority::Default);
                 }
+                fuseFunctions(&context);
+                status.Wait();
+            }
+            for ( auto & worker : workers ) {
+                context.code->adopt(*worker->code);
             }
         }
     }
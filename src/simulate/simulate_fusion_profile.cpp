@@ -0,0 +1,310 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/simulate/simulate_fusion.h"
+#include "daScript/simulate/simulate_fusion_profile.h"
+#include "daScript/simulate/simulate_visit_op.h"
+
+namespace das {
+
+    // counts how many times the node it wraps is evaluated, for its pair with the parent and for its own triple
+    struct SimNode_FusionProfile : SimNode {
+        SimNode_FusionProfile ( SimNode * se, uint64_t * pc, uint64_t * tc )
+            : SimNode(se->debugInfo), subexpr(se), pairCount(pc), tripleCount(tc) {}
+        virtual SimNode * visit ( SimVisitor & vis ) override;
+        __forceinline void count() {
+            if ( pairCount ) (*pairCount) ++;
+            if ( tripleCount ) (*tripleCount) ++;
+        }
+        virtual vec4f eval ( Context & context ) override {
+            count();
+            return subexpr->eval(context);
+        }
+#define EVAL_NODE(TYPE,CTYPE)\
+        virtual CTYPE eval##TYPE ( Context & context ) override {   \
+            count();                                                \
+            return subexpr->eval##TYPE(context);                    \
+        }
+        DAS_EVAL_NODE
+#undef EVAL_NODE
+        SimNode *   subexpr;
+        uint64_t *  pairCount;
+        uint64_t *  tripleCount;
+    };
+
+    SimNode * SimNode_FusionProfile::visit ( SimVisitor & vis ) {
+        V_BEGIN();
+        V_OP(FusionProfile);
+        V_SUB(subexpr);
+        V_END();
+    }
+
+    // wraps every node which reports its name, bottom up. by the time the node is done, names of its children are known
+    struct SimFusionProfileInstrument : SimVisitor {
+        struct Frame {
+            SimNode *       node = nullptr;
+            bool            named = false;
+            string          name, typeName;
+            const char *    slot = "";
+            vector<pair<string,string>> children;
+        };
+        SimFusionProfileInstrument ( Context * ctx, FusionProfile & prof ) : context(ctx), profile(prof) {}
+        virtual void preVisit ( SimNode * node ) override {
+            SimVisitor::preVisit(node);
+            frames.emplace_back();
+            frames.back().node = node;
+        }
+        virtual void op ( const char * name, uint32_t, const string & typeName ) override {
+            if ( frames.empty() ) return;
+            auto & fr = frames.back();
+            if ( !fr.named ) {
+                fr.named = true;
+                fr.name = name;
+                fr.typeName = typeName;
+            }
+        }
+        virtual SimNode * sub ( SimNode * node, const char * opN ) override {
+            if ( !frames.empty() ) frames.back().slot = opN;
+            return SimVisitor::sub(node, opN);
+        }
+        virtual void sub ( SimNode ** nodes, uint32_t count, const char * opN ) override {
+            if ( !frames.empty() ) frames.back().slot = opN;
+            SimVisitor::sub(nodes, count, opN);
+        }
+        virtual SimNode * visit ( SimNode * node ) override {
+            // nodes which do not report themselves are left as is
+            auto it = find_if(frames.rbegin(), frames.rend(), [&](const Frame & fr) { return fr.node==node; });
+            if ( it==frames.rend() ) return node;
+            frames.erase(it.base(), frames.end());
+            Frame self = move(frames.back());
+            frames.pop_back();
+            if ( !self.named ) return node;
+            uint64_t * pc = nullptr;
+            uint64_t * tc = nullptr;
+            if ( !frames.empty() ) {
+                auto & parent = frames.back();
+                parent.children.emplace_back(self.name, self.typeName);
+                if ( parent.named ) {
+                    pc = profile.pair(parent.name, parent.typeName, parent.slot, self.name, self.typeName);
+                }
+            }
+            if ( self.children.size()==2 ) {
+                auto & ch = self.children;
+                tc = profile.triple(self.name, self.typeName, ch[0].first, ch[0].second, ch[1].first, ch[1].second);
+            }
+            if ( !pc && !tc ) return node;
+            return context->code->makeNode<SimNode_FusionProfile>(node, pc, tc);
+        }
+        Context *       context = nullptr;
+        FusionProfile & profile;
+        vector<Frame>   frames;
+    };
+
+    void Program::profileFusion ( Context & context, TextWriter & ) {
+        if ( !options.getBoolOption("profile_fusion", policies.profile_fusion) ) return;
+        SimFusionProfileInstrument instrument(&context, getFusionProfile());
+        for ( int g=0; g!=context.totalVariables; ++g ) {
+            GlobalVariable * var = context.globalVariables + g;
+            if ( var->init ) {
+                var->init = var->init->visit(instrument);
+            }
+        }
+        for ( int i=0; i!=context.totalFunctions; ++i ) {
+            SimFunction * fn = context.getFunction(i);
+            // bytecode calls bytecode directly, its code has to stay SimNode_Bytecode
+            if ( !fn->code || fn->bytecode ) continue;
+            fn->code = fn->code->visit(instrument);
+        }
+    }
+
+    uint64_t * FusionProfile::getCounter ( const string & key, Entry && entry ) {
+        lock_guard<mutex> guard(lock);
+        auto it = lookup.find(key);
+        if ( it!=lookup.end() ) return &it->second->count;
+        entries.push_back(move(entry));
+        lookup[key] = &entries.back();
+        return &entries.back().count;
+    }
+
+    uint64_t * FusionProfile::pair ( const string & op, const string & typeName, const string & slot,
+            const string & child, const string & childType ) {
+        string key = fuseName(op, typeName) + "." + slot + ":" + fuseName(child, childType);
+        Entry entry;
+        entry.op = op;
+        entry.typeName = typeName;
+        entry.slot = slot;
+        entry.lname = child;
+        entry.ltype = childType;
+        return getCounter(key, move(entry));
+    }
+
+    uint64_t * FusionProfile::triple ( const string & op, const string & typeName,
+            const string & lname, const string & ltype, const string & rname, const string & rtype ) {
+        string key = fuseName(op, typeName) + "(" + fuseName(lname, ltype) + "," + fuseName(rname, rtype) + ")";
+        Entry entry;
+        entry.op = op;
+        entry.typeName = typeName;
+        entry.lname = lname;
+        entry.ltype = ltype;
+        entry.rname = rname;
+        entry.rtype = rtype;
+        entry.triple = true;
+        return getCounter(key, move(entry));
+    }
+
+    void FusionProfile::reset() {
+        lock_guard<mutex> guard(lock);
+        for ( auto & entry : entries ) {
+            entry.count = 0;
+        }
+    }
+
+    vector<const FusionProfile::Entry *> FusionProfile::sorted ( bool triples, uint64_t minCount ) const {
+        vector<const Entry *> res;
+        for ( const auto & entry : entries ) {
+            if ( entry.triple==triples && entry.count && entry.count>=minCount ) {
+                res.push_back(&entry);
+            }
+        }
+        stable_sort(res.begin(), res.end(), [](const Entry * a, const Entry * b) { return a->count > b->count; });
+        return res;
+    }
+
+    void FusionProfile::writeReport ( TextWriter & tout, uint64_t minCount ) const {
+        lock_guard<mutex> guard(lock);
+        tout << "// pairs\n";
+        for ( auto entry : sorted(false, minCount) ) {
+            tout << entry->count << "\t" << fuseName(entry->op, entry->typeName) << "." << entry->slot
+                << " -> " << fuseName(entry->lname, entry->ltype) << "\n";
+        }
+        tout << "// triples\n";
+        for ( auto entry : sorted(true, minCount) ) {
+            tout << entry->count << "\t" << fuseName(entry->op, entry->typeName)
+                << " ( " << fuseName(entry->lname, entry->ltype) << ", " << fuseName(entry->rname, entry->rtype) << " )\n";
+        }
+    }
+
+    // operand nodes, and how op2 superinstructions compute them (see MATCH_OP2 in simulate_fusion_op2_impl.h)
+    static const char * fusionOperandCompute ( const string & name ) {
+        static const char * operands[][2] = {
+            { "GetLocalR2V",                "Local" },
+            { "GetLocalRefOffR2V",          "LocalRefOff" },
+            { "GetArgument",                "Argument" },
+            { "GetArgumentRefOffR2V",       "ArgumentRefOff" },
+            { "GetThisBlockArgument",       "ThisBlockArgument" },
+            { "GetThisBlockArgumentR2V",    "ThisBlockArgumentRef" },
+            { "ConstValue",                 "Const" },
+        };
+        for ( const auto & op : operands ) {
+            if ( name==op[0] ) return op[1];
+        }
+        return nullptr;
+    }
+
+    // op2 nodes with policy implementation, which fusion can replace (see simulate_fusion_op2*.cpp)
+    static bool fusionOp2Type ( const string & op, const string & typeName, const char * & TYPE, const char * & CTYPE ) {
+        static const char * types[][3] = {      // typeName, TYPE, CTYPE
+            { "int",    "Int",      "int32_t" },
+            { "uint",   "UInt",     "uint32_t" },
+            { "int64",  "Int64",    "int64_t" },
+            { "uint64", "UInt64",   "uint64_t" },
+            { "float",  "Float",    "float" },
+            { "double", "Double",   "double" },
+            { "bool",   "Bool",     "bool" },
+        };
+        static const char * numericOps[] = { "Add", "Sub", "Mul", "Div", "Mod", "Equ", "NotEqu", "LessEqu", "GtEqu", "Gt", "Less" };
+        static const char * integerOps[] = { "BinAnd", "BinOr", "BinXor", "BinShl", "BinShr", "BinRotl", "BinRotr" };
+        int ti = -1;
+        for ( int t=0; t!=7; ++t ) {
+            if ( typeName==types[t][0] ) ti = t;
+        }
+        if ( ti==-1 ) return false;
+        bool ok = false;
+        if ( ti==6 ) {
+            ok = (op=="Equ" || op=="NotEqu");
+        } else {
+            for ( auto nop : numericOps ) ok |= op==nop;
+            if ( ti<=3 ) {
+                for ( auto iop : integerOps ) ok |= op==iop;
+            }
+        }
+        if ( !ok ) return false;
+        TYPE = types[ti][1];
+        CTYPE = types[ti][2];
+        return true;
+    }
+
+    void FusionProfile::writeFusionSource ( TextWriter & tout, uint64_t minCount ) const {
+        lock_guard<mutex> guard(lock);
+        struct Point {
+            string op, typeName;
+            const char * TYPE = nullptr;
+            const char * CTYPE = nullptr;
+            vector<const Entry *> matches;
+        };
+        vector<Point> points;
+        das_hash_map<string,size_t> pointIndex;
+        for ( auto entry : sorted(true, minCount) ) {
+            const char * TYPE, * CTYPE;
+            if ( !fusionOp2Type(entry->op, entry->typeName, TYPE, CTYPE) ) continue;
+            if ( !fusionOperandCompute(entry->lname) || !fusionOperandCompute(entry->rname) ) continue;
+            auto key = fuseName(entry->op, entry->typeName);
+            auto it = pointIndex.find(key);
+            if ( it==pointIndex.end() ) {
+                it = pointIndex.insert(make_pair(key, points.size())).first;
+                points.emplace_back();
+                auto & pt = points.back();
+                pt.op = entry->op;
+                pt.typeName = entry->typeName;
+                pt.TYPE = TYPE;
+                pt.CTYPE = CTYPE;
+            }
+            points[it->second].matches.push_back(entry);
+        }
+        tout << "// generated from the fusion profile (options profile_fusion), do not edit\n"
+            << "// hot op2 nodes, which fusion engine left as is, with the operand combinations seen at run time\n\n"
+            << "#include \"daScript/misc/platform.h\"\n\n"
+            << "#ifdef _MSC_VER\n#pragma warning(disable:4505)\n#endif\n\n"
+            << "#include \"daScript/simulate/simulate_fusion.h\"\n"
+            << "#include \"daScript/simulate/sim_policy.h\"\n"
+            << "#include \"daScript/ast/ast.h\"\n"
+            << "#include \"daScript/simulate/simulate_fusion_op2.h\"\n\n"
+            << "namespace das {\n\n";
+        for ( const auto & pt : points ) {
+            tout << "    struct FusionPoint_Profiled_" << pt.op << "_" << pt.CTYPE << " : FusionPointOp2 {\n";
+            for ( auto entry : pt.matches ) {
+                tout << "        IMPLEMENT_OP2_NODE(__forceinline," << pt.op << "," << pt.TYPE << "," << pt.CTYPE << ","
+                    << fusionOperandCompute(entry->lname) << "," << fusionOperandCompute(entry->rname) << ");\n";
+            }
+            tout << "        virtual SimNode * match(const SimNodeInfoLookup & info, SimNode *, SimNode * node_l, SimNode * node_r, Context * context) override {\n"
+                << "            auto & ccode = *(context->code);\n"
+                << "            /* match op2 */ if ( !node_l || !node_r ) { return nullptr; }\n";
+            for ( auto entry : pt.matches ) {
+                tout << "            MATCH_OP2(" << pt.op << ",\"" << entry->lname << "\",\"" << entry->rname << "\","
+                    << fusionOperandCompute(entry->lname) << "," << fusionOperandCompute(entry->rname) << ")"
+                    << "    // " << entry->count << "\n";
+            }
+            tout << "            return nullptr;\n"
+                << "        }\n"
+                << "        virtual void set(SimNode_Op2Fusion * result, SimNode * node) override {\n"
+                << "            result->set(\"" << pt.op << "\",Type(ToBasicType<" << pt.CTYPE << ">::type),node->debugInfo);\n"
+                << "        }\n"
+                << "        virtual SimNode * fuse(const SimNodeInfoLookup & info, SimNode * node, Context * context) override {\n"
+                << "            return fuseOp2(info, node, FUSION_OP2_SUBEXPR_LEFT(" << pt.CTYPE << ",node), FUSION_OP2_SUBEXPR_RIGHT("
+                    << pt.CTYPE << ",node), context);\n"
+                << "        }\n"
+                << "    };\n\n";
+        }
+        tout << "    void createFusionEngine_profiled()\n    {\n";
+        for ( const auto & pt : points ) {
+            tout << "        registerFusion(\"" << pt.op << "\",\"" << pt.typeName << "\",new FusionPoint_Profiled_"
+                << pt.op << "_" << pt.CTYPE << "());\n";
+        }
+        tout << "    }\n}\n";
+    }
+
+    FusionProfile & getFusionProfile() {
+        static FusionProfile profile;
+        return profile;
+    }
+}
@@ -0,0 +1,13 @@
+// generated from the fusion profile (options profile_fusion), do not edit
+// empty until it is regenerated with FusionProfile::writeFusionSource, i.e. daScript -fusion_profile <file>
+
+#include "daScript/misc/platform.h"
+
+#include "daScript/simulate/simulate_fusion.h"
+
+namespace das {
+
+    void createFusionEngine_profiled()
+    {
+    }
+}
@@ -2,35 +2,28 @@
 
 #include "daScript/simulate/simulate.h"
 #include "daScript/simulate/data_walker.h"
+#include "daScript/misc/performance_time.h"
 
 namespace das
 {
+    using loop_point = pair<char *,uint32_t>;
+
+    struct LoopPointHash {
+        __forceinline size_t operator() ( const loop_point & p ) const {
+            return hash<uintptr_t>()(uintptr_t(p.first)) ^ (size_t(p.second) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    // every structure or handle is visited once, regardless of how many times its referenced
+    typedef das_hash_set<loop_point,LoopPointHash,equal_to<loop_point>> das_visited_set;
+
     struct GcMarkStringHeap : DataWalker {
-        Context * context = nullptr;
-        using loop_point = pair<void *,uint32_t>;
-        vector<loop_point> visited;
-        vector<loop_point> visited_handles;
+        das_visited_set visited;
         virtual bool canVisitStructure ( char * ps, StructInfo * info ) override {
-            return find_if(visited.begin(),visited.end(),[&]( const loop_point & t ){
-                    return t.first==ps && t.second==info->hash;
-                }) == visited.end();
+            return visited.insert(make_pair(ps,info->hash)).second;
         }
         virtual bool canVisitHandle ( char * ps, TypeInfo * info ) override {
-            return find_if(visited.begin(),visited.end(),[&]( const loop_point & t ){
-                    return t.first==ps && t.second==info->hash;
-                }) == visited.end();
-        }
-        virtual void beforeStructure ( char * ps, StructInfo * info ) override {
-            visited.emplace_back(make_pair(ps,info->hash));
-        }
-        virtual void afterStructure ( char *, StructInfo * ) override {
-            visited.pop_back();
-        }
-        virtual void beforeHandle ( char * ps, TypeInfo * ti ) override {
-            visited_handles.emplace_back(make_pair(ps,ti->hash));
-        }
-        virtual void afterHandle ( char *, TypeInfo * ) override {
-            visited_handles.pop_back();
+            return visited.insert(make_pair(ps,info->hash)).second;
         }
         virtual void String ( char * & st ) override {
             DataWalker::String(st);
@@ -40,22 +33,106 @@ namespace das
             if ( context->constStringHeap->isOwnPtr(st) ) {     // not a const string
                 return;
             }
+            if ( context->stringHeap->isHeader() ) {            // allocation starts at the header
+                if ( auto hdr = context->stringHeap->header(st) ) {
+                    context->stringHeap->mark((char *)hdr, uint32_t(sizeof(StringHeader)) + hdr->size + 1);
+                }
+                return;
+            }
             uint32_t len = uint32_t(strlen(st)) + 1;
             len = (len + 15) & ~15;
             context->stringHeap->mark(st, len);
         }
     };
 
-    void Context::collectStringHeap ( LineInfo * at ) {
-        // clean up, so that all small allocations are marked as 'free'
-        if ( !stringHeap->mark() ) return;
-        // now
-        GcMarkStringHeap walker;
-        walker.context = this;
+    // collects every live allocation of the heap and the string heap. typed data is walked precisely,
+    // everything else (void pointers, iterators, the stack) is scanned conservatively, one pointer sized word at a time.
+    // marking itself happens after the walk, since locate relies on the allocation bits being intact
+    struct GcMarkHeap : DataWalker {
+        das_visited_set                 visited;
+        das_hash_map<void *,uint32_t>   heapLive;
+        das_hash_map<void *,uint32_t>   stringLive;
+        das_hash_set<void *>            scanned;
+        vector<loop_point>              scanQueue;
+        void addHeap ( char * ptr, bool conservative ) {
+            if ( !ptr ) return;
+            uint32_t size = 0;
+            char * start = context->heap->locate(ptr, size);
+            if ( !start ) return;
+            heapLive[start] = size;
+            if ( conservative && scanned.insert(start).second ) {
+                scanQueue.emplace_back(start, size);
+            }
+        }
+        void addString ( char * ptr ) {
+            if ( !ptr ) return;
+            uint32_t size = 0;
+            if ( char * start = context->stringHeap->locate(ptr, size) ) {
+                stringLive[start] = size;
+            }
+        }
+        void scan ( char * data, uint32_t size ) {
+            char ** words = (char **) data;
+            for ( uint32_t i=0, count=size/uint32_t(sizeof(char *)); i!=count; ++i ) {
+                addHeap(words[i], true);
+                addString(words[i]);
+            }
+        }
+        void drain() {
+            while ( !scanQueue.empty() ) {
+                auto lp = scanQueue.back();
+                scanQueue.pop_back();
+                scan(lp.first, lp.second);
+            }
+        }
+        virtual bool canVisitStructure ( char * ps, StructInfo * info ) override {
+            return visited.insert(make_pair(ps,info->hash)).second;
+        }
+        virtual bool canVisitHandle ( char * ps, TypeInfo * info ) override {
+            return visited.insert(make_pair(ps,info->hash)).second;
+        }
+        virtual void walk_struct ( char * ps, StructInfo * si ) override {
+            // class instance can be bigger than the type it is pointed to by, actual class is in the rtti
+            if ( si->count && si->fields[0]->name && strcmp(si->fields[0]->name,"__rtti")==0 ) {
+                auto rtti = *(TypeInfo **)ps;
+                if ( rtti && rtti->structType ) {
+                    si = rtti->structType;
+                }
+            }
+            DataWalker::walk_struct(ps, si);
+        }
+        virtual void beforeArray ( Array * pa, TypeInfo * ) override {
+            addHeap(pa->data, false);
+        }
+        virtual void beforeTable ( Table * tab, TypeInfo * ) override {
+            addHeap(tab->data, false);
+            if ( tab->rehashing ) addHeap(table_rehash(*tab)->oldData, false);
+        }
+        virtual void beforePtr ( char * pa, TypeInfo * ti ) override {
+            char * ptr = *(char **)pa;
+            if ( ti->firstType ) {
+                addHeap(ptr, false);
+            } else {
+                addHeap(ptr, true);
+                addString(ptr);
+            }
+        }
+        virtual void beforeLambda ( Lambda * ll, TypeInfo * ) override {
+            addHeap(ll->capture, false);
+        }
+        virtual void beforeIterator ( Sequence * seq, TypeInfo * ) override {
+            addHeap((char *)seq->iter, true);
+        }
+        virtual void String ( char * & st ) override {
+            addString(st);
+        }
+    };
+
+    void Context::walkGcRoots ( DataWalker & walker, LineInfo * at ) {
         // mark globals
         for ( int i=0; i!=totalVariables; ++i ) {
             auto & pv = globalVariables[i];
-            walker.walk(globals + pv.offset, pv.debugInfo);
+            walker.walk((pv.shared ? shared : globals) + pv.offset, pv.debugInfo);
         }
         // mark stack
         char * sp = stack.ap();
@@ -101,8 +178,46 @@ namespace das
             lineAt = info ? pp->line : nullptr;
             sp += info ? info->stackSize : pp->stackSize;
         }
+    }
+
+    void Context::collectStringHeap ( LineInfo * at ) {
+        // clean up, so that all small allocations are marked as 'free'
+        if ( !stringHeap->mark() ) return;
+        // now
+        GcMarkStringHeap walker;
+        walker.context = this;
+        walkGcRoots(walker, at);
         // sweep
         stringHeap->sweep();
     }
-}
 
+    void Context::collectHeap ( LineInfo * at, bool collectStrings ) {
+        auto t0 = ref_time_ticks();
+        GcMarkHeap walker;
+        walker.context = this;
+        walkGcRoots(walker, at);
+        // temporary values, and locals without debug info only live on the stack
+        walker.scan(stack.ap(), uint32_t(stack.top() - stack.ap()));
+        walker.drain();
+        // now that we know what is alive, we can mark
+        if ( heap->mark() ) {
+            auto before = heap->bytesAllocated();
+            for ( auto & it : walker.heapLive ) {
+                heap->mark((char *)it.first, it.second);
+            }
+            heap->sweep();
+            gcStats.heapBytesFreed += before - heap->bytesAllocated();
+        }
+        if ( collectStrings && stringHeap->mark() ) {
+            auto before = stringHeap->bytesAllocated();
+            for ( auto & it : walker.stringLive ) {
+                stringHeap->mark((char *)it.first, it.second);
+            }
+            stringHeap->sweep();
+            gcStats.stringBytesFreed += before - stringHeap->bytesAllocated();
+        }
+        gcStats.collections ++;
+        gcStats.lastUsec = get_time_usec(t0);
+        gcStats.totalUsec += gcStats.lastUsec;
+    }
+}
@@ -1,16 +1,20 @@
 #include "daScript/daScript.h"
 #include "daScript/simulate/fs_file_info.h"
+#include "daScript/simulate/simulate_fusion_profile.h"
 
 using namespace das;
 
 TextPrinter tout;
 
 bool pauseAfterErrors = false;
+string fusionProfileFile;
 
 void compile_and_run ( const string & fn, const string & mainFnName, bool outputProgramCode ) {
     auto access = make_smart<FsFileAccess>();
     ModuleGroup dummyGroup;
-    if ( auto program = compileDaScript(fn,access,tout,dummyGroup) ) {
+    CodeOfPolicies policies;
+    policies.profile_fusion = !fusionProfileFile.empty();
+    if ( auto program = compileDaScript(fn,access,tout,dummyGroup,false,policies) ) {
         if ( program->failed() ) {
             for ( auto & err : program->errors ) {
                 tout << reportError(err.at, err.what, err.extra, err.fixme, err.cerr );
@@ -34,7 +38,7 @@ void compile_and_run ( const string & fn, const string & mainFnName, bool output
 }
 
 void print_help() {
-    tout << "daScript scriptName1 {scriptName2} .. {-main mainFnName} {-log}\n";
+    tout << "daScript scriptName1 {scriptName2} .. {-main mainFnName} {-log} {-fusion_profile fusionPoints.cpp}\n";
 }
 
 void require_project_specific_modules();//link time resolved dependencies
@@ -64,6 +68,13 @@ int main(int argc, char * argv[]) {
                 }
                 mainName = argv[i+1];
                 i += 1;
+            } else if ( cmd=="fusion_profile" ) {
+                if ( i+1 >= argc ) {
+                    print_help();
+                    return -1;
+                }
+                fusionProfileFile = argv[i+1];
+                i += 1;
             } else if ( cmd=="log" ) {
                 outputProgramCode = true;
             } else if ( cmd=="args" ) {
@@ -96,6 +107,8 @@ int main(int argc, char * argv[]) {
     NEED_MODULE(Module_Network);
     NEED_MODULE(Module_UriParser);
     NEED_MODULE(Module_JobQue);
+    NEED_MODULE(Module_JsonNative);
+    NEED_MODULE(Module_RegexNative);
     NEED_MODULE(Module_FIO);
     require_project_specific_modules();
     #include "modules/external_need.inc"
@@ -104,6 +117,19 @@ int main(int argc, char * argv[]) {
     for ( const auto & fn : files ) {
         compile_and_run(fn, mainName, outputProgramCode);
     }
+    // pairs and triples, which were left after fusion, and fusion points for them
+    if ( !fusionProfileFile.empty() ) {
+        getFusionProfile().writeReport(tout);
+        TextWriter source;
+        getFusionProfile().writeFusionSource(source);
+        if ( FILE * f = fopen(fusionProfileFile.c_str(), "wb") ) {
+            auto text = source.str();
+            fwrite(text.c_str(), 1, text.size(), f);
+            fclose(f);
+        } else {
+            tout << "can't write " << fusionProfileFile << "\n";
+        }
+    }
     // and done
     if ( pauseAfterDone ) getchar();
     Module::Shutdown();